@@ -0,0 +1,441 @@
+#include "stdafx.h"
+#include "asset_cooker.h"
+#include "vertex_compression.h"
+#include "mesh_optimizer.h"
+#include "meshlets.h"
+#include "mesh_lod.h"
+
+#include <algorithm>
+
+void ConvertIndices16 (
+    UINT const * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    PackLod * lods,
+    std::vector<UINT16> * indices16,
+    std::vector<UINT> * indices32,
+    IndexConversionStats * stats
+) {
+    indices16->clear();
+    indices32->clear();
+    *stats = {};
+    for (UINT i = 0; i < draw_count; ++i) {
+        PackDraw & draw = draws[i];
+        UINT max_index = 0;
+        for (UINT k = 0; k < draw.index_count; ++k)
+            max_index = std::max(max_index, indices[draw.index_start + k]);
+
+        // NOTE(omid): 0xFFFF is left out, it would cut strips if the
+        // pipeline ever enables the strip cut value
+        bool const narrow = max_index < 0xFFFF;
+        draw.index_format = narrow ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+        if (narrow)
+            ++stats->draws_16;
+        else
+            ++stats->draws_32;
+
+        // -- lods only use the draw's own vertices, so they follow its format
+        auto move_range = [&] (UINT * index_start, UINT index_count) {
+            UINT const * src = indices + *index_start;
+            stats->bytes_before += index_count * sizeof(UINT);
+            if (narrow) {
+                *index_start = static_cast<UINT>(indices16->size());
+                for (UINT k = 0; k < index_count; ++k)
+                    indices16->push_back(static_cast<UINT16>(src[k]));
+                stats->bytes_after += index_count * sizeof(UINT16);
+            } else {
+                *index_start = static_cast<UINT>(indices32->size());
+                indices32->insert(indices32->end(), src, src + index_count);
+                stats->bytes_after += index_count * sizeof(UINT);
+            }
+        };
+        move_range(&draw.index_start, draw.index_count);
+        for (UINT l = 0; l < draw.lod_count; ++l)
+            move_range(&lods[draw.lod_start + l].index_start, lods[draw.lod_start + l].index_count);
+    }
+}
+HRESULT LayoutTexturesForUpload (
+    UINT8 const * texels,
+    SampleAssets::TextureResource * textures,
+    UINT texture_count,
+    std::vector<UINT8> * texture_data
+) {
+    auto align_up = [] (UINT64 value, UINT64 alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    };
+    // -- first pass places every mip, second copies the rows
+    std::vector<SampleAssets::TextureResource> placed(textures, textures + texture_count);
+    UINT64 source_size = 0;
+    UINT64 cursor = 0;
+    for (UINT i = 0; i < texture_count; ++i) {
+        for (UINT m = 0; m < placed[i].MipLevels; ++m) {
+            SampleAssets::TextureResource::DataProperties const & src = textures[i].Data[m];
+            SampleAssets::TextureResource::DataProperties & dst = placed[i].Data[m];
+            if (0 == src.Pitch || 0 != src.Size % src.Pitch)
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+            UINT64 const pitch = align_up(src.Pitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            cursor = align_up(cursor, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            dst.Offset = static_cast<UINT>(cursor);
+            dst.Pitch = static_cast<UINT>(pitch);
+            dst.Size = static_cast<UINT>(pitch * (src.Size / src.Pitch - 1) + src.Pitch);
+            cursor += dst.Size;
+            source_size += src.Size;
+            if (cursor > UINT_MAX)
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+    }
+    texture_data->assign(static_cast<size_t>(cursor), 0);
+    for (UINT i = 0; i < texture_count; ++i) {
+        for (UINT m = 0; m < placed[i].MipLevels; ++m) {
+            SampleAssets::TextureResource::DataProperties const & src = textures[i].Data[m];
+            SampleAssets::TextureResource::DataProperties const & dst = placed[i].Data[m];
+            for (UINT row = 0; row < src.Size / src.Pitch; ++row)
+                memcpy(
+                    texture_data->data() + dst.Offset + UINT64(row) * dst.Pitch,
+                    texels + src.Offset + UINT64(row) * src.Pitch,
+                    src.Pitch
+                );
+        }
+        textures[i] = placed[i];
+    }
+
+    char message[256];
+    sprintf_s(
+        message,
+        "cooker: texture data %llu -> %llu bytes in upload layout\n",
+        source_size, cursor
+    );
+    OutputDebugStringA(message);
+    return S_OK;
+}
+HRESULT CookLegacyAssets (
+    UINT8 const * legacy_data,
+    UINT legacy_size,
+    PackSource const & source,
+    std::vector<UINT8> * pack
+) {
+    // -- make sure the raw file actually matches the compiled-in layout
+    if (
+        legacy_size < SampleAssets::VertexDataOffset + SampleAssets::VertexDataSize ||
+        legacy_size < SampleAssets::IndexDataOffset + SampleAssets::IndexDataSize
+    ) {
+        return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    }
+    for (UINT i = 0; i < ArrayCount(SampleAssets::Textures); ++i) {
+        SampleAssets::TextureResource const & tex = SampleAssets::Textures[i];
+        for (UINT m = 0; m < tex.MipLevels; ++m)
+            if (tex.Data[m].Offset + tex.Data[m].Size > legacy_size)
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    }
+
+    // -- texels start at the beginning of the raw file, offsets are
+    // -- relative to it, repack them as the upload buffer wants them
+    std::vector<SampleAssets::TextureResource> textures(
+        SampleAssets::Textures,
+        SampleAssets::Textures + ArrayCount(SampleAssets::Textures)
+    );
+    std::vector<UINT8> texture_data;
+    {
+        HRESULT const hr = LayoutTexturesForUpload(
+            legacy_data, textures.data(),
+            static_cast<UINT>(textures.size()), &texture_data
+        );
+        if (FAILED(hr))
+            return hr;
+    }
+
+    UINT const index_count = SampleAssets::IndexDataSize / sizeof(UINT);
+    UINT const draw_count = ArrayCount(SampleAssets::Draws);
+    std::vector<PackDraw> draws(draw_count);
+    for (UINT i = 0; i < draw_count; ++i) {
+        SampleAssets::DrawParameters const & src = SampleAssets::Draws[i];
+        if (src.IndexStart + src.IndexCount > index_count)
+            return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        draws[i].diffuse_texture_index = src.DiffuseTextureIndex;
+        draws[i].normal_texture_index = src.NormalTextureIndex;
+        draws[i].specular_texture_index = src.SpecularTextureIndex;
+        draws[i].index_start = src.IndexStart;
+        draws[i].index_count = src.IndexCount;
+        draws[i].vertex_base = src.VertexBase;
+        draws[i].index_format = SampleAssets::StandardIndexFormat;
+        draws[i].meshlet_start = 0;
+        draws[i].meshlet_count = 0;
+        draws[i].lod_start = 0;
+        draws[i].lod_count = 0;
+        for (int c = 0; c < 3; ++c) {
+            draws[i].position_offset[c] = 0.0f;
+            draws[i].position_scale[c] = 1.0f;
+        }
+    }
+
+    // -- the optimizer rewrites both buffers in place, work on copies
+    StandardVertex const * legacy_vertices = reinterpret_cast<StandardVertex const *>(
+        legacy_data + SampleAssets::VertexDataOffset
+    );
+    UINT const vertex_count =
+        SampleAssets::VertexDataSize / sizeof(StandardVertex);
+    UINT const * legacy_indices = reinterpret_cast<UINT const *>(
+        legacy_data + SampleAssets::IndexDataOffset
+    );
+    std::vector<StandardVertex> vertices(legacy_vertices, legacy_vertices + vertex_count);
+    std::vector<UINT> indices(legacy_indices, legacy_indices + index_count);
+    for (UINT i = 0; i < draw_count; ++i)
+        for (UINT k = 0; k < draws[i].index_count; ++k)
+            if (draws[i].vertex_base + indices[draws[i].index_start + k] >= vertex_count)
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+
+    if (CookOptimizeMeshes) {
+        // -- triangles are reordered inside each draw, so no two draws
+        // -- may share indices
+        std::vector<UINT> order(draw_count);
+        for (UINT i = 0; i < draw_count; ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&draws] (UINT a, UINT b) {
+            return draws[a].index_start < draws[b].index_start;
+        });
+        for (UINT i = 1; i < draw_count; ++i) {
+            PackDraw const & prev = draws[order[i - 1]];
+            if (prev.index_start + prev.index_count > draws[order[i]].index_start)
+                return HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+        }
+
+        std::vector<VertexCacheStats> before;
+        std::vector<VertexCacheStats> after;
+        OptimizeMeshes(
+            vertices.data(), vertex_count, indices.data(),
+            draws.data(), draw_count, &before, &after
+        );
+        char message[256];
+        UINT64 triangles = 0;
+        double misses_before = 0.0;
+        double misses_after = 0.0;
+        for (UINT i = 0; i < draw_count; ++i) {
+            sprintf_s(
+                message,
+                "cooker: draw %u (%u triangles) acmr %.3f -> %.3f, atvr %.3f -> %.3f\n",
+                i, draws[i].index_count / 3,
+                before[i].acmr, after[i].acmr, before[i].atvr, after[i].atvr
+            );
+            OutputDebugStringA(message);
+            triangles += draws[i].index_count / 3;
+            misses_before += before[i].acmr * (draws[i].index_count / 3);
+            misses_after += after[i].acmr * (draws[i].index_count / 3);
+        }
+        if (triangles > 0) {
+            sprintf_s(
+                message,
+                "cooker: all draws acmr %.3f -> %.3f (fifo %u)\n",
+                misses_before / triangles, misses_after / triangles, AnalyzeCacheSize
+            );
+            OutputDebugStringA(message);
+        }
+    }
+
+    // -- meshlets follow the optimized triangle order
+    std::vector<PackMeshlet> meshlets;
+    if (CookMeshlets) {
+        std::vector<PackMeshlet> draw_meshlets;
+        UINT split_draws = 0;
+        for (UINT i = 0; i < draw_count; ++i) {
+            PackDraw & draw = draws[i];
+            if (draw.index_count / 3 <= MeshletMaxTriangles)
+                continue;
+            BuildMeshlets(
+                vertices.data() + draw.vertex_base,
+                indices.data() + draw.index_start,
+                draw.index_count, &draw_meshlets
+            );
+            draw.meshlet_start = static_cast<UINT>(meshlets.size());
+            draw.meshlet_count = static_cast<UINT>(draw_meshlets.size());
+            meshlets.insert(meshlets.end(), draw_meshlets.begin(), draw_meshlets.end());
+            ++split_draws;
+        }
+        char message[256];
+        sprintf_s(
+            message,
+            "cooker: %u meshlets for %u of %u draws\n",
+            static_cast<UINT>(meshlets.size()), split_draws, draw_count
+        );
+        OutputDebugStringA(message);
+    }
+
+    for (UINT i = 0; i < draw_count; ++i)
+        BoundingSphere(
+            vertices.data() + draws[i].vertex_base,
+            indices.data() + draws[i].index_start,
+            draws[i].index_count,
+            draws[i].bounds_center, &draws[i].bounds_radius
+        );
+
+    // -- lod indices are appended after the draws' own ranges
+    std::vector<PackLod> lods;
+    if (CookLods) {
+        std::vector<UINT> previous;
+        std::vector<UINT> simplified;
+        UINT64 triangles[MaxLods + 1] = {};
+        for (UINT i = 0; i < draw_count; ++i) {
+            PackDraw & draw = draws[i];
+            triangles[0] += draw.index_count / 3;
+            if (draw.index_count / 3 < MinLodTriangles)
+                continue;
+            draw.lod_start = static_cast<UINT>(lods.size());
+            previous.assign(
+                indices.begin() + draw.index_start,
+                indices.begin() + draw.index_start + draw.index_count
+            );
+            for (UINT l = 0; l < MaxLods; ++l) {
+                UINT const target =
+                    static_cast<UINT>(draw.index_count / 3 * LodTriangleRatios[l]) * 3;
+                PackLod lod = {};
+                lod.error = SimplifyMesh(
+                    vertices.data() + draw.vertex_base,
+                    previous.data(), static_cast<UINT>(previous.size()),
+                    target, LodMaxError * draw.bounds_radius, &simplified
+                );
+                // -- stop once the chain stops paying for itself
+                if (simplified.empty() || simplified.size() * 10 > previous.size() * 9)
+                    break;
+                OptimizeVertexCache(simplified.data(), static_cast<UINT>(simplified.size()));
+                lod.index_start = static_cast<UINT>(indices.size());
+                lod.index_count = static_cast<UINT>(simplified.size());
+                indices.insert(indices.end(), simplified.begin(), simplified.end());
+                lods.push_back(lod);
+                ++draw.lod_count;
+                triangles[l + 1] += lod.index_count / 3;
+                previous.swap(simplified);
+            }
+        }
+        static_assert(MaxLods == 3, "log below prints four levels");
+        char message[256];
+        sprintf_s(
+            message,
+            "cooker: %u lods, triangles lod0 %llu, lod1 %llu, lod2 %llu, lod3 %llu\n",
+            static_cast<UINT>(lods.size()),
+            triangles[0], triangles[1], triangles[2], triangles[3]
+        );
+        OutputDebugStringA(message);
+    }
+
+    std::vector<CompressedVertex> compressed;
+    if (CookCompressedVertices) {
+        CompressVertices(
+            vertices.data(), vertex_count, indices.data(),
+            draws.data(), draw_count, &compressed
+        );
+        CompressionError const error = MeasureCompressionError(
+            vertices.data(), compressed.data(), vertex_count,
+            indices.data(), draws.data(), draw_count
+        );
+        char message[256];
+        sprintf_s(
+            message,
+            "cooker: vertices %u -> %u bytes, max error: "
+            "position %f, normal %f, tangent %f, uv %f\n",
+            SampleAssets::VertexDataSize,
+            static_cast<UINT>(compressed.size() * sizeof(CompressedVertex)),
+            error.position, error.normal, error.tangent, error.uv
+        );
+        OutputDebugStringA(message);
+    }
+
+    // -- last step, everything above works on 32-bit absolute index starts
+    std::vector<UINT16> indices16;
+    std::vector<UINT> indices32;
+    if (CookIndices16) {
+        IndexConversionStats stats;
+        ConvertIndices16(
+            indices.data(), draws.data(), draw_count, lods.data(),
+            &indices16, &indices32, &stats
+        );
+        char message[256];
+        sprintf_s(
+            message,
+            "cooker: 16-bit indices for %u of %u draws, index data %llu -> %llu bytes\n",
+            stats.draws_16, stats.draws_16 + stats.draws_32,
+            stats.bytes_before, stats.bytes_after
+        );
+        OutputDebugStringA(message);
+    } else {
+        indices32.swap(indices);
+    }
+
+    PackWriter writer;
+    if (CookCompressedVertices) {
+        writer.AddSection(
+            PackSectionVertices, PackVertexCompressed,
+            CompressedVertexStride,
+            compressed.data(),
+            compressed.size() * sizeof(CompressedVertex)
+        );
+    } else {
+        writer.AddSection(
+            PackSectionVertices, PackVertexStandard,
+            SampleAssets::StandardVertexStride,
+            vertices.data(),
+            SampleAssets::VertexDataSize
+        );
+    }
+    writer.AddSection(
+        PackSectionIndices, DXGI_FORMAT_R32_UINT,
+        sizeof(UINT),
+        indices32.data(),
+        indices32.size() * sizeof(UINT)
+    );
+    if (!indices16.empty()) {
+        writer.AddSection(
+            PackSectionIndices16, DXGI_FORMAT_R16_UINT,
+            sizeof(UINT16),
+            indices16.data(),
+            indices16.size() * sizeof(UINT16)
+        );
+    }
+    writer.AddSection(
+        PackSectionTextures, DXGI_FORMAT_UNKNOWN,
+        sizeof(SampleAssets::TextureResource),
+        textures.data(),
+        textures.size() * sizeof(SampleAssets::TextureResource)
+    );
+    if (CookCompressTextures && !texture_data.empty()) {
+        // -- chunks stop at texture boundaries, see PackChunk
+        std::vector<UINT64> cuts;
+        for (SampleAssets::TextureResource const & tex : textures) {
+            UINT const last = tex.MipLevels - 1;
+            cuts.push_back(tex.Data[0].Offset);
+            cuts.push_back(UINT64(tex.Data[last].Offset) + tex.Data[last].Size);
+        }
+        std::sort(cuts.begin(), cuts.end());
+        writer.AddCompressedSection(
+            PackSectionTextureData, DXGI_FORMAT_UNKNOWN,
+            1, texture_data.data(), texture_data.size(), cuts
+        );
+    } else {
+        writer.AddSection(
+            PackSectionTextureData, DXGI_FORMAT_UNKNOWN,
+            1, texture_data.data(), texture_data.size()
+        );
+    }
+    writer.AddSection(
+        PackSectionDraws, DXGI_FORMAT_UNKNOWN,
+        sizeof(PackDraw),
+        draws.data(),
+        draws.size() * sizeof(PackDraw)
+    );
+    if (!lods.empty()) {
+        writer.AddSection(
+            PackSectionLods, DXGI_FORMAT_UNKNOWN,
+            sizeof(PackLod),
+            lods.data(),
+            lods.size() * sizeof(PackLod)
+        );
+    }
+    if (!meshlets.empty()) {
+        writer.AddSection(
+            PackSectionMeshlets, DXGI_FORMAT_UNKNOWN,
+            sizeof(PackMeshlet),
+            meshlets.data(),
+            meshlets.size() * sizeof(PackMeshlet)
+        );
+    }
+    writer.Write(CookerVersion, source, pack);
+    return S_OK;
+}
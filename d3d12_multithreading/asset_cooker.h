@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+
+#include "asset_pack.h"
+
+// NOTE(omid): The cooker turns the raw SquidRoom.bin (whose layout is only
+// described by the constants in squid_room.h) into a self-describing pack.
+// It runs once when no pack is found next to the executable.
+
+// -- store vertices in the 20 byte compressed layout (see vertex_compression.h)
+static constexpr bool CookCompressedVertices = true;
+// -- reorder triangles and vertices of every draw (see mesh_optimizer.h)
+static constexpr bool CookOptimizeMeshes = true;
+
+// -- split draws with more than one meshlet worth of triangles into
+// -- cullable clusters (see meshlets.h)
+static constexpr bool CookMeshlets = true;
+
+// -- build simplified LODs for every draw (see mesh_lod.h)
+static constexpr bool CookLods = true;
+
+// -- store draws whose vertex range fits in 16 bits with R16_UINT indices
+static constexpr bool CookIndices16 = true;
+
+// -- store the texture data as lz4 chunks (see PackChunk), pays off when
+// -- the pack is read from slow storage more than when it is cached
+static constexpr bool CookCompressTextures = false;
+
+// -- bump whenever the cooker writes something different for the same source
+static constexpr UINT CookerRevision = 2;
+// -- part of a pack's cache key: the revision and the switches above
+static constexpr UINT CookerVersion =
+    CookerRevision << 8 |
+    (CookCompressedVertices ? 0x01 : 0) |
+    (CookOptimizeMeshes ? 0x02 : 0) |
+    (CookMeshlets ? 0x04 : 0) |
+    (CookLods ? 0x08 : 0) |
+    (CookIndices16 ? 0x10 : 0) |
+    (CookCompressTextures ? 0x20 : 0);
+
+struct IndexConversionStats {
+    UINT draws_16;          // -- draws moved to R16_UINT
+    UINT draws_32;          // -- draws left at R32_UINT
+    UINT64 bytes_before;
+    UINT64 bytes_after;
+};
+
+//
+// -- split draw-relative 32-bit indices into a 16-bit and a 32-bit stream,
+// -- draws (and their lods) get index_format set and index_start renumbered
+void ConvertIndices16 (
+    UINT const * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    PackLod * lods,
+    std::vector<UINT16> * indices16,
+    std::vector<UINT> * indices32,
+    IndexConversionStats * stats
+);
+
+//
+// -- lay texels out the way GetCopyableFootprints places 2d textures in an
+// -- upload buffer (256 byte row pitch, 512 byte aligned mips), so a whole
+// -- texture uploads with one copy; texture entries get the new offsets and
+// -- sizes that stop at the end of the last row (not its padded pitch)
+HRESULT LayoutTexturesForUpload (
+    UINT8 const * texels,
+    SampleAssets::TextureResource * textures,
+    UINT texture_count,
+    std::vector<UINT8> * texture_data
+);
+
+//
+// -- source identifies legacy_data in the pack's cache key
+HRESULT CookLegacyAssets (
+    UINT8 const * legacy_data,
+    UINT legacy_size,
+    PackSource const & source,
+    std::vector<UINT8> * pack
+);
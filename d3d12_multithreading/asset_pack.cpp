@@ -0,0 +1,527 @@
+#include "stdafx.h"
+#include "asset_pack.h"
+#include "vertex_compression.h"
+#include "lz4_block.h"
+#include "dds_format.h"
+
+#include <algorithm>
+
+// -- reflected crc32 (same polynomial as zip/png)
+UINT Crc32 (void const * data, size_t size, UINT crc) {
+    struct Table {
+        UINT entries[256];
+        Table () {
+            for (UINT i = 0; i < 256; ++i) {
+                UINT c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                entries[i] = c;
+            }
+        }
+    };
+    static Table const table;
+
+    UINT8 const * bytes = reinterpret_cast<UINT8 const *>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+// -- fnv-1a over 8-byte words, rotated so high bits feed back into low ones
+UINT64 Hash64 (void const * data, size_t size, UINT64 seed) {
+    static constexpr UINT64 Prime = 0x100000001B3ull;
+    UINT8 const * bytes = static_cast<UINT8 const *>(data);
+    UINT64 hash = 0xCBF29CE484222325ull ^ seed ^ size;
+    size_t i = 0;
+    for (; i + sizeof(UINT64) <= size; i += sizeof(UINT64)) {
+        UINT64 word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * Prime;
+        hash = hash << 31 | hash >> 33;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ bytes[i]) * Prime;
+    // -- final avalanche (murmur3 fmix64)
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB3F95E31B4A9ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+//
+// -- find the one section of a given type, fails on duplicates
+static PackSection const *
+FindSection (PackSection const * toc, UINT count, PackSectionType type) {
+    PackSection const * found = nullptr;
+    for (UINT i = 0; i < count; ++i) {
+        if (toc[i].type != type)
+            continue;
+        if (found != nullptr)
+            return nullptr;
+        found = &toc[i];
+    }
+    return found;
+}
+static bool
+HasSection (PackSection const * toc, UINT count, PackSectionType type) {
+    for (UINT i = 0; i < count; ++i)
+        if (toc[i].type == type)
+            return true;
+    return false;
+}
+//
+// -- validate header, toc and payload bounds then hand out pointers
+// -- into the caller's buffer (nothing is copied)
+HRESULT ParsePack (
+    UINT8 const * data,
+    UINT64 size,
+    bool verify_payloads,
+    PackView * view
+) {
+    HRESULT const invalid = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    if (nullptr == data || nullptr == view)
+        return E_INVALIDARG;
+    if (size < sizeof(PackHeader))
+        return invalid;
+
+    PackHeader const * header = reinterpret_cast<PackHeader const *>(data);
+    if (header->magic != PackMagic)
+        return invalid;
+    if (header->version != PackVersion)
+        return HRESULT_FROM_WIN32(ERROR_REVISION_MISMATCH);
+    if (header->file_size != size)
+        return invalid;
+    if (0 == header->section_count || header->section_count > PackMaxSections)
+        return invalid;
+
+    UINT64 const toc_size = header->section_count * sizeof(PackSection);
+    if (sizeof(PackHeader) + toc_size > size)
+        return invalid;
+    PackSection const * toc =
+        reinterpret_cast<PackSection const *>(data + sizeof(PackHeader));
+    if (Crc32(toc, static_cast<size_t>(toc_size)) != header->toc_checksum)
+        return invalid;
+
+    for (UINT i = 0; i < header->section_count; ++i) {
+        PackSection const & s = toc[i];
+        if (0 != s.offset % PackPayloadAlignment)
+            return invalid;
+        // -- written this way so a huge size cannot wrap around
+        if (s.offset > size || s.size > size - s.offset)
+            return invalid;
+        if (PackCodecNone == s.codec) {
+            if (0 != s.chunk_count || s.raw_size != s.size)
+                return invalid;
+        } else if (PackCodecLz4 == s.codec) {
+            // -- only the texture data is ever compressed
+            if (
+                PackSectionTextureData != s.type || 0 == s.chunk_count ||
+                s.chunk_count > s.size / sizeof(PackChunk)
+            ) {
+                return invalid;
+            }
+        } else {
+            return invalid;
+        }
+        if (0 == s.stride || 0 != s.raw_size % s.stride)
+            return invalid;
+        if (
+            verify_payloads &&
+            Crc32(data + s.offset, static_cast<size_t>(s.size)) != s.checksum
+        ) {
+            return invalid;
+        }
+    }
+
+    PackSection const * vertices =
+        FindSection(toc, header->section_count, PackSectionVertices);
+    PackSection const * indices =
+        FindSection(toc, header->section_count, PackSectionIndices);
+    PackSection const * textures =
+        FindSection(toc, header->section_count, PackSectionTextures);
+    PackSection const * texture_data =
+        FindSection(toc, header->section_count, PackSectionTextureData);
+    PackSection const * draws =
+        FindSection(toc, header->section_count, PackSectionDraws);
+    if (!vertices || !indices || !textures || !texture_data || !draws)
+        return invalid;
+    // -- optional sections, but still at most one of each
+    PackSection const * indices16 = nullptr;
+    if (HasSection(toc, header->section_count, PackSectionIndices16)) {
+        indices16 = FindSection(toc, header->section_count, PackSectionIndices16);
+        if (nullptr == indices16)
+            return invalid;
+    }
+    PackSection const * meshlets = nullptr;
+    if (HasSection(toc, header->section_count, PackSectionMeshlets)) {
+        meshlets = FindSection(toc, header->section_count, PackSectionMeshlets);
+        if (nullptr == meshlets || meshlets->stride != sizeof(PackMeshlet))
+            return invalid;
+    }
+    PackSection const * lods = nullptr;
+    if (HasSection(toc, header->section_count, PackSectionLods)) {
+        lods = FindSection(toc, header->section_count, PackSectionLods);
+        if (nullptr == lods || lods->stride != sizeof(PackLod))
+            return invalid;
+    }
+
+    // -- buffers are bound as a whole, keep them under 4 GiB
+    if (vertices->size > UINT_MAX || indices->size > UINT_MAX)
+        return invalid;
+    if (indices16 && indices16->size > UINT_MAX)
+        return invalid;
+    UINT const expected_vertex_stride =
+        PackVertexStandard == vertices->format ? SampleAssets::StandardVertexStride :
+        PackVertexCompressed == vertices->format ? CompressedVertexStride : 0;
+    if (vertices->stride != expected_vertex_stride)
+        return invalid;
+    if (
+        indices->format != DXGI_FORMAT_R32_UINT ||
+        indices->stride != sizeof(UINT)
+    ) {
+        return invalid;
+    }
+    if (
+        indices16 && (
+            indices16->format != DXGI_FORMAT_R16_UINT ||
+            indices16->stride != sizeof(UINT16)
+        )
+    ) {
+        return invalid;
+    }
+    if (
+        textures->stride != sizeof(SampleAssets::TextureResource) ||
+        draws->stride != sizeof(PackDraw)
+    ) {
+        return invalid;
+    }
+
+    PackView result = {};
+    result.vertex_data = data + vertices->offset;
+    result.vertex_data_size = static_cast<UINT>(vertices->size);
+    result.vertex_stride = vertices->stride;
+    result.vertex_format = static_cast<PackVertexFormat>(vertices->format);
+    result.index_data = data + indices->offset;
+    result.index_data_size = static_cast<UINT>(indices->size);
+    result.index_format = static_cast<DXGI_FORMAT>(indices->format);
+    if (indices16) {
+        result.index16_data = data + indices16->offset;
+        result.index16_data_size = static_cast<UINT>(indices16->size);
+    }
+    result.textures = reinterpret_cast<SampleAssets::TextureResource const *>(
+        data + textures->offset
+    );
+    result.texture_count = static_cast<UINT>(textures->size / textures->stride);
+    result.texture_data_size = texture_data->raw_size;
+    if (PackCodecNone == texture_data->codec) {
+        result.texture_data = data + texture_data->offset;
+    } else {
+        // -- chunks tile the decoded section in order, stored bytes stay
+        // -- inside the payload, past the table
+        result.texture_payload = data + texture_data->offset;
+        result.texture_chunks =
+            reinterpret_cast<PackChunk const *>(result.texture_payload);
+        result.texture_chunk_count = texture_data->chunk_count;
+        UINT64 const table_size = texture_data->chunk_count * sizeof(PackChunk);
+        UINT64 raw_offset = 0;
+        for (UINT c = 0; c < result.texture_chunk_count; ++c) {
+            PackChunk const & chunk = result.texture_chunks[c];
+            if (
+                chunk.raw_offset != raw_offset ||
+                0 == chunk.raw_size || chunk.raw_size > PackChunkSize ||
+                chunk.size > chunk.raw_size
+            ) {
+                return invalid;
+            }
+            if (
+                chunk.offset < table_size || chunk.offset > texture_data->size ||
+                chunk.size > texture_data->size - chunk.offset
+            ) {
+                return invalid;
+            }
+            raw_offset += chunk.raw_size;
+        }
+        if (raw_offset != texture_data->raw_size)
+            return invalid;
+    }
+    result.draws = reinterpret_cast<PackDraw const *>(data + draws->offset);
+    result.draw_count = static_cast<UINT>(draws->size / draws->stride);
+    if (meshlets) {
+        result.meshlets =
+            reinterpret_cast<PackMeshlet const *>(data + meshlets->offset);
+        result.meshlet_count =
+            static_cast<UINT>(meshlets->size / meshlets->stride);
+    }
+    if (lods) {
+        result.lods = reinterpret_cast<PackLod const *>(data + lods->offset);
+        result.lod_count = static_cast<UINT>(lods->size / lods->stride);
+    }
+    result.cooker_version = header->cooker_version;
+    result.source = header->source;
+
+    // -- texture table must stay inside the texture data section,
+    // -- and every mip's rows (as copied row by row) inside the mip
+    for (UINT i = 0; i < result.texture_count; ++i) {
+        SampleAssets::TextureResource const & tex = result.textures[i];
+        UINT const block_size = BlockSize(tex.Format);
+        UINT const bits_per_pixel = BitsPerPixel(tex.Format);
+        if (
+            0 == tex.Width || 0 == tex.Height ||
+            tex.Width > DdsMaxDimension || tex.Height > DdsMaxDimension ||
+            0 == tex.MipLevels || tex.MipLevels > D3D12_REQ_MIP_LEVELS ||
+            0 == bits_per_pixel
+        ) {
+            return invalid;
+        }
+        UINT64 texture_end = 0;
+        for (UINT m = 0; m < tex.MipLevels; ++m) {
+            UINT64 const end =
+                static_cast<UINT64>(tex.Data[m].Offset) + tex.Data[m].Size;
+            if (end > result.texture_data_size || tex.Data[m].Offset < tex.Data[0].Offset)
+                return invalid;
+            texture_end = std::max(texture_end, end);
+
+            UINT const width = std::max(tex.Width >> m, 1u);
+            UINT const height = std::max(tex.Height >> m, 1u);
+            UINT64 row_size = 0;
+            UINT64 row_count = 0;
+            if (0 != block_size) {
+                row_size = UINT64((width + 3) / 4) * block_size;
+                row_count = (height + 3) / 4;
+            } else {
+                row_size = (UINT64(width) * bits_per_pixel + 7) / 8;
+                row_count = height;
+            }
+            if (
+                tex.Data[m].Pitch < row_size ||
+                (row_count - 1) * tex.Data[m].Pitch + row_size > tex.Data[m].Size
+            ) {
+                return invalid;
+            }
+        }
+        // -- each texture decodes from its own chunks
+        UINT first_chunk = 0;
+        UINT chunk_count = 0;
+        if (
+            nullptr != result.texture_chunks &&
+            !FindTextureChunks(result, tex.Data[0].Offset, texture_end, &first_chunk, &chunk_count)
+        ) {
+            return invalid;
+        }
+    }
+    // -- draws must reference existing textures and index ranges
+    UINT const index32_count = result.index_data_size / sizeof(UINT);
+    UINT const index16_count = result.index16_data_size / sizeof(UINT16);
+    for (UINT i = 0; i < result.draw_count; ++i) {
+        PackDraw const & draw = result.draws[i];
+        if (
+            draw.diffuse_texture_index < 0 ||
+            // -- normal map is bound right after the diffuse map
+            static_cast<UINT>(draw.diffuse_texture_index) + 1 >=
+            result.texture_count
+        ) {
+            return invalid;
+        }
+        UINT index_count = 0;
+        if (DXGI_FORMAT_R32_UINT == draw.index_format)
+            index_count = index32_count;
+        else if (DXGI_FORMAT_R16_UINT == draw.index_format)
+            index_count = index16_count;
+        else
+            return invalid;
+        if (
+            draw.index_start > index_count ||
+            draw.index_count > index_count - draw.index_start
+        ) {
+            return invalid;
+        }
+        // -- meshlets must stay inside the table and the draw
+        if (
+            draw.meshlet_start > result.meshlet_count ||
+            draw.meshlet_count > result.meshlet_count - draw.meshlet_start
+        ) {
+            return invalid;
+        }
+        for (UINT m = 0; m < draw.meshlet_count; ++m) {
+            PackMeshlet const & meshlet = result.meshlets[draw.meshlet_start + m];
+            if (
+                meshlet.index_start > draw.index_count ||
+                meshlet.index_count > draw.index_count - meshlet.index_start
+            ) {
+                return invalid;
+            }
+        }
+        // -- lods index the same section as the draw
+        if (
+            draw.lod_start > result.lod_count ||
+            draw.lod_count > result.lod_count - draw.lod_start
+        ) {
+            return invalid;
+        }
+        for (UINT l = 0; l < draw.lod_count; ++l) {
+            PackLod const & lod = result.lods[draw.lod_start + l];
+            if (
+                lod.index_start > index_count ||
+                lod.index_count > index_count - lod.index_start
+            ) {
+                return invalid;
+            }
+        }
+    }
+
+    *view = result;
+    return S_OK;
+}
+bool FindTextureChunks (
+    PackView const & view,
+    UINT64 raw_begin,
+    UINT64 raw_end,
+    UINT * first_chunk,
+    UINT * chunk_count
+) {
+    PackChunk const * chunks = view.texture_chunks;
+    PackChunk const * chunks_end = chunks + view.texture_chunk_count;
+    PackChunk const * first = std::lower_bound(
+        chunks, chunks_end, raw_begin,
+        [] (PackChunk const & chunk, UINT64 offset) {
+            return chunk.raw_offset < offset;
+        }
+    );
+    PackChunk const * last = first;
+    while (last != chunks_end && last->raw_offset < raw_end)
+        ++last;
+    bool const begins = raw_begin == raw_end ||
+        (first != chunks_end && first->raw_offset == raw_begin);
+    bool const ends = raw_begin == raw_end ||
+        (last != first && last[-1].raw_offset + last[-1].raw_size == raw_end);
+    *first_chunk = static_cast<UINT>(first - chunks);
+    *chunk_count = static_cast<UINT>(last - first);
+    return begins && ends;
+}
+bool DecodePackChunk (PackChunk const & chunk, UINT8 const * payload, void * dst) {
+    UINT8 const * src = payload + chunk.offset;
+    if (chunk.size == chunk.raw_size) {
+        memcpy(dst, src, chunk.raw_size);
+        return true;
+    }
+    return Lz4Decompress(src, chunk.size, dst, chunk.raw_size);
+}
+void PackWriter::AddSection (
+    PackSectionType type,
+    UINT format,
+    UINT stride,
+    void const * data,
+    UINT64 size
+) {
+    PendingSection pending = {};
+    pending.section.type = type;
+    pending.section.format = format;
+    pending.section.stride = stride;
+    pending.section.size = size;
+    pending.section.checksum = Crc32(data, static_cast<size_t>(size));
+    pending.section.codec = PackCodecNone;
+    pending.section.raw_size = size;
+    pending.data = data;
+    sections_.push_back(pending);
+}
+void PackWriter::AddCompressedSection (
+    PackSectionType type,
+    UINT format,
+    UINT stride,
+    void const * data,
+    UINT64 size,
+    std::vector<UINT64> const & cuts
+) {
+    UINT8 const * bytes = static_cast<UINT8 const *>(data);
+    // -- cut at every requested offset and at least every PackChunkSize
+    std::vector<PackChunk> chunks;
+    UINT64 raw_offset = 0;
+    auto cut = cuts.begin();
+    while (raw_offset < size) {
+        while (cut != cuts.end() && *cut <= raw_offset)
+            ++cut;
+        UINT64 const limit = cut != cuts.end() ? std::min(*cut, size) : size;
+        PackChunk chunk = {};
+        chunk.raw_offset = raw_offset;
+        chunk.raw_size = static_cast<UINT>(std::min<UINT64>(limit - raw_offset, PackChunkSize));
+        chunks.push_back(chunk);
+        raw_offset += chunk.raw_size;
+    }
+
+    UINT64 const table_size = chunks.size() * sizeof(PackChunk);
+    std::vector<UINT8> storage(static_cast<size_t>(table_size));
+    std::vector<UINT8> block(Lz4CompressBound(PackChunkSize));
+    for (PackChunk & chunk : chunks) {
+        UINT8 const * raw = bytes + chunk.raw_offset;
+        size_t packed = Lz4Compress(raw, chunk.raw_size, block.data(), block.size());
+        // -- keep chunks that do not shrink as they are
+        if (0 == packed || packed >= chunk.raw_size) {
+            packed = chunk.raw_size;
+            memcpy(block.data(), raw, packed);
+        }
+        chunk.offset = storage.size();
+        chunk.size = static_cast<UINT>(packed);
+        storage.insert(storage.end(), block.begin(), block.begin() + packed);
+    }
+    memcpy(storage.data(), chunks.data(), static_cast<size_t>(table_size));
+
+    PendingSection pending = {};
+    pending.section.type = type;
+    pending.section.format = format;
+    pending.section.stride = stride;
+    pending.section.size = storage.size();
+    pending.section.checksum = Crc32(storage.data(), storage.size());
+    pending.section.codec = PackCodecLz4;
+    pending.section.chunk_count = static_cast<UINT>(chunks.size());
+    pending.section.raw_size = size;
+    pending.storage.swap(storage);
+    sections_.push_back(std::move(pending));
+}
+void PackWriter::Write (
+    UINT cooker_version,
+    PackSource const & source,
+    std::vector<UINT8> * out
+) const {
+    auto align_up = [] (UINT64 value) {
+        return (value + PackPayloadAlignment - 1) &
+            ~static_cast<UINT64>(PackPayloadAlignment - 1);
+    };
+    UINT const section_count = static_cast<UINT>(sections_.size());
+    std::vector<PackSection> toc(section_count);
+
+    // -- lay out payloads after the toc
+    UINT64 cursor = align_up(
+        sizeof(PackHeader) + section_count * sizeof(PackSection)
+    );
+    for (UINT i = 0; i < section_count; ++i) {
+        toc[i] = sections_[i].section;
+        toc[i].offset = cursor;
+        cursor = align_up(cursor + toc[i].size);
+    }
+
+    out->assign(static_cast<size_t>(cursor), 0);
+    UINT8 * base = out->data();
+
+    PackHeader header = {};
+    header.magic = PackMagic;
+    header.version = PackVersion;
+    header.section_count = section_count;
+    header.toc_checksum =
+        Crc32(toc.data(), section_count * sizeof(PackSection));
+    header.file_size = cursor;
+    header.cooker_version = cooker_version;
+    header.source = source;
+    memcpy(base, &header, sizeof(header));
+    memcpy(
+        base + sizeof(PackHeader),
+        toc.data(),
+        section_count * sizeof(PackSection)
+    );
+    for (UINT i = 0; i < section_count; ++i)
+        memcpy(
+            base + toc[i].offset,
+            sections_[i].storage.empty() ? sections_[i].data : sections_[i].storage.data(),
+            static_cast<size_t>(toc[i].size)
+        );
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <vector>
+
+#include "squid_room.h"
+
+// NOTE(omid): Layout of a packed asset file (*.odxp)
+/*
+    PackHeader                      -- with the cache key (see below)
+    PackSection [section_count]     -- table of contents
+    payloads                        -- each one starts on a 4 KiB boundary
+
+    All offsets are absolute file offsets. The table of contents and
+    every payload carry a crc32, so a truncated or patched file gets
+    rejected before anything is uploaded to the gpu.
+
+    A pack is a cache of what the cooker made of one source file: the
+    header records the cooker version and the source's size, write time
+    and content hash, a pack whose key does not match is cooked again.
+
+    The texture data may be stored lz4 compressed: a PackChunk table then
+    the chunks, each one decodable on its own (so they decode in parallel)
+    and never straddling a texture (so each lands in its texture's upload
+    memory without any reassembly).
+*/
+
+static constexpr UINT PackMagic = 0x5058444F;   // -- "ODXP"
+static constexpr UINT PackVersion = 8;
+static constexpr UINT PackPayloadAlignment = 4096;
+static constexpr UINT PackMaxSections = 64;
+// -- compressed sections are cut in chunks of at most this many raw bytes
+static constexpr UINT PackChunkSize = 256 * 1024;
+
+enum PackSectionType : UINT {
+    PackSectionVertices = 1,
+    PackSectionIndices = 2,
+    PackSectionTextures = 3,        // -- table of SampleAssets::TextureResource
+    PackSectionTextureData = 4,     // -- texels referenced by the texture table
+    PackSectionDraws = 5,           // -- table of PackDraw
+    PackSectionIndices16 = 6,       // -- optional R16_UINT indices
+    PackSectionMeshlets = 7,        // -- optional table of PackMeshlet
+    PackSectionLods = 8,            // -- optional table of PackLod
+};
+
+enum PackCodec : UINT {
+    PackCodecNone = 0,
+    PackCodecLz4 = 1,               // -- PackChunk table, then the lz4 blocks
+};
+
+enum PackVertexFormat : UINT {
+    PackVertexStandard = 0,         // -- SampleAssets::StandardVertexDescription
+    PackVertexCompressed = 1,       // -- CompressedVertexDescription
+};
+
+// -- identity of the raw file a pack was cooked from
+struct PackSource {
+    UINT64 size;
+    UINT64 write_time;      // -- FILETIME of the last write
+    UINT64 hash;            // -- Hash64 of the contents
+};
+
+struct PackHeader {
+    UINT magic;
+    UINT version;
+    UINT section_count;
+    UINT toc_checksum;      // -- crc32 of the section table
+    UINT64 file_size;
+    UINT cooker_version;    // -- CookerVersion of the cooker that wrote it
+    UINT reserved;
+    PackSource source;
+};
+
+struct PackSection {
+    UINT type;
+    UINT format;            // -- DXGI_FORMAT of the elements (PackVertexFormat for vertices)
+    UINT stride;            // -- size of one element in bytes
+    UINT checksum;          // -- crc32 of the payload (as stored)
+    UINT64 offset;
+    UINT64 size;            // -- as stored
+    UINT codec;             // -- PackCodec
+    UINT chunk_count;       // -- 0 unless compressed
+    UINT64 raw_size;        // -- once decoded, elements are counted in it
+};
+
+// -- independently compressed piece of a section
+struct PackChunk {
+    UINT64 raw_offset;      // -- in the decoded section
+    UINT64 offset;          // -- of the stored bytes, from the payload start
+    UINT raw_size;
+    UINT size;              // -- equal to raw_size: stored as is
+};
+
+// -- one draw as stored in the pack
+// NOTE(omid): texture mip offsets are relative to the texture data section
+struct PackDraw {
+    INT diffuse_texture_index;
+    INT normal_texture_index;
+    INT specular_texture_index;
+    UINT index_start;       // -- in elements of index_format's section
+    UINT index_count;
+    UINT vertex_base;
+    UINT index_format;      // -- DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+    UINT meshlet_start;     // -- 0 meshlets: the draw is always drawn whole
+    UINT meshlet_count;
+    UINT lod_start;         // -- coarser versions of the draw (see mesh_lod.h)
+    UINT lod_count;
+    float bounds_center[3]; // -- model space bounding sphere
+    float bounds_radius;
+    // -- decoded position = offset + unorm position * scale
+    float position_offset[3];
+    float position_scale[3];
+};
+
+//
+// -- cluster of a draw (see meshlets.h), bounds are in model space
+struct PackMeshlet {
+    UINT index_start;       // -- relative to the draw's index_start
+    UINT index_count;
+    float center[3];        // -- bounding sphere
+    float radius;
+    // -- normal cone, the whole meshlet is back facing when
+    // -- dot(normalize(cone_apex - eye), cone_axis) >= cone_cutoff
+    float cone_apex[3];
+    float cone_cutoff;      // -- 1 when the cone is too wide to ever cull
+    float cone_axis[3];
+    UINT padding;
+};
+
+//
+// -- simplified index range of a draw, same format and vertex_base
+struct PackLod {
+    UINT index_start;       // -- in elements of the draw's index_format section
+    UINT index_count;
+    float error;            // -- largest collapse error, model space
+};
+
+// -- parsed view of a pack, all pointers alias the caller's file bytes
+struct PackView {
+    UINT8 const * vertex_data;
+    UINT vertex_data_size;
+    UINT vertex_stride;
+    PackVertexFormat vertex_format;
+
+    UINT8 const * index_data;
+    UINT index_data_size;
+    DXGI_FORMAT index_format;
+    UINT8 const * index16_data;     // -- null when no draw uses 16-bit indices
+    UINT index16_data_size;
+
+    SampleAssets::TextureResource const * textures;
+    UINT texture_count;
+    UINT8 const * texture_data;     // -- null when the texture data is compressed
+    UINT64 texture_data_size;       // -- decoded size
+    PackChunk const * texture_chunks;
+    UINT texture_chunk_count;
+    UINT8 const * texture_payload;  // -- chunk offsets are relative to it
+
+    PackDraw const * draws;
+    UINT draw_count;
+    PackMeshlet const * meshlets;
+    UINT meshlet_count;
+    PackLod const * lods;
+    UINT lod_count;
+
+    UINT cooker_version;
+    PackSource source;
+};
+
+UINT Crc32 (void const * data, size_t size, UINT crc = 0);
+// -- fast 64-bit fingerprint, not for anything adversarial
+UINT64 Hash64 (void const * data, size_t size, UINT64 seed = 0);
+
+HRESULT ParsePack (
+    UINT8 const * data,
+    UINT64 size,
+    bool verify_payloads,
+    PackView * view
+);
+
+//
+// -- chunks exactly covering texture data [raw_begin, raw_end) of a
+// -- compressed pack, false if a chunk straddles either end
+bool FindTextureChunks (
+    PackView const & view,
+    UINT64 raw_begin,
+    UINT64 raw_end,
+    UINT * first_chunk,
+    UINT * chunk_count
+);
+// -- decode one chunk into cached memory (dst holds chunk.raw_size bytes)
+bool DecodePackChunk (PackChunk const & chunk, UINT8 const * payload, void * dst);
+
+//
+// -- serialize sections into a pack, payloads are aligned and checksummed
+struct PackWriter {
+private:
+    struct PendingSection {
+        PackSection section;
+        void const * data;
+        std::vector<UINT8> storage;     // -- owns the payload when compressed
+    };
+    std::vector<PendingSection> sections_;
+public:
+    void AddSection (
+        PackSectionType type,
+        UINT format,
+        UINT stride,
+        void const * data,
+        UINT64 size
+    );
+    // -- lz4 chunks, none crosses any of the (sorted) raw offsets in cuts
+    void AddCompressedSection (
+        PackSectionType type,
+        UINT format,
+        UINT stride,
+        void const * data,
+        UINT64 size,
+        std::vector<UINT64> const & cuts
+    );
+    void Write (
+        UINT cooker_version,
+        PackSource const & source,
+        std::vector<UINT8> * out
+    ) const;
+};
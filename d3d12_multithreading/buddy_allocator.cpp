@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "buddy_allocator.h"
+
+BuddyAllocator::BuddyAllocator () :
+    min_block_size_(0), order_count_(0), used_size_(0)
+{
+}
+void BuddyAllocator::Init (UINT64 total_size, UINT64 min_block_size) {
+    assert(min_block_size > 0 && 0 == (min_block_size & (min_block_size - 1)));
+    assert(total_size >= min_block_size);
+    min_block_size_ = min_block_size;
+    order_count_ = 1;
+    while ((min_block_size << order_count_) <= total_size)
+        ++order_count_;
+    free_.assign(order_count_, std::set<UINT64>());
+    free_[order_count_ - 1].insert(0);
+    allocated_.clear();
+    used_size_ = 0;
+}
+bool BuddyAllocator::Allocate (UINT64 size, UINT64 alignment, UINT64 * offset) {
+    if (0 == order_count_ || 0 == size)
+        return false;
+    // -- blocks are aligned to their size, so alignment only sets a minimum
+    UINT64 const needed = size > alignment ? size : alignment;
+    UINT order = 0;
+    while (order < order_count_ && (min_block_size_ << order) < needed)
+        ++order;
+    if (order == order_count_)
+        return false;
+
+    // -- smallest free block that fits, then split it down
+    UINT found = order;
+    while (found < order_count_ && free_[found].empty())
+        ++found;
+    if (found == order_count_)
+        return false;
+    UINT64 const block = *free_[found].begin();
+    free_[found].erase(free_[found].begin());
+    while (found > order) {
+        --found;
+        free_[found].insert(block + (min_block_size_ << found));
+    }
+    allocated_[block] = order;
+    used_size_ += min_block_size_ << order;
+    *offset = block;
+    return true;
+}
+void BuddyAllocator::Free (UINT64 offset) {
+    auto const it = allocated_.find(offset);
+    assert(it != allocated_.end());
+    if (it == allocated_.end())
+        return;
+    UINT order = it->second;
+    allocated_.erase(it);
+    used_size_ -= min_block_size_ << order;
+
+    // -- merge with the buddy for as long as it is free too
+    UINT64 block = offset;
+    while (order + 1 < order_count_) {
+        UINT64 const buddy = block ^ (min_block_size_ << order);
+        auto const buddy_it = free_[order].find(buddy);
+        if (buddy_it == free_[order].end())
+            break;
+        free_[order].erase(buddy_it);
+        block = block < buddy ? block : buddy;
+        ++order;
+    }
+    free_[order].insert(block);
+}
+UINT64 BuddyAllocator::LargestFreeBlock () const {
+    for (UINT order = order_count_; order > 0; --order)
+        if (!free_[order - 1].empty())
+            return min_block_size_ << (order - 1);
+    return 0;
+}
+float BuddyAllocator::Fragmentation () const {
+    UINT64 const free_size = TotalSize() - used_size_;
+    if (0 == free_size)
+        return 0.0f;
+    return 1.0f - static_cast<float>(LargestFreeBlock()) / static_cast<float>(free_size);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+// NOTE(omid): Power-of-two buddy allocator over an abstract range
+/*
+    Hands out offsets only, it never touches memory, so the same policy
+    can sub-allocate a gpu heap. Every block is aligned to its own size,
+    which gives d3d12 placement alignment for free as long as the range
+    itself starts aligned (heaps always do).
+*/
+
+struct BuddyAllocator {
+private:
+    UINT64 min_block_size_;
+    UINT order_count_;                      // -- order k blocks are min << k
+    std::vector<std::set<UINT64>> free_;    // -- free block offsets per order
+    std::unordered_map<UINT64, UINT> allocated_;    // -- offset -> order
+    UINT64 used_size_;
+public:
+    BuddyAllocator ();
+    //
+    // -- total_size is rounded down to min_block_size << n
+    void Init (UINT64 total_size, UINT64 min_block_size);
+
+    bool Allocate (UINT64 size, UINT64 alignment, UINT64 * offset);
+    void Free (UINT64 offset);
+
+    UINT64 TotalSize () const { return min_block_size_ << (order_count_ - 1); }
+    UINT64 UsedSize () const { return used_size_; }
+    UINT64 LargestFreeBlock () const;
+    bool Empty () const { return allocated_.empty(); }
+    // -- 0 when all free space is one block, towards 1 when it is scattered
+    float Fragmentation () const;
+};
@@ -0,0 +1,116 @@
+#include "stdafx.h"
+#include "command_pool.h"
+
+#include <algorithm>
+
+CommandPool::CommandPool () :
+    device_(nullptr)
+{
+    for (TypePool & pool : pools_)
+        pool.stats = {};
+}
+CommandPool::~CommandPool () {
+    Release();
+}
+void CommandPool::Init (ID3D12Device * device) {
+    Release();
+    device_ = device;
+}
+void CommandPool::Release () {
+    // NOTE(omid): the caller makes sure nothing is still in flight
+    for (TypePool & pool : pools_) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.free_allocators.clear();
+        pool.free_lists.clear();
+        pool.pending.clear();
+        pool.stats = {};
+    }
+    device_ = nullptr;
+}
+HRESULT CommandPool::Acquire (
+    D3D12_COMMAND_LIST_TYPE type,
+    ID3D12PipelineState * pso,
+    CommandRecord * record
+) {
+    TypePool & pool = pools_[type];
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ComPtr<ID3D12GraphicsCommandList> cmdlist;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        ++pool.stats.acquires;
+        ++pool.stats.in_flight;
+        pool.stats.in_flight_high_water =
+            std::max(pool.stats.in_flight_high_water, pool.stats.in_flight);
+        if (!pool.free_allocators.empty()) {
+            allocator = std::move(pool.free_allocators.back());
+            pool.free_allocators.pop_back();
+            ++pool.stats.allocator_hits;
+        }
+        if (!pool.free_lists.empty()) {
+            cmdlist = std::move(pool.free_lists.back());
+            pool.free_lists.pop_back();
+            ++pool.stats.list_hits;
+        }
+    }
+    // -- creation and resets happen outside the lock
+    HRESULT hr = S_OK;
+    if (nullptr != allocator) {
+        hr = allocator->Reset();
+    } else {
+        hr = device_->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator));
+        if (SUCCEEDED(hr)) {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            ++pool.stats.allocators;
+        }
+    }
+    if (SUCCEEDED(hr)) {
+        if (nullptr != cmdlist) {
+            hr = cmdlist->Reset(allocator.Get(), pso);
+        } else {
+            hr = device_->CreateCommandList(
+                0 /* node mask */, type, allocator.Get(), pso, IID_PPV_ARGS(&cmdlist)
+            );
+            if (SUCCEEDED(hr)) {
+                cmdlist->SetName(L"pooled_cmdlist");
+                std::lock_guard<std::mutex> lock(pool.mutex);
+                ++pool.stats.lists;
+            }
+        }
+    }
+    if (FAILED(hr)) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        --pool.stats.in_flight;
+        return hr;
+    }
+    record->allocator = std::move(allocator);
+    record->cmdlist = std::move(cmdlist);
+    record->type = type;
+    return S_OK;
+}
+void CommandPool::Retire (CommandRecord * record, UINT64 fence_value) {
+    if (nullptr == record->allocator)
+        return;
+    TypePool & pool = pools_[record->type];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.free_lists.push_back(std::move(record->cmdlist));
+    pool.pending.push_back({std::move(record->allocator), fence_value});
+    record->cmdlist.Reset();
+    record->allocator.Reset();
+}
+void CommandPool::Recycle (D3D12_COMMAND_LIST_TYPE type, UINT64 completed_fence) {
+    TypePool & pool = pools_[type];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    while (
+        !pool.pending.empty() &&
+        pool.pending.front().fence_value <= completed_fence
+    ) {
+        pool.free_allocators.push_back(std::move(pool.pending.front().allocator));
+        pool.pending.pop_front();
+        --pool.stats.in_flight;
+    }
+}
+CommandPoolStats CommandPool::Stats (D3D12_COMMAND_LIST_TYPE type) {
+    TypePool & pool = pools_[type];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.stats;
+}
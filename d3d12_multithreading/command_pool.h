@@ -0,0 +1,74 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Shared pool of cmd allocators and cmdlists, per list type
+/*
+    Acquire hands out an allocator and a cmdlist already reset onto it
+    (open, with the given pso). After the list is submitted, Retire gives
+    both back: the list is free again right away (a submitted list can be
+    reset at once), the allocator only once the fence value it was
+    submitted under completes, see Recycle. Allocators are recycled
+    oldest first, as fence values only grow.
+
+    Thread safe, each list type has its own lock. d3d reports no memory
+    size for allocators, the high-water marks are in allocators.
+*/
+
+struct CommandRecord {
+    ComPtr<ID3D12CommandAllocator> allocator;
+    ComPtr<ID3D12GraphicsCommandList> cmdlist;
+    D3D12_COMMAND_LIST_TYPE type;
+};
+
+struct CommandPoolStats {
+    UINT64 acquires;
+    UINT64 allocator_hits;      // -- served by a recycled allocator
+    UINT64 list_hits;           // -- served by a free cmdlist
+    UINT allocators;            // -- created so far
+    UINT lists;
+    UINT in_flight;             // -- acquired or waiting on their fence
+    UINT in_flight_high_water;
+};
+
+struct CommandPool {
+private:
+    struct Pending {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        UINT64 fence_value;
+    };
+    struct TypePool {
+        std::mutex mutex;
+        std::vector<ComPtr<ID3D12CommandAllocator>> free_allocators;
+        std::vector<ComPtr<ID3D12GraphicsCommandList>> free_lists;
+        std::deque<Pending> pending;    // -- oldest submission first
+        CommandPoolStats stats;
+    };
+    // -- direct, bundle, compute, copy
+    static constexpr UINT TypeCount = D3D12_COMMAND_LIST_TYPE_COPY + 1;
+
+    ID3D12Device * device_;
+    TypePool pools_[TypeCount];
+public:
+    CommandPool ();
+    ~CommandPool ();
+
+    void Init (ID3D12Device * device);
+    void Release ();
+
+    HRESULT Acquire (
+        D3D12_COMMAND_LIST_TYPE type,
+        ID3D12PipelineState * pso,
+        CommandRecord * record
+    );
+    // -- after the list was submitted (or closed and dropped), empties record
+    void Retire (CommandRecord * record, UINT64 fence_value);
+    // -- allocators submitted under completed_fence or before are free again
+    void Recycle (D3D12_COMMAND_LIST_TYPE type, UINT64 completed_fence);
+
+    CommandPoolStats Stats (D3D12_COMMAND_LIST_TYPE type);
+};
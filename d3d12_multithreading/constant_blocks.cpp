@@ -0,0 +1,51 @@
+#include "stdafx.h"
+#include "constant_blocks.h"
+
+// -- constant block layouts, the shadow pass has one element per light
+static UINT const BlockSizes [ConstantBlockCount] = {
+    sizeof(StaticCBuffer),
+    sizeof(FrameCBuffer),
+    sizeof(PassCBuffer),
+    sizeof(PassCBuffer)
+};
+static UINT const BlockCounts [ConstantBlockCount] = {1, 1, NumLights, 1};
+
+static inline UINT
+SlotSize (UINT byte_size) {
+    return
+        (byte_size + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) &
+        ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+}
+
+ConstantBlockCopy::ConstantBlockCopy () : size_(0) {
+    for (UINT i = 0; i < ConstantBlockCount; ++i) {
+        offsets_[i] = size_;
+        versions_[i] = 0;   // -- blocks start at version 1
+        size_ += BlockCounts[i] * SlotSize(BlockSizes[i]);
+    }
+}
+UINT ConstantBlockCopy::Offset (UINT block, UINT element) const {
+    return offsets_[block] + element * SlotSize(BlockSizes[block]);
+}
+UINT64 ConstantBlockCopy::Write (ConstantBlocks const & blocks, UINT8 * dst) {
+    void const * const data [ConstantBlockCount] = {
+        &blocks.static_constants,
+        &blocks.frame,
+        blocks.shadow_passes,
+        &blocks.scene_pass
+    };
+    UINT64 written = 0;
+    for (UINT i = 0; i < ConstantBlockCount; ++i) {
+        if (versions_[i] == blocks.versions[i])
+            continue;
+        // -- elements are packed on the cpu, 256 byte aligned on the gpu
+        UINT8 const * src = static_cast<UINT8 const *>(data[i]);
+        for (UINT e = 0; e < BlockCounts[i]; ++e) {
+            memcpy(dst + Offset(i, e), src, BlockSizes[i]);
+            src += BlockSizes[i];
+        }
+        versions_[i] = blocks.versions[i];
+        written += BlockCounts[i] * BlockSizes[i];
+    }
+    return written;
+}
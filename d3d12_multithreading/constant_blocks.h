@@ -0,0 +1,88 @@
+#pragma once
+
+using namespace DirectX;
+
+// NOTE(omid): constants are split by how often they change
+/*
+    static  (b3)    ambient, light colors/falloffs, shadow atlas tiles
+    frame   (b2)    lights that move, when they are animated
+    pass    (b0)    point of view of the scene pass and of each light's
+                    shadow pass (one 256 byte slot per light)
+    draw    (b1)    per-object transform, every frame (FrameConstants)
+
+    The first three are kept on the cpu and rebuilt only when marked
+    dirty, each rebuild bumps the block's version. A frame resource keeps
+    its own copy of each block and only rewrites the ones whose version
+    it has not seen yet (see ConstantBlockCopy).
+*/
+enum ConstantBlock {
+    ConstantsStatic = 0,
+    ConstantsFrame,
+    ConstantsShadowPass,
+    ConstantsScenePass,
+    ConstantBlockCount
+};
+
+struct StaticCBuffer {
+    XMFLOAT4 ambient_color;
+    XMFLOAT4 light_colors[NumLights];
+    XMFLOAT4 light_falloffs[NumLights];
+    XMFLOAT4 shadow_tiles[NumLights];   // -- uv scale (xy) and offset (zw)
+    XMFLOAT4 smap_dims;                 // -- atlas size and its inverse
+    UINT shadow_light_count;
+    UINT padding[3];
+};
+
+struct FrameCBuffer {
+    struct Light {
+        XMFLOAT4 position;
+        XMFLOAT4 direction;
+        XMFLOAT4X4 view;
+        XMFLOAT4X4 projection;
+    };
+    Light lights[NumLights];
+};
+
+struct PassCBuffer {
+    XMFLOAT4X4 view;
+    XMFLOAT4X4 projection;
+    BOOL sample_smap;       // -- shadow map
+    BOOL padding[3];        // -- align to be float4s
+};
+
+struct ConstantBlocks {
+    StaticCBuffer static_constants;
+    FrameCBuffer frame;
+    PassCBuffer shadow_passes[NumLights];
+    PassCBuffer scene_pass;
+    UINT64 versions[ConstantBlockCount];
+};
+
+// -- per-draw constants, written by the workers into the frame's constants
+struct DrawCBuffer {
+    XMFLOAT4X4 model;
+    XMFLOAT3 position_offset;   // -- position dequantization
+    float padding0;
+    XMFLOAT3 position_scale;
+    float padding1;
+};
+
+//
+// -- a frame resource's copy of the blocks in its (write-combined) cbuffer,
+// -- each element in its own 256 byte aligned slot
+struct ConstantBlockCopy {
+private:
+    UINT offsets_[ConstantBlockCount];
+    UINT64 versions_[ConstantBlockCount];
+    UINT size_;
+public:
+    ConstantBlockCopy ();
+
+    // -- bytes of cbuffer the copy needs
+    UINT Size () const { return size_; }
+    // -- element picks the light's slot in the shadow pass block
+    UINT Offset (UINT block, UINT element = 0) const;
+    // -- copy the blocks whose version moved since the last write into
+    // -- the cbuffer at dst, returns the bytes written
+    UINT64 Write (ConstantBlocks const & blocks, UINT8 * dst);
+};
@@ -0,0 +1,397 @@
+#include "stdafx.h"
+#include "dds_format.h"
+
+#include <algorithm>
+
+static constexpr UINT DdsMaxArraySize = 2048;
+
+// -- DDS_HEADER::flags
+static constexpr UINT DdsFlagMipCount = 0x20000;
+static constexpr UINT DdsFlagDepth = 0x800000;
+// -- DDS_PIXELFORMAT::flags
+static constexpr UINT DdsPixelAlpha = 0x2;
+static constexpr UINT DdsPixelFourCC = 0x4;
+static constexpr UINT DdsPixelRgb = 0x40;
+static constexpr UINT DdsPixelLuminance = 0x20000;
+// -- DDS_HEADER::caps2
+static constexpr UINT DdsCapsCube = 0x200;
+static constexpr UINT DdsCapsCubeAllFaces = 0xFC00;
+static constexpr UINT DdsCapsVolume = 0x200000;
+// -- DDS_HEADER_DXT10::misc_flag
+static constexpr UINT DdsMiscCube = 0x4;
+
+struct DdsPixelFormat {
+    UINT size;
+    UINT flags;
+    UINT four_cc;
+    UINT rgb_bit_count;
+    UINT r_bit_mask;
+    UINT g_bit_mask;
+    UINT b_bit_mask;
+    UINT a_bit_mask;
+};
+struct DdsHeader {
+    UINT size;
+    UINT flags;
+    UINT height;
+    UINT width;
+    UINT pitch_or_linear_size;
+    UINT depth;
+    UINT mipmap_count;
+    UINT reserved1[11];
+    DdsPixelFormat pixel_format;
+    UINT caps;
+    UINT caps2;
+    UINT caps3;
+    UINT caps4;
+    UINT reserved2;
+};
+struct DdsHeaderDxt10 {
+    UINT dxgi_format;
+    UINT resource_dimension;
+    UINT misc_flag;
+    UINT array_size;
+    UINT misc_flags2;
+};
+static_assert(sizeof(DdsPixelFormat) == DdsPixelFormatSize, "dds pixel format layout");
+static_assert(sizeof(DdsHeader) == DdsHeaderSize, "dds header layout");
+static_assert(sizeof(DdsHeaderDxt10) == DdsHeaderDxt10Size, "dds dx10 header layout");
+
+static constexpr UINT
+FourCC (char a, char b, char c, char d) {
+    return
+        static_cast<UINT>(static_cast<UINT8>(a)) |
+        static_cast<UINT>(static_cast<UINT8>(b)) << 8 |
+        static_cast<UINT>(static_cast<UINT8>(c)) << 16 |
+        static_cast<UINT>(static_cast<UINT8>(d)) << 24;
+}
+
+bool IsBlockCompressed (DXGI_FORMAT format) {
+    return 0 != BlockSize(format);
+}
+UINT BlockSize (DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC4_TYPELESS:
+    case DXGI_FORMAT_BC4_UNORM:
+    case DXGI_FORMAT_BC4_SNORM:
+        return 8;
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:
+    case DXGI_FORMAT_BC5_SNORM:
+    case DXGI_FORMAT_BC6H_TYPELESS:
+    case DXGI_FORMAT_BC6H_UF16:
+    case DXGI_FORMAT_BC6H_SF16:
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return 16;
+    default:
+        return 0;
+    }
+}
+UINT BitsPerPixel (DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_SINT:
+        return 128;
+    case DXGI_FORMAT_R32G32B32_TYPELESS:
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+    case DXGI_FORMAT_R32G32B32_UINT:
+    case DXGI_FORMAT_R32G32B32_SINT:
+        return 96;
+    case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R16G16B16A16_UNORM:
+    case DXGI_FORMAT_R16G16B16A16_UINT:
+    case DXGI_FORMAT_R16G16B16A16_SNORM:
+    case DXGI_FORMAT_R16G16B16A16_SINT:
+    case DXGI_FORMAT_R32G32_TYPELESS:
+    case DXGI_FORMAT_R32G32_FLOAT:
+    case DXGI_FORMAT_R32G32_UINT:
+    case DXGI_FORMAT_R32G32_SINT:
+        return 64;
+    case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+    case DXGI_FORMAT_R10G10B10A2_UNORM:
+    case DXGI_FORMAT_R10G10B10A2_UINT:
+    case DXGI_FORMAT_R11G11B10_FLOAT:
+    case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_R8G8B8A8_UINT:
+    case DXGI_FORMAT_R8G8B8A8_SNORM:
+    case DXGI_FORMAT_R8G8B8A8_SINT:
+    case DXGI_FORMAT_R16G16_TYPELESS:
+    case DXGI_FORMAT_R16G16_FLOAT:
+    case DXGI_FORMAT_R16G16_UNORM:
+    case DXGI_FORMAT_R16G16_UINT:
+    case DXGI_FORMAT_R16G16_SNORM:
+    case DXGI_FORMAT_R16G16_SINT:
+    case DXGI_FORMAT_R32_TYPELESS:
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_UINT:
+    case DXGI_FORMAT_R32_SINT:
+    case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+    case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        return 32;
+    case DXGI_FORMAT_R8G8_TYPELESS:
+    case DXGI_FORMAT_R8G8_UNORM:
+    case DXGI_FORMAT_R8G8_UINT:
+    case DXGI_FORMAT_R8G8_SNORM:
+    case DXGI_FORMAT_R8G8_SINT:
+    case DXGI_FORMAT_R16_TYPELESS:
+    case DXGI_FORMAT_R16_FLOAT:
+    case DXGI_FORMAT_R16_UNORM:
+    case DXGI_FORMAT_R16_UINT:
+    case DXGI_FORMAT_R16_SNORM:
+    case DXGI_FORMAT_R16_SINT:
+    case DXGI_FORMAT_B5G6R5_UNORM:
+    case DXGI_FORMAT_B5G5R5A1_UNORM:
+    case DXGI_FORMAT_B4G4R4A4_UNORM:
+        return 16;
+    case DXGI_FORMAT_R8_TYPELESS:
+    case DXGI_FORMAT_R8_UNORM:
+    case DXGI_FORMAT_R8_UINT:
+    case DXGI_FORMAT_R8_SNORM:
+    case DXGI_FORMAT_R8_SINT:
+    case DXGI_FORMAT_A8_UNORM:
+        return 8;
+    default:
+        return 4 * BlockSize(format) / 8;  // -- 4 or 8, 0 if unknown
+    }
+}
+static bool
+MasksAre (DdsPixelFormat const & pf, UINT r, UINT g, UINT b, UINT a) {
+    return
+        pf.r_bit_mask == r && pf.g_bit_mask == g &&
+        pf.b_bit_mask == b && pf.a_bit_mask == a;
+}
+//
+// -- pre-dx10 pixel formats, only the unambiguous ones
+static DXGI_FORMAT
+LegacyFormat (DdsPixelFormat const & pf) {
+    if (pf.flags & DdsPixelFourCC) {
+        switch (pf.four_cc) {
+        case FourCC('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+        case FourCC('D', 'X', 'T', '2'):
+        case FourCC('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+        case FourCC('D', 'X', 'T', '4'):
+        case FourCC('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+        case FourCC('A', 'T', 'I', '1'):
+        case FourCC('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+        case FourCC('B', 'C', '4', 'S'): return DXGI_FORMAT_BC4_SNORM;
+        case FourCC('A', 'T', 'I', '2'):
+        case FourCC('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+        case FourCC('B', 'C', '5', 'S'): return DXGI_FORMAT_BC5_SNORM;
+        // -- D3DFORMAT values stored as fourcc
+        case 36: return DXGI_FORMAT_R16G16B16A16_UNORM;
+        case 110: return DXGI_FORMAT_R16G16B16A16_SNORM;
+        case 111: return DXGI_FORMAT_R16_FLOAT;
+        case 112: return DXGI_FORMAT_R16G16_FLOAT;
+        case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        case 114: return DXGI_FORMAT_R32_FLOAT;
+        case 115: return DXGI_FORMAT_R32G32_FLOAT;
+        case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+        default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+    if (pf.flags & DdsPixelRgb) {
+        if (32 == pf.rgb_bit_count) {
+            if (MasksAre(pf, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000))
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            if (MasksAre(pf, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000))
+                return DXGI_FORMAT_B8G8R8A8_UNORM;
+            if (MasksAre(pf, 0x00FF0000, 0x0000FF00, 0x000000FF, 0))
+                return DXGI_FORMAT_B8G8R8X8_UNORM;
+            if (MasksAre(pf, 0x0000FFFF, 0xFFFF0000, 0, 0))
+                return DXGI_FORMAT_R16G16_UNORM;
+            if (MasksAre(pf, 0xFFFFFFFF, 0, 0, 0))
+                return DXGI_FORMAT_R32_FLOAT;
+        } else if (16 == pf.rgb_bit_count) {
+            if (MasksAre(pf, 0xF800, 0x07E0, 0x001F, 0))
+                return DXGI_FORMAT_B5G6R5_UNORM;
+            if (MasksAre(pf, 0x7C00, 0x03E0, 0x001F, 0x8000))
+                return DXGI_FORMAT_B5G5R5A1_UNORM;
+            if (MasksAre(pf, 0x0F00, 0x00F0, 0x000F, 0xF000))
+                return DXGI_FORMAT_B4G4R4A4_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    if (pf.flags & DdsPixelLuminance) {
+        if (8 == pf.rgb_bit_count && MasksAre(pf, 0xFF, 0, 0, 0))
+            return DXGI_FORMAT_R8_UNORM;
+        if (16 == pf.rgb_bit_count && MasksAre(pf, 0xFFFF, 0, 0, 0))
+            return DXGI_FORMAT_R16_UNORM;
+        if (16 == pf.rgb_bit_count && MasksAre(pf, 0x00FF, 0, 0, 0xFF00))
+            return DXGI_FORMAT_R8G8_UNORM;
+        return DXGI_FORMAT_UNKNOWN;
+    }
+    if (pf.flags & DdsPixelAlpha) {
+        if (8 == pf.rgb_bit_count && MasksAre(pf, 0, 0, 0, 0xFF))
+            return DXGI_FORMAT_A8_UNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+static void
+MipLayout (DdsInfo const & info, UINT mip, DdsMip * out) {
+    out->width = std::max(info.width >> mip, 1u);
+    out->height = std::max(info.height >> mip, 1u);
+    out->depth = std::max(info.depth >> mip, 1u);
+    UINT const block_size = BlockSize(info.format);
+    if (0 != block_size) {
+        out->row_pitch = std::max((out->width + 3) / 4, 1u) * block_size;
+        out->row_count = std::max((out->height + 3) / 4, 1u);
+    } else {
+        out->row_pitch = (out->width * BitsPerPixel(info.format) + 7) / 8;
+        out->row_count = out->height;
+    }
+    out->size = UINT64(out->row_pitch) * out->row_count * out->depth;
+}
+static UINT
+FullMipCount (UINT width, UINT height, UINT depth) {
+    UINT largest = std::max(width, std::max(height, depth));
+    UINT count = 1;
+    while (largest > 1) {
+        largest >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+HRESULT ParseDdsHeader (UINT8 const * data, UINT size, DdsInfo * info) {
+    HRESULT const invalid = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    HRESULT const unsupported = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    if (nullptr == data || nullptr == info)
+        return E_INVALIDARG;
+    if (size < sizeof(UINT) + sizeof(DdsHeader))
+        return invalid;
+    UINT magic = 0;
+    memcpy(&magic, data, sizeof(magic));
+    if (DdsMagic != magic)
+        return invalid;
+    DdsHeader header;
+    memcpy(&header, data + sizeof(UINT), sizeof(header));
+    if (
+        sizeof(DdsHeader) != header.size ||
+        sizeof(DdsPixelFormat) != header.pixel_format.size
+    ) {
+        return invalid;
+    }
+
+    *info = {};
+    info->width = header.width;
+    info->height = header.height;
+    info->depth = 1;
+    info->array_size = 1;
+    info->mip_count =
+        (header.flags & DdsFlagMipCount) ? std::max(header.mipmap_count, 1u) : 1;
+    info->data_offset = sizeof(UINT) + sizeof(DdsHeader);
+
+    bool const dx10 =
+        (header.pixel_format.flags & DdsPixelFourCC) &&
+        FourCC('D', 'X', '1', '0') == header.pixel_format.four_cc;
+    if (dx10) {
+        if (size < DdsMaxHeaderSize)
+            return invalid;
+        DdsHeaderDxt10 ext;
+        memcpy(&ext, data + info->data_offset, sizeof(ext));
+        info->data_offset += sizeof(DdsHeaderDxt10);
+        info->format = static_cast<DXGI_FORMAT>(ext.dxgi_format);
+        info->array_size = ext.array_size;
+        if (0 == info->array_size)
+            return invalid;
+        switch (ext.resource_dimension) {
+        case D3D12_RESOURCE_DIMENSION_TEXTURE1D:
+            if (1 != info->height && 0 != info->height)
+                return invalid;
+            info->height = 1;
+            break;
+        case D3D12_RESOURCE_DIMENSION_TEXTURE2D:
+            if (ext.misc_flag & DdsMiscCube) {
+                // -- checked before the faces multiply it (it would wrap)
+                if (ext.array_size > DdsMaxArraySize / 6)
+                    return invalid;
+                info->cube = true;
+                info->array_size *= 6;
+            }
+            break;
+        case D3D12_RESOURCE_DIMENSION_TEXTURE3D:
+            if (0 == (header.flags & DdsFlagDepth) || 1 != info->array_size)
+                return invalid;
+            info->depth = header.depth;
+            break;
+        default:
+            return invalid;
+        }
+        info->dimension =
+            static_cast<D3D12_RESOURCE_DIMENSION>(ext.resource_dimension);
+    } else {
+        info->format = LegacyFormat(header.pixel_format);
+        info->dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+        if (header.caps2 & DdsCapsVolume) {
+            if (0 == (header.flags & DdsFlagDepth))
+                return invalid;
+            info->dimension = D3D12_RESOURCE_DIMENSION_TEXTURE3D;
+            info->depth = header.depth;
+        } else if (header.caps2 & DdsCapsCube) {
+            // NOTE(omid): partial cubes can not be created in d3d12
+            if (DdsCapsCubeAllFaces != (header.caps2 & DdsCapsCubeAllFaces))
+                return unsupported;
+            info->cube = true;
+            info->array_size = 6;
+        }
+    }
+    if (0 == BitsPerPixel(info->format))
+        return unsupported;
+
+    if (
+        0 == info->width || info->width > DdsMaxDimension ||
+        0 == info->height || info->height > DdsMaxDimension ||
+        0 == info->depth || info->depth > DdsMaxDimension ||
+        info->array_size > DdsMaxArraySize
+    ) {
+        return invalid;
+    }
+    if (
+        info->mip_count > D3D12_REQ_MIP_LEVELS ||
+        info->mip_count > FullMipCount(info->width, info->height, info->depth)
+    ) {
+        return invalid;
+    }
+
+    info->item_size = GetDdsMipRangeSize(*info, 0, info->mip_count);
+    info->data_size = info->item_size * info->array_size;
+    return S_OK;
+}
+void GetDdsMip (DdsInfo const & info, UINT item, UINT mip, DdsMip * out) {
+    assert(item < info.array_size && mip < info.mip_count);
+    MipLayout(info, mip, out);
+    out->offset =
+        info.data_offset + item * info.item_size +
+        GetDdsMipRangeSize(info, 0, mip);
+}
+UINT64 GetDdsMipRangeSize (DdsInfo const & info, UINT first_mip, UINT mip_count) {
+    assert(first_mip + mip_count <= info.mip_count);
+    UINT64 size = 0;
+    for (UINT mip = first_mip; mip < first_mip + mip_count; ++mip) {
+        DdsMip layout;
+        MipLayout(info, mip, &layout);
+        size += layout.size;
+    }
+    return size;
+}
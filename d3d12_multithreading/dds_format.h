@@ -0,0 +1,63 @@
+#pragma once
+
+// NOTE(omid): DDS header parsing and subresource layout
+/*
+    magic
+    DDS_HEADER
+    DDS_HEADER_DXT10    -- only when the pixel format's fourcc is "DX10"
+    texels              -- for each array item (6 per cube): for each mip:
+                           depth slices of row_count rows of row_pitch bytes
+
+    Only the headers are parsed here, the texels are located but never
+    touched, so a reader can fetch the header bytes first and then read
+    just the mips it needs (see DdsReader).
+*/
+
+static constexpr UINT DdsMagic = 0x20534444;    // -- "DDS "
+static constexpr UINT DdsHeaderSize = 124;
+static constexpr UINT DdsPixelFormatSize = 32;
+static constexpr UINT DdsHeaderDxt10Size = 20;
+// -- enough bytes to parse any header
+static constexpr UINT DdsMaxHeaderSize =
+    sizeof(UINT) + DdsHeaderSize + DdsHeaderDxt10Size;
+static constexpr UINT DdsMaxDimension = 16384;
+
+struct DdsInfo {
+    D3D12_RESOURCE_DIMENSION dimension;
+    DXGI_FORMAT format;
+    UINT width;
+    UINT height;
+    UINT depth;
+    UINT mip_count;
+    UINT array_size;        // -- includes the 6 faces of each cube
+    bool cube;
+    UINT64 data_offset;     // -- file offset of the first texel
+    UINT64 item_size;       // -- one array item with its whole mip chain
+    UINT64 data_size;       // -- all array items
+};
+
+// -- one subresource in the file
+struct DdsMip {
+    UINT64 offset;          // -- absolute file offset
+    UINT64 size;            // -- row_pitch * row_count * depth
+    UINT width;
+    UINT height;
+    UINT depth;
+    UINT row_pitch;         // -- tightly packed, no d3d12 pitch alignment
+    UINT row_count;         // -- rows of 4x4 blocks for bc formats
+};
+
+bool IsBlockCompressed (DXGI_FORMAT format);
+// -- bytes per 4x4 block for bc formats, 0 if not one
+UINT BlockSize (DXGI_FORMAT format);
+// -- 0 for formats the reader does not handle
+UINT BitsPerPixel (DXGI_FORMAT format);
+
+//
+// -- validate magic, headers and dimensions, size is how many bytes of the
+// -- file start are available (DdsMaxHeaderSize always suffices)
+HRESULT ParseDdsHeader (UINT8 const * data, UINT size, DdsInfo * info);
+
+void GetDdsMip (DdsInfo const & info, UINT item, UINT mip, DdsMip * out);
+// -- mips [first_mip, first_mip + mip_count) of an item are contiguous
+UINT64 GetDdsMipRangeSize (DdsInfo const & info, UINT first_mip, UINT mip_count);
@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "dds_reader.h"
+
+#include <algorithm>
+
+// -- ReadFile takes a DWORD size, split larger reads
+static constexpr UINT64 MaxReadSize = 1ull << 30;
+
+DdsReader::DdsReader () :
+    file_size_(0), info_{}
+{
+}
+HRESULT DdsReader::Open (LPCWSTR filename) {
+    Close();
+    CREATEFILE2_EXTENDED_PARAMETERS params = {};
+    params.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+    params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    params.dwFileFlags = FILE_FLAG_RANDOM_ACCESS;
+    params.dwSecurityQosFlags = SECURITY_ANONYMOUS;
+    file_.Attach(CreateFile2(
+        filename,
+        GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING,
+        &params
+    ));
+    if (!file_.IsValid())
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    FILE_STANDARD_INFO file_info = {};
+    if (
+        FALSE == GetFileInformationByHandleEx(
+        file_.Get(), FileStandardInfo, &file_info, sizeof(file_info)
+        )) {
+        HRESULT const hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+    file_size_ = static_cast<UINT64>(file_info.EndOfFile.QuadPart);
+
+    // -- only the header bytes, the dx10 extension is there or it is texels
+    UINT8 header[DdsMaxHeaderSize] = {};
+    UINT const header_size =
+        static_cast<UINT>(std::min<UINT64>(file_size_, DdsMaxHeaderSize));
+    HRESULT hr = Read(0, header, header_size);
+    if (SUCCEEDED(hr))
+        hr = ParseDdsHeader(header, header_size, &info_);
+    if (SUCCEEDED(hr) && info_.data_offset + info_.data_size > file_size_)
+        hr = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);    // -- truncated
+    if (FAILED(hr))
+        Close();
+    return hr;
+}
+void DdsReader::Close () {
+    file_.Close();
+    file_size_ = 0;
+    info_ = {};
+}
+HRESULT DdsReader::ReadMips (
+    UINT item, UINT first_mip, UINT mip_count,
+    void * data, UINT64 size
+) const {
+    if (
+        item >= info_.array_size || 0 == mip_count ||
+        first_mip >= info_.mip_count || mip_count > info_.mip_count - first_mip
+    ) {
+        return E_INVALIDARG;
+    }
+    if (size != MipRangeSize(first_mip, mip_count))
+        return E_INVALIDARG;
+    DdsMip first;
+    GetMip(item, first_mip, &first);
+    return Read(first.offset, data, size);
+}
+HRESULT DdsReader::Read (UINT64 offset, void * data, UINT64 size) const {
+    if (!file_.IsValid())
+        return E_FAIL;
+    if (offset > file_size_ || size > file_size_ - offset)
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    UINT8 * dst = static_cast<UINT8 *>(data);
+    while (size > 0) {
+        DWORD const chunk = static_cast<DWORD>(std::min(size, MaxReadSize));
+        // NOTE(omid): the offset in OVERLAPPED makes a synchronous read
+        // positional, the handle's file pointer is left alone
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        if (FALSE == ReadFile(file_.Get(), dst, chunk, &read, &overlapped))
+            return HRESULT_FROM_WIN32(GetLastError());
+        if (read != chunk)
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        dst += chunk;
+        offset += chunk;
+        size -= chunk;
+    }
+    return S_OK;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "dds_format.h"
+
+// NOTE(omid): Streaming DDS reader
+/*
+    Open() reads only the header bytes and validates them against the
+    file size before anything else is read. Texels are then fetched with
+    positional reads, one contiguous range per call, straight into the
+    caller's memory (an upload allocation, a scratch buffer, ...) so the
+    file is never loaded whole and unwanted mips are never touched.
+
+    Reads do not move a shared file pointer, so one reader may be used
+    from several threads at once once Open() returned.
+*/
+
+struct DdsReader {
+private:
+    Microsoft::WRL::Wrappers::FileHandle file_;
+    UINT64 file_size_;
+    DdsInfo info_;
+public:
+    DdsReader ();
+
+    HRESULT Open (LPCWSTR filename);
+    void Close ();
+
+    DdsInfo const & Info () const { return info_; }
+    void GetMip (UINT item, UINT mip, DdsMip * out) const {
+        GetDdsMip(info_, item, mip, out);
+    }
+    UINT64 MipRangeSize (UINT first_mip, UINT mip_count) const {
+        return GetDdsMipRangeSize(info_, first_mip, mip_count);
+    }
+
+    //
+    // -- read mips [first_mip, first_mip + mip_count) of an array item,
+    // -- tightly packed in file order (size must be MipRangeSize)
+    HRESULT ReadMips (
+        UINT item, UINT first_mip, UINT mip_count,
+        void * data, UINT64 size
+    ) const;
+    // -- raw positional read
+    HRESULT Read (UINT64 offset, void * data, UINT64 size) const;
+};
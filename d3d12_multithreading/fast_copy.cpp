@@ -0,0 +1,81 @@
+#include "stdafx.h"
+#include "fast_copy.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FAST_COPY_SSE2 1
+#else
+#define FAST_COPY_SSE2 0
+#endif
+
+#if FAST_COPY_SSE2
+//
+// -- one run of non-temporal stores, caller fences
+static void StreamRun (UINT8 * dst, UINT8 const * src, size_t size) {
+    // -- plain copy up to the first 16 byte aligned destination
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(dst) & 15)) & 15;
+    if (head > size)
+        head = size;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    size -= head;
+
+    // -- 64 bytes (one cache line) per iteration
+    for (; size >= 64; size -= 64, dst += 64, src += 64) {
+        __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 0));
+        __m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 16));
+        __m128i const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 32));
+        __m128i const d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 0), a);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i *>(dst + 48), d);
+    }
+    for (; size >= 16; size -= 16, dst += 16, src += 16)
+        _mm_stream_si128(
+            reinterpret_cast<__m128i *>(dst),
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(src))
+        );
+    memcpy(dst, src, size);
+}
+#endif // FAST_COPY_SSE2
+
+void StreamCopy (void * dst, void const * src, size_t size) {
+#if FAST_COPY_SSE2
+    if (size >= StreamCopyThreshold) {
+        StreamRun(static_cast<UINT8 *>(dst), static_cast<UINT8 const *>(src), size);
+        // -- streaming stores are weakly ordered, publish them before
+        // -- anyone (the queue submission) depends on the data
+        _mm_sfence();
+        return;
+    }
+#endif // FAST_COPY_SSE2
+    memcpy(dst, src, size);
+}
+void CopyRows (
+    void * dst, size_t dst_pitch,
+    void const * src, size_t src_pitch,
+    size_t row_size, UINT row_count
+) {
+    if (0 == row_count)
+        return;
+    if (dst_pitch == row_size && src_pitch == row_size) {
+        StreamCopy(dst, src, row_size * row_count);
+        return;
+    }
+    UINT8 * dst_row = static_cast<UINT8 *>(dst);
+    UINT8 const * src_row = static_cast<UINT8 const *>(src);
+#if FAST_COPY_SSE2
+    // -- short rows end mid cache line and flush partial write-combine
+    // -- buffers on every row, memcpy does better there
+    if (row_size >= StreamRowThreshold) {
+        for (UINT y = 0; y < row_count; ++y, dst_row += dst_pitch, src_row += src_pitch)
+            StreamRun(dst_row, src_row, row_size);
+        _mm_sfence();
+        return;
+    }
+#endif // FAST_COPY_SSE2
+    for (UINT y = 0; y < row_count; ++y, dst_row += dst_pitch, src_row += src_pitch)
+        memcpy(dst_row, src_row, row_size);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// NOTE(omid): Copies into write-combined upload memory
+/*
+    Upload heaps are write-combined: the cpu never reads them back, so
+    caching the destination only evicts useful lines. Large copies use
+    sse2 non-temporal stores that go straight to memory, small ones stay
+    with memcpy. Rows whose pitches match on both sides collapse into one
+    bulk copy.
+*/
+
+// -- below this many bytes streaming stores do not pay off
+static constexpr size_t StreamCopyThreshold = 4096;
+// -- pitched copies stream row by row only when rows are at least this long
+static constexpr size_t StreamRowThreshold = 1024;
+
+//
+// -- copy size bytes, dst is write-only memory
+void StreamCopy (void * dst, void const * src, size_t size);
+
+//
+// -- copy rows of row_size bytes between pitched layouts
+// -- (drop-in for d3dx12's MemcpySubresource on one slice)
+void CopyRows (
+    void * dst, size_t dst_pitch,
+    void const * src, size_t src_pitch,
+    size_t row_size, UINT row_count
+);
@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "fence_retirement.h"
+
+FenceRetirement::FenceRetirement () :
+    retired_count_(0)
+{
+}
+void FenceRetirement::Init (UINT fence_count, UINT item_count) {
+    completed_.assign(fence_count, 0);
+    items_.assign(item_count, Item{0, 0});
+    retired_count_ = 0;
+}
+void FenceRetirement::Track (UINT item, UINT fence, UINT64 value) {
+    if (value <= completed_[fence]) {
+        // -- already passed, nothing to wait for
+        items_[item] = {fence, 0};
+        ++retired_count_;
+        return;
+    }
+    items_[item] = {fence, value};
+}
+UINT FenceRetirement::Retire (UINT fence, UINT64 completed) {
+    if (completed <= completed_[fence])
+        return 0;
+    completed_[fence] = completed;
+    UINT retired = 0;
+    for (Item & item : items_) {
+        if (item.fence == fence && 0 != item.value && item.value <= completed) {
+            item.value = 0;
+            ++retired;
+        }
+    }
+    retired_count_ += retired;
+    return retired;
+}
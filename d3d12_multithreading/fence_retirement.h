@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+// NOTE(omid): Which in-flight items each fence has released
+/*
+    Items (frame resources, ...) are small integer ids picked by the
+    caller, as are fences. Track(item, fence, value) marks an item busy
+    until that fence reaches value, Retire(fence, completed) is fed the
+    fence's completed value whenever someone reads it and frees every item
+    that was waiting on no more than that. Completed values only grow, so
+    feeding an old one is harmless.
+
+    No d3d and no locking in here: FenceWaiter reads the real fences and
+    serializes access.
+*/
+
+struct FenceRetirement {
+private:
+    struct Item {
+        UINT fence;
+        UINT64 value;       // -- 0 once retired
+    };
+    std::vector<UINT64> completed_;
+    std::vector<Item> items_;
+    UINT64 retired_count_;
+public:
+    FenceRetirement ();
+
+    void Init (UINT fence_count, UINT item_count);
+
+    void Track (UINT item, UINT fence, UINT64 value);
+    // -- returns how many items this retired
+    UINT Retire (UINT fence, UINT64 completed);
+
+    bool Retired (UINT item) const { return 0 == items_[item].value; }
+    UINT ItemFence (UINT item) const { return items_[item].fence; }
+    UINT64 ItemValue (UINT item) const { return items_[item].value; }
+    UINT64 Completed (UINT fence) const { return completed_[fence]; }
+    UINT FenceCount () const { return static_cast<UINT>(completed_.size()); }
+    // -- items retired since Init
+    UINT64 RetiredCount () const { return retired_count_; }
+};
@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include "fence_waiter.h"
+
+// -- the device is gone, fences read all ones from then on
+static constexpr UINT64 FenceLost = ~0ull;
+
+FenceWaiter::FenceWaiter () :
+    event_count_(0), wake_(nullptr), quit_(false), stall_ticks_(0)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    frequency_ = frequency.QuadPart;
+}
+FenceWaiter::~FenceWaiter () {
+    Release();
+}
+HRESULT FenceWaiter::Init (
+    ID3D12Fence * const * fences,
+    UINT fence_count,
+    UINT item_count
+) {
+    Release();
+    fences_.assign(fences, fences + fence_count);
+    retirement_.Init(fence_count, item_count);
+    stall_ticks_ = 0;
+
+    // -- one armed event per fence for the thread, one for a blocking wait
+    for (UINT i = 0; i < fence_count + 1; ++i) {
+        HANDLE const event = AcquireEvent();
+        if (nullptr == event)
+            return HRESULT_FROM_WIN32(GetLastError());
+        free_events_.push_back(event);
+    }
+    wake_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (nullptr == wake_)
+        return HRESULT_FROM_WIN32(GetLastError());
+    quit_ = false;
+    thread_ = std::thread(&FenceWaiter::CompletionLoop, this);
+    return S_OK;
+}
+void FenceWaiter::Release () {
+    if (thread_.joinable()) {
+        quit_ = true;
+        SetEvent(wake_);
+        thread_.join();
+    }
+    if (nullptr != wake_)
+        CloseHandle(wake_);
+    wake_ = nullptr;
+    for (HANDLE event : free_events_)
+        CloseHandle(event);
+    free_events_.clear();
+    event_count_ = 0;
+    fences_.clear();
+}
+HANDLE FenceWaiter::AcquireEvent () {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_events_.empty()) {
+            HANDLE const event = free_events_.back();
+            free_events_.pop_back();
+            return event;
+        }
+    }
+    // -- the pool only grows when more waits overlap than ever before
+    HANDLE const event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (nullptr != event) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++event_count_;
+    }
+    return event;
+}
+void FenceWaiter::ReleaseEvent (HANDLE event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_events_.push_back(event);
+}
+bool FenceWaiter::Poll () {
+    bool alive = true;
+    for (UINT i = 0; i < fences_.size(); ++i) {
+        // -- a lost device retires everything, nothing is running anymore
+        UINT64 const completed = fences_[i]->GetCompletedValue();
+        if (FenceLost == completed)
+            alive = false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        retirement_.Retire(i, completed);
+    }
+    return alive;
+}
+void FenceWaiter::CompletionLoop () {
+    UINT const fence_count = static_cast<UINT>(fences_.size());
+    std::vector<HANDLE> handles(fence_count + 1);
+    std::vector<bool> armed(fence_count, false);
+    for (UINT i = 0; i < fence_count; ++i)
+        handles[i] = AcquireEvent();
+    handles[fence_count] = wake_;
+
+    bool alive = true;
+    while (!quit_) {
+        // NOTE(omid): a fence is re-armed only after its event fired,
+        // re-arming an idle one every loop would pile up registrations
+        for (UINT i = 0; alive && i < fence_count; ++i) {
+            if (armed[i] || nullptr == handles[i])
+                continue;
+            UINT64 next = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                next = retirement_.Completed(i) + 1;
+            }
+            armed[i] = SUCCEEDED(fences_[i]->SetEventOnCompletion(next, handles[i]));
+        }
+        // -- after losing the device only the wake event is waited on
+        DWORD const result = alive ?
+            WaitForMultipleObjects(fence_count + 1, handles.data(), FALSE, INFINITE) :
+            WaitForSingleObject(wake_, INFINITE);
+        if (!alive || WAIT_OBJECT_0 + fence_count == result)
+            continue;
+        if (result < WAIT_OBJECT_0 + fence_count)
+            armed[result - WAIT_OBJECT_0] = false;
+        alive = Poll();
+    }
+    // NOTE(omid): events may still be armed at completed + 1, Release() is
+    // only called with the queues idle, so they never fire
+    for (UINT i = 0; i < fence_count; ++i) {
+        if (nullptr != handles[i])
+            ReleaseEvent(handles[i]);
+    }
+}
+void FenceWaiter::Track (UINT item, UINT fence, UINT64 value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retirement_.Track(item, fence, value);
+}
+bool FenceWaiter::Retired (UINT item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retirement_.Retired(item);
+}
+UINT64 FenceWaiter::Completed (UINT fence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retirement_.Completed(fence);
+}
+HRESULT FenceWaiter::WaitForItem (UINT item) {
+    UINT fence = 0;
+    UINT64 value = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (retirement_.Retired(item))
+            return S_OK;
+        fence = retirement_.ItemFence(item);
+        value = retirement_.ItemValue(item);
+    }
+    return Wait(fence, value);
+}
+HRESULT FenceWaiter::Wait (UINT fence, UINT64 value) {
+    if (Completed(fence) >= value)
+        return S_OK;
+    // -- the thread may just not have caught up yet
+    UINT64 const completed = fences_[fence]->GetCompletedValue();
+    if (completed >= value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retirement_.Retire(fence, completed);
+        return S_OK;
+    }
+    LARGE_INTEGER start, end;
+    QueryPerformanceCounter(&start);
+    HANDLE const event = AcquireEvent();
+    if (nullptr == event)
+        return HRESULT_FROM_WIN32(GetLastError());
+    HRESULT const hr = fences_[fence]->SetEventOnCompletion(value, event);
+    if (SUCCEEDED(hr))
+        WaitForSingleObject(event, INFINITE);
+    ReleaseEvent(event);
+    QueryPerformanceCounter(&end);
+    stall_ticks_ += end.QuadPart - start.QuadPart;
+    if (FAILED(hr))
+        return hr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    retirement_.Retire(fence, fences_[fence]->GetCompletedValue());
+    return S_OK;
+}
+double FenceWaiter::TakeStallTime () {
+    return stall_ticks_.exchange(0) * 1000.0 / frequency_;
+}
+UINT FenceWaiter::EventCount () {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return event_count_;
+}
+UINT64 FenceWaiter::RetiredCount () {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return retirement_.RetiredCount();
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "fence_retirement.h"
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Fence waits without creating an event per wait
+/*
+    Wait objects come from a pool that only grows (a handful of events for
+    the life of the app). A completion thread keeps one pooled event armed
+    per fence, at the fence's completed value + 1, and every time one
+    fires it reads the fences and retires what they released (see
+    FenceRetirement). Most of the time the main thread then finds its
+    frame resource already retired and does not touch the fence at all.
+    When it does have to block, the time spent blocked is added to the
+    stall time.
+
+    The waiter holds a reference to each fence, Release() it only once
+    the queues signaling them are idle.
+*/
+
+struct FenceWaiter {
+private:
+    std::vector<ComPtr<ID3D12Fence>> fences_;
+    std::mutex mutex_;              // -- retirement_ and free_events_
+    FenceRetirement retirement_;
+    std::vector<HANDLE> free_events_;
+    UINT event_count_;              // -- created, in or out of the pool
+    std::thread thread_;
+    HANDLE wake_;                   // -- stops the completion thread
+    std::atomic<bool> quit_;
+    LONGLONG frequency_;
+    std::atomic<LONGLONG> stall_ticks_;
+
+    HANDLE AcquireEvent ();
+    void ReleaseEvent (HANDLE event);
+    // -- read every fence and retire, false once the device is gone
+    bool Poll ();
+    void CompletionLoop ();
+public:
+    FenceWaiter ();
+    ~FenceWaiter ();
+
+    HRESULT Init (ID3D12Fence * const * fences, UINT fence_count, UINT item_count);
+    void Release ();
+
+    void Track (UINT item, UINT fence, UINT64 value);
+    bool Retired (UINT item);
+    UINT64 Completed (UINT fence);
+    //
+    // -- block until the item / fence value is done, using a pooled event
+    HRESULT WaitForItem (UINT item);
+    HRESULT Wait (UINT fence, UINT64 value);
+
+    // -- ms spent blocked in waits since the last call
+    double TakeStallTime ();
+    UINT EventCount ();
+    UINT64 RetiredCount ();
+};
@@ -0,0 +1,59 @@
+#include "stdafx.h"
+#include "frame_constants.h"
+
+FrameConstants::FrameConstants () :
+    cpu_(nullptr), gpu_(0)
+{
+}
+FrameConstants::~FrameConstants () {
+    Release();
+}
+HRESULT FrameConstants::Init (ID3D12Device * device, UINT64 size, LPCWSTR name) {
+    Release();
+    size = (size + ChunkSize - 1) / ChunkSize * ChunkSize;
+    HRESULT hr = device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(size),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&buffer_)
+    );
+    if (FAILED(hr))
+        return hr;
+    buffer_->SetName(name);
+
+    // -- stays mapped for the lifetime of the buffer
+    CD3DX12_RANGE read_range(0, 0);
+    hr = buffer_->Map(0, &read_range, reinterpret_cast<void **>(&cpu_));
+    if (FAILED(hr)) {
+        buffer_.Reset();
+        return hr;
+    }
+    gpu_ = buffer_->GetGPUVirtualAddress();
+    allocator_.Init(size, ChunkSize);
+    return S_OK;
+}
+void FrameConstants::Release () {
+    if (nullptr != buffer_)
+        buffer_->Unmap(0, nullptr);
+    buffer_.Reset();
+    cpu_ = nullptr;
+    gpu_ = 0;
+    allocator_.Init(0, ChunkSize);
+}
+bool FrameConstants::Allocate (
+    ConstantCursor * cursor,
+    UINT64 size,
+    ConstantAllocation * allocation
+) {
+    UINT64 offset = 0;
+    if (!allocator_.Allocate(
+        cursor, size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, &offset
+    )) {
+        return false;
+    }
+    allocation->cpu = cpu_ + offset;
+    allocation->gpu = gpu_ + offset;
+    return true;
+}
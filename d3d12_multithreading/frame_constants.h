@@ -0,0 +1,59 @@
+#pragma once
+
+#include "linear_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Per-frame constants, bound by gpu virtual address
+/*
+    One persistently mapped upload buffer per frame resource, carved up
+    by a LinearAllocator: workers write per-draw (or per-instance)
+    constants into it from their own chunk, no locks, and bind them as
+    root cbvs. Reset() once the frame's fence has completed, the whole
+    buffer comes back at once.
+
+    Allocations are 256 byte aligned as root cbvs require. The memory is
+    write-combined, write it once, sequentially, and never read it back.
+*/
+
+// -- a thread's chunk, zero it when the thread starts recording the frame
+typedef LinearAllocator::Cursor ConstantCursor;
+
+struct ConstantAllocation {
+    UINT8 * cpu;                // -- write-combined
+    D3D12_GPU_VIRTUAL_ADDRESS gpu;
+};
+
+struct FrameConstants {
+private:
+    ComPtr<ID3D12Resource> buffer_;
+    UINT8 * cpu_;
+    D3D12_GPU_VIRTUAL_ADDRESS gpu_;
+    LinearAllocator allocator_;
+public:
+    static constexpr UINT64 ChunkSize = 64 * 1024;
+
+    FrameConstants ();
+    ~FrameConstants ();
+
+    HRESULT Init (ID3D12Device * device, UINT64 size, LPCWSTR name);
+    void Release ();
+    // -- only once the gpu is done with the frame
+    void Reset () { allocator_.Reset(); }
+
+    bool Allocate (ConstantCursor * cursor, UINT64 size, ConstantAllocation * allocation);
+    //
+    // -- allocate and copy in one go, returns the address to bind (0 if full)
+    template <typename T>
+    D3D12_GPU_VIRTUAL_ADDRESS Write (ConstantCursor * cursor, T const & data) {
+        ConstantAllocation allocation;
+        if (!Allocate(cursor, sizeof(T), &allocation))
+            return 0;
+        memcpy(allocation.cpu, &data, sizeof(T));
+        return allocation.gpu;
+    }
+
+    UINT64 Size () const { return allocator_.Size(); }
+    UINT64 UsedSize () const { return allocator_.UsedSize(); }
+    UINT Refills () const { return allocator_.Refills(); }
+};
@@ -4,6 +4,9 @@
 #include "camera.h"
 #include "odx_helper.h"
 #include "odx_multithreading.h"
+#include "frame_constants.h"
+#include "command_pool.h"
+#include "shadow_maps.h"
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -12,28 +15,40 @@ struct FrameResource {
 private:
     ComPtr<ID3D12PipelineState> pso_;
     ComPtr<ID3D12PipelineState> pso_smap_;
-    ComPtr<ID3D12Resource> shadow_tex_;
+    // -- the shadow map (atlas) acquired for this frame, see Init
+    ID3D12Resource * shadow_tex_;
     D3D12_CPU_DESCRIPTOR_HANDLE shadow_depth_view_;
-    ComPtr<ID3D12Resource> shadow_cbuffer_;
-    ComPtr<ID3D12Resource> scene_cbuffer_;
-    SceneCBuffer * shadow_cbuffer_write_only_ptr_;
-    SceneCBuffer * scene_cbuffer_write_only_ptr_;
+    D3D12_GPU_DESCRIPTOR_HANDLE shadow_depth_handle_;
+    UINT shadow_map_index_;
+    // -- each light's tile of the shadow atlas
+    D3D12_VIEWPORT shadow_viewports_[NumLights];
+    D3D12_RECT shadow_scissors_[NumLights];
+    // -- one slot per ConstantBlock (per light for the shadow pass),
+    // -- each rewritten only when its version moved
+    ComPtr<ID3D12Resource> cbuffer_;
+    UINT8 * cbuffer_write_only_ptr_;
+    ConstantBlockCopy cbuffer_blocks_;
     // -- use a null srv for out of bounds behavior
     D3D12_GPU_DESCRIPTOR_HANDLE null_srv_handle_;
-    D3D12_GPU_DESCRIPTOR_HANDLE shadow_depth_handle_;
-    D3D12_GPU_DESCRIPTOR_HANDLE shadow_cbv_handle_;
-    D3D12_GPU_DESCRIPTOR_HANDLE scene_cbv_handle_;
-public:
-    ID3D12CommandList * batch_submit_ [NumContexts * 2 + CmdlistCount];
+    // -- allocators and lists acquired from the pool for this frame
+    CommandRecord records_[CmdlistCount + ShadowCmdlistCount + NumContexts];
 
-    ComPtr<ID3D12CommandAllocator> cmdallocs_[CmdlistCount];
-    ComPtr<ID3D12GraphicsCommandList> cmdlists_[CmdlistCount];
+    // -- element picks the light's slot in the shadow pass block
+    D3D12_GPU_VIRTUAL_ADDRESS CBufferAddress (UINT block, UINT element = 0) const {
+        return cbuffer_->GetGPUVirtualAddress() + cbuffer_blocks_.Offset(block, element);
+    }
+public:
+    // -- Pre, shadow lists, Mid, scene lists, Post
+    ID3D12CommandList * batch_submit_ [CmdlistCount + ShadowCmdlistCount + NumContexts];
 
-    ComPtr<ID3D12CommandAllocator> shadow_cmdallocs_[NumContexts];
-    ComPtr<ID3D12GraphicsCommandList> shadow_cmdlists_[NumContexts];
+    // -- valid between Init and Retire (owned by records_),
+    // -- shadow lists are indexed light * NumContexts + context
+    ID3D12GraphicsCommandList * cmdlists_[CmdlistCount];
+    ID3D12GraphicsCommandList * shadow_cmdlists_[ShadowCmdlistCount];
+    ID3D12GraphicsCommandList * scene_cmdlists_[NumContexts];
 
-    ComPtr<ID3D12CommandAllocator> scene_cmdallocs_[NumContexts];
-    ComPtr<ID3D12GraphicsCommandList> scene_cmdlists_[NumContexts];
+    // -- per-draw constants, reset once fence_value_ has completed
+    FrameConstants constants_;
 
     UINT64 fence_value_;
 
@@ -41,27 +56,40 @@ public:
         ID3D12Device * device,
         ID3D12PipelineState * pso,
         ID3D12PipelineState * shadow_pso,
-        ID3D12DescriptorHeap * dsv_heap,
         ID3D12DescriptorHeap * cbv_srv_heap,
-        D3D12_VIEWPORT * viewport,
-        UINT frame_resource_index
+        ShadowAtlas const & shadow_atlas,
+        UINT64 constants_size
     );
     ~FrameResource ();
 
+    // -- scene pass: constants, smap and render targets
     void Bind (
         ID3D12GraphicsCommandList * cmdlist,
-        BOOL scene_pass,
         D3D12_CPU_DESCRIPTOR_HANDLE * rtv_handle,
         D3D12_CPU_DESCRIPTOR_HANDLE * dsv_handle
     );
-    void Init ();
+    // -- a light's shadow pass: its constants, atlas tile and the atlas depth
+    void BindShadow (ID3D12GraphicsCommandList * cmdlist, UINT light);
+    // -- acquire the main thread's cmdlists (Pre, Mid, Post), open,
+    // -- and a shadow map (completed is the graphics fence's value),
+    // -- clearing the tiles of the lights drawn (mask) this frame
+    void Init (
+        CommandPool * pool,
+        ShadowMaps * shadow_maps,
+        UINT64 completed,
+        UINT shadow_lights
+    );
+    // -- acquire a worker's shadow lists (lights drawn only) and scene
+    // -- cmdlist, called by the worker
+    void InitWorker (CommandPool * pool, int thread_index, UINT shadow_lights);
+    // -- once the shadow lists are recorded: move Pre, the shadow lists
+    // -- recorded and Mid to the front, returns how many that is
+    UINT PackShadowBatch ();
+    // -- hand them back once submitted under fence_value
+    void Retire (CommandPool * pool, ShadowMaps * shadow_maps, UINT64 fence_value);
     void SwapBarriers ();
     void Finish ();
-    void WriteCBuffers (
-        D3D12_VIEWPORT * viewport,
-        Camera * scene_camera,
-        Camera light_cams [NumLights],
-        LightState lights [NumLights]
-    );
+    // -- returns the bytes written
+    UINT64 WriteCBuffers (ConstantBlocks const & blocks);
 };
 
@@ -0,0 +1,63 @@
+#include "stdafx.h"
+#include "frame_timings.h"
+
+#include <algorithm>
+
+FrameTimings::FrameTimings () :
+    last_(0), phase_ticks_(), worker_setup_ticks_(), worker_shadow_ticks_(),
+    shadow_gpu_ms_(0.0), shadow_gpu_frames_(0), frames_(0)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    frequency_ = frequency.QuadPart;
+}
+void FrameTimings::Start () {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    last_ = now.QuadPart;
+}
+void FrameTimings::Mark (FramePhase phase) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    phase_ticks_[phase] += now.QuadPart - last_;
+    last_ = now.QuadPart;
+}
+bool FrameTimings::Report (char * buffer, size_t size) {
+    if (0 == frames_)
+        return false;
+    double const to_ms = 1000.0 / frequency_ / frames_;
+    double phases[FramePhaseCount];
+    double main = 0.0;
+    for (UINT i = 0; i < FramePhaseCount; ++i) {
+        phases[i] = phase_ticks_[i] * to_ms;
+        main += phases[i];
+    }
+    // -- the slowest worker's setup is what the main thread may wait on
+    LONGLONG worker_max = 0;
+    for (LONGLONG ticks : worker_setup_ticks_)
+        worker_max = std::max(worker_max, ticks);
+    // -- the shadow pass costs all workers' recording, cpu wise
+    LONGLONG shadow_ticks = 0;
+    for (LONGLONG ticks : worker_shadow_ticks_)
+        shadow_ticks += ticks;
+    double const shadow_gpu =
+        shadow_gpu_frames_ > 0 ? shadow_gpu_ms_ / shadow_gpu_frames_ : 0.0;
+    sprintf_s(
+        buffer, size,
+        "frame: main %.3f ms (fence %.3f, update %.3f, begin %.3f, record %.3f, "
+        "shadow lists %.3f, scene lists %.3f, submit %.3f, present %.3f), "
+        "worker setup %.3f ms, shadow pass cpu %.3f ms gpu %.3f ms\n",
+        main,
+        phases[PhaseFrameWait], phases[PhaseUpdate], phases[PhaseBegin],
+        phases[PhaseMainRecord], phases[PhaseShadowLists], phases[PhaseSceneLists],
+        phases[PhaseSubmit], phases[PhasePresent],
+        worker_max * to_ms, shadow_ticks * to_ms, shadow_gpu
+    );
+    memset(phase_ticks_, 0, sizeof(phase_ticks_));
+    memset(worker_setup_ticks_, 0, sizeof(worker_setup_ticks_));
+    memset(worker_shadow_ticks_, 0, sizeof(worker_shadow_ticks_));
+    shadow_gpu_ms_ = 0.0;
+    shadow_gpu_frames_ = 0;
+    frames_ = 0;
+    return true;
+}
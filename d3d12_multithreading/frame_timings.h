@@ -0,0 +1,57 @@
+#pragma once
+
+// NOTE(omid): Where the main thread's frame time goes
+/*
+    Start() at the top of the frame, then Mark(phase) at the end of each
+    phase adds the time since the previous mark to that phase, so the
+    phases add up to the main thread's whole frame (its critical path).
+    Phases can be marked more than once a frame. Workers report their
+    own setup and shadow recording time separately, each into its own
+    slot. The shadow pass gpu time comes from timestamps, some frames
+    later, so it is averaged over the frames that reported one.
+*/
+
+enum FramePhase {
+    PhaseFrameWait = 0,     // -- blocked on the frame resource's fence
+    PhaseUpdate,            // -- input, camera, lights, constants
+    PhaseBegin,             // -- main thread cmdlists and CmdlistPre
+    PhaseMainRecord,        // -- CmdlistMid and CmdlistPost
+    PhaseShadowLists,       // -- waiting for the workers' shadow lists
+    PhaseSceneLists,        // -- waiting for the workers' scene lists
+    PhaseSubmit,
+    PhasePresent,
+    FramePhaseCount
+};
+
+struct FrameTimings {
+private:
+    LONGLONG frequency_;
+    LONGLONG last_;
+    LONGLONG phase_ticks_[FramePhaseCount];
+    LONGLONG worker_setup_ticks_[NumContexts];
+    LONGLONG worker_shadow_ticks_[NumContexts];
+    double shadow_gpu_ms_;
+    UINT shadow_gpu_frames_;
+    UINT frames_;
+public:
+    FrameTimings ();
+
+    void Start ();
+    void Mark (FramePhase phase);
+    void EndFrame () { ++frames_; }
+    //
+    // -- called by worker thread_index only, ticks from QueryPerformanceCounter
+    void WorkerSetup (int thread_index, LONGLONG ticks) {
+        worker_setup_ticks_[thread_index] += ticks;
+    }
+    void WorkerShadow (int thread_index, LONGLONG ticks) {
+        worker_shadow_ticks_[thread_index] += ticks;
+    }
+    void ShadowGpu (double ms) {
+        shadow_gpu_ms_ += ms;
+        ++shadow_gpu_frames_;
+    }
+
+    // -- per frame averages since the last call, false if no frame ended
+    bool Report (char * buffer, size_t size);
+};
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer () :
+    frequency_(0)
+{
+}
+HRESULT GpuTimer::Init (
+    ID3D12Device * device,
+    ID3D12CommandQueue * queue,
+    UINT slot_count
+) {
+    Release();
+    HRESULT hr = queue->GetTimestampFrequency(&frequency_);
+    if (FAILED(hr))
+        return hr;
+
+    D3D12_QUERY_HEAP_DESC heap_desc = {};
+    heap_desc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heap_desc.Count = 2 * slot_count;
+    hr = device->CreateQueryHeap(&heap_desc, IID_PPV_ARGS(&query_heap_));
+    if (FAILED(hr))
+        return hr;
+    hr = device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(heap_desc.Count * sizeof(UINT64)),
+        D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr,
+        IID_PPV_ARGS(&readback_)
+    );
+    if (FAILED(hr)) {
+        Release();
+        return hr;
+    }
+    pending_.assign(slot_count, false);
+    return S_OK;
+}
+void GpuTimer::Release () {
+    readback_.Reset();
+    query_heap_.Reset();
+    pending_.clear();
+}
+void GpuTimer::Begin (ID3D12GraphicsCommandList * cmdlist, UINT slot) {
+    cmdlist->EndQuery(query_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * slot);
+}
+void GpuTimer::End (ID3D12GraphicsCommandList * cmdlist, UINT slot) {
+    cmdlist->EndQuery(query_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 2 * slot + 1);
+    cmdlist->ResolveQueryData(
+        query_heap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP,
+        2 * slot, 2,
+        readback_.Get(), 2 * slot * sizeof(UINT64)
+    );
+    pending_[slot] = true;
+}
+bool GpuTimer::Read (UINT slot, double * ms) {
+    if (!pending_[slot])
+        return false;
+    pending_[slot] = false;
+    // -- only this slot's pair is read back
+    CD3DX12_RANGE const read_range(
+        2 * slot * sizeof(UINT64), (2 * slot + 2) * sizeof(UINT64)
+    );
+    UINT8 * data = nullptr;
+    if (FAILED(readback_->Map(0, &read_range, reinterpret_cast<void **>(&data))))
+        return false;
+    UINT64 const * ticks = reinterpret_cast<UINT64 const *>(data) + 2 * slot;
+    *ms = ticks[1] > ticks[0] ? (ticks[1] - ticks[0]) * 1000.0 / frequency_ : 0.0;
+    CD3DX12_RANGE const write_range(0, 0);
+    readback_->Unmap(0, &write_range);
+    return true;
+}
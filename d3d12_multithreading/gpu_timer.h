@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Gpu time of a stretch of one queue's work, per slot
+/*
+    Begin and End write a timestamp each (End also resolves the pair into
+    a readback buffer), a slot is a frame resource. Read the slot only
+    once the fence of the frame that wrote it has completed; it returns
+    false if nothing was timed in it since the last read.
+*/
+
+struct GpuTimer {
+private:
+    ComPtr<ID3D12QueryHeap> query_heap_;
+    ComPtr<ID3D12Resource> readback_;
+    std::vector<bool> pending_;
+    UINT64 frequency_;
+public:
+    GpuTimer ();
+
+    HRESULT Init (ID3D12Device * device, ID3D12CommandQueue * queue, UINT slot_count);
+    void Release ();
+
+    void Begin (ID3D12GraphicsCommandList * cmdlist, UINT slot);
+    void End (ID3D12GraphicsCommandList * cmdlist, UINT slot);
+    bool Read (UINT slot, double * ms);
+};
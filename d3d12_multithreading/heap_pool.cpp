@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "heap_pool.h"
+
+HeapPool::HeapPool () :
+    device_(nullptr),
+    type_(D3D12_HEAP_TYPE_DEFAULT),
+    flags_(D3D12_HEAP_FLAG_NONE),
+    heap_size_(DefaultHeapSize)
+{
+}
+void HeapPool::Init (
+    ID3D12Device * device,
+    D3D12_HEAP_TYPE type,
+    D3D12_HEAP_FLAGS flags,
+    UINT64 heap_size
+) {
+    Release();
+    device_ = device;
+    type_ = type;
+    flags_ = flags;
+    heap_size_ = heap_size;
+}
+void HeapPool::Release () {
+    blocks_.clear();
+}
+HRESULT HeapPool::Allocate (
+    UINT64 size,
+    UINT64 alignment,
+    HeapAllocation * allocation
+) {
+    // -- first fit over the heaps
+    for (UINT i = 0; i < blocks_.size(); ++i) {
+        Block & block = blocks_[i];
+        UINT64 offset = 0;
+        if (block.allocator.Allocate(size, alignment, &offset)) {
+            allocation->heap = block.heap.Get();
+            allocation->offset = offset;
+            allocation->size = size;
+            allocation->heap_index = i;
+            return S_OK;
+        }
+    }
+
+    // -- none has room, grow by one heap
+    UINT64 heap_size = heap_size_;
+    while (heap_size < size || heap_size < alignment)
+        heap_size <<= 1;
+    D3D12_HEAP_DESC heap_desc = {};
+    heap_desc.SizeInBytes = heap_size;
+    heap_desc.Properties = CD3DX12_HEAP_PROPERTIES(type_);
+    heap_desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    heap_desc.Flags = flags_;
+    ComPtr<ID3D12Heap> heap;
+    HRESULT const hr = device_->CreateHeap(&heap_desc, IID_PPV_ARGS(&heap));
+    if (FAILED(hr))
+        return hr;
+
+    UINT const index = static_cast<UINT>(blocks_.size());
+    blocks_.emplace_back();
+    Block & block = blocks_[index];
+    block.heap = heap;
+    block.allocator.Init(heap_size, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    UINT64 offset = 0;
+    if (!block.allocator.Allocate(size, alignment, &offset))
+        return E_OUTOFMEMORY;
+    allocation->heap = block.heap.Get();
+    allocation->offset = offset;
+    allocation->size = size;
+    allocation->heap_index = index;
+    return S_OK;
+}
+void HeapPool::Free (HeapAllocation const & allocation) {
+    if (nullptr == allocation.heap)
+        return;
+    assert(allocation.heap_index < blocks_.size());
+    assert(blocks_[allocation.heap_index].heap.Get() == allocation.heap);
+    blocks_[allocation.heap_index].allocator.Free(allocation.offset);
+}
+HRESULT HeapPool::CreateResource (
+    D3D12_RESOURCE_DESC const & desc,
+    D3D12_RESOURCE_STATES initial_state,
+    D3D12_CLEAR_VALUE const * clear_value,
+    ComPtr<ID3D12Resource> * resource,
+    HeapAllocation * allocation
+) {
+    D3D12_RESOURCE_DESC placed_desc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info = {};
+    if (D3D12_RESOURCE_DIMENSION_BUFFER != desc.Dimension && 0 == desc.Alignment) {
+        // NOTE(omid): small textures may use 4KB alignment, the device
+        // reports back 64KB when the texture does not qualify
+        placed_desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = device_->GetResourceAllocationInfo(0, 1, &placed_desc);
+        if (D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT != info.Alignment)
+            placed_desc.Alignment = 0;
+    }
+    if (placed_desc.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+        info = device_->GetResourceAllocationInfo(0, 1, &placed_desc);
+    if (UINT64_MAX == info.SizeInBytes)
+        return E_INVALIDARG;
+
+    HRESULT hr = Allocate(info.SizeInBytes, info.Alignment, allocation);
+    if (FAILED(hr))
+        return hr;
+    hr = device_->CreatePlacedResource(
+        allocation->heap,
+        allocation->offset,
+        &placed_desc,
+        initial_state,
+        clear_value,
+        IID_PPV_ARGS(resource->ReleaseAndGetAddressOf())
+    );
+    if (FAILED(hr)) {
+        Free(*allocation);
+        *allocation = {};
+    }
+    return hr;
+}
+UINT HeapPool::HeapCount () const {
+    return static_cast<UINT>(blocks_.size());
+}
+UINT64 HeapPool::ReservedSize () const {
+    UINT64 size = 0;
+    for (Block const & block : blocks_)
+        size += block.allocator.TotalSize();
+    return size;
+}
+UINT64 HeapPool::UsedSize () const {
+    UINT64 size = 0;
+    for (Block const & block : blocks_)
+        size += block.allocator.UsedSize();
+    return size;
+}
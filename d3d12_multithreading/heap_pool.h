@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+
+#include "buddy_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Placed resources in a few large heaps
+/*
+    Each pool owns a list of ID3D12Heaps of one type and category (buffers,
+    non rt/ds textures, ...) and sub-allocates them with a buddy allocator.
+    New heaps are only created when none of the current ones has room,
+    anything bigger than the default heap size gets a heap of its own.
+    Heaps are kept until Release(), the sample's resources all live as
+    long as the pool does.
+
+    Placed resources do not keep their heap alive, the pool must outlive
+    every resource created from it.
+*/
+
+static constexpr UINT64 DefaultHeapSize = 64ull * 1024 * 1024;
+
+struct HeapAllocation {
+    ID3D12Heap * heap;
+    UINT64 offset;
+    UINT64 size;
+    UINT heap_index;
+};
+
+struct HeapPool {
+private:
+    struct Block {
+        ComPtr<ID3D12Heap> heap;
+        BuddyAllocator allocator;
+    };
+    ID3D12Device * device_;
+    D3D12_HEAP_TYPE type_;
+    D3D12_HEAP_FLAGS flags_;
+    UINT64 heap_size_;
+    std::vector<Block> blocks_;
+public:
+    HeapPool ();
+
+    void Init (
+        ID3D12Device * device,
+        D3D12_HEAP_TYPE type,
+        D3D12_HEAP_FLAGS flags,
+        UINT64 heap_size = DefaultHeapSize
+    );
+    // -- drop every heap, resources placed in them must be gone already
+    void Release ();
+
+    HRESULT Allocate (
+        UINT64 size,
+        UINT64 alignment,
+        HeapAllocation * allocation
+    );
+    void Free (HeapAllocation const & allocation);
+
+    //
+    // -- allocate and create a placed resource in one go
+    // -- (textures try the 4KB small resource alignment first)
+    HRESULT CreateResource (
+        D3D12_RESOURCE_DESC const & desc,
+        D3D12_RESOURCE_STATES initial_state,
+        D3D12_CLEAR_VALUE const * clear_value,
+        ComPtr<ID3D12Resource> * resource,
+        HeapAllocation * allocation
+    );
+
+    UINT HeapCount () const;
+    UINT64 ReservedSize () const;
+    UINT64 UsedSize () const;
+};
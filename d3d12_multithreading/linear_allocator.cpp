@@ -0,0 +1,54 @@
+#include "stdafx.h"
+#include "linear_allocator.h"
+
+#include <algorithm>
+
+static inline UINT64
+AlignUp (UINT64 value, UINT64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+LinearAllocator::LinearAllocator () :
+    size_(0), chunk_size_(LinearChunkAlignment), head_(0), refills_(0)
+{
+}
+void LinearAllocator::Init (UINT64 size, UINT64 chunk_size) {
+    size_ = size;
+    chunk_size_ = AlignUp(std::max<UINT64>(chunk_size, 1), LinearChunkAlignment);
+    Reset();
+}
+void LinearAllocator::Reset () {
+    head_.store(0, std::memory_order_relaxed);
+    refills_.store(0, std::memory_order_relaxed);
+}
+bool LinearAllocator::Allocate (
+    Cursor * cursor,
+    UINT64 size,
+    UINT64 alignment,
+    UINT64 * offset
+) {
+    assert(alignment > 0 && 0 == (alignment & (alignment - 1)));
+    assert(alignment <= LinearChunkAlignment);
+    if (0 == size)
+        return false;
+    UINT64 start = AlignUp(cursor->offset, alignment);
+    if (start + size > cursor->end) {
+        // -- next chunk, a larger one if the allocation alone overflows it
+        // NOTE(omid): relaxed is enough, the head only splits up the range,
+        // the data is published by whatever hands the frame to the gpu
+        UINT64 const chunk =
+            std::max(chunk_size_, AlignUp(size, LinearChunkAlignment));
+        UINT64 const begin = head_.fetch_add(chunk, std::memory_order_relaxed);
+        if (begin >= size_ || chunk > size_ - begin)
+            return false;   // -- the head stays past the end until Reset
+        refills_.fetch_add(1, std::memory_order_relaxed);
+        cursor->end = begin + chunk;
+        start = begin;      // -- chunks start aligned
+    }
+    cursor->offset = start + size;
+    *offset = start;
+    return true;
+}
+UINT64 LinearAllocator::UsedSize () const {
+    return std::min(head_.load(std::memory_order_relaxed), size_);
+}
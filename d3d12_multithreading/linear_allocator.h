@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+// NOTE(omid): Lock-free bump allocator over an abstract range
+/*
+    Threads do not bump the shared head per allocation: each one carves
+    its allocations out of a private chunk (a Cursor it owns, e.g. on its
+    stack) and only touches the shared atomic head to grab the next chunk
+    when that one runs out. So most allocations are a few adds on memory
+    no other thread sees, and contention is one fetch_add per chunk.
+
+    Nothing is freed, Reset() takes the whole range back at once (when
+    whatever reads it, e.g. a frame on the gpu, is done). Cursors from
+    before a Reset are stale and must be reset too.
+
+    The tail of a chunk that cannot fit an allocation is skipped.
+*/
+
+// -- chunk granularity, also the largest alignment an allocation may ask for
+static constexpr UINT64 LinearChunkAlignment = 256;
+
+struct LinearAllocator {
+    // -- one thread's current chunk, zero it to start (or after a Reset)
+    struct Cursor {
+        UINT64 offset;
+        UINT64 end;
+    };
+private:
+    UINT64 size_;
+    UINT64 chunk_size_;
+    std::atomic<UINT64> head_;
+    std::atomic<UINT> refills_;
+public:
+    LinearAllocator ();
+
+    // -- chunk_size is rounded up to LinearChunkAlignment
+    void Init (UINT64 size, UINT64 chunk_size);
+    void Reset ();
+
+    //
+    // -- thread safe as long as each cursor is used by one thread at a time
+    // -- false once the range is exhausted (alignment a power of two)
+    bool Allocate (Cursor * cursor, UINT64 size, UINT64 alignment, UINT64 * offset);
+
+    UINT64 Size () const { return size_; }
+    UINT64 ChunkSize () const { return chunk_size_; }
+    // -- handed out in chunks since the last Reset (allocated and skipped)
+    UINT64 UsedSize () const;
+    // -- chunks grabbed since the last Reset
+    UINT Refills () const { return refills_.load(std::memory_order_relaxed); }
+};
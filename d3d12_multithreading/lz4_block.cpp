@@ -0,0 +1,209 @@
+#include "stdafx.h"
+#include "lz4_block.h"
+
+#include <vector>
+
+static constexpr size_t MinMatch = 4;
+static constexpr size_t LastLiterals = 5;   // -- a block always ends with literals
+static constexpr size_t MatchLimit = 12;    // -- no match may start in the last 12 bytes
+static constexpr size_t MaxOffset = 65535;
+static constexpr UINT HashLog = 14;
+static constexpr size_t WildCopy = 16;    // -- fixed copy size of the decoder fast path
+
+static inline UINT
+Read32 (UINT8 const * p) {
+    UINT value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+static inline UINT
+Hash (UINT sequence) {
+    return (sequence * 2654435761u) >> (32 - HashLog);
+}
+//
+// -- length over 15 continues in bytes of 255
+static inline UINT8 *
+WriteLength (UINT8 * op, size_t length) {
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = static_cast<UINT8>(length);
+    return op;
+}
+
+size_t Lz4Compress (void const * src, size_t size, void * dst, size_t capacity) {
+    UINT8 const * const base = static_cast<UINT8 const *>(src);
+    UINT8 const * const end = base + size;
+    UINT8 * op = static_cast<UINT8 *>(dst);
+    UINT8 * const op_end = op + capacity;
+    UINT8 const * anchor = base;
+
+    // -- one sequence, match_length 0 for the trailing literals
+    auto emit = [&] (size_t literals, size_t offset, size_t match_length) -> bool {
+        size_t const worst =
+            1 + literals / 255 + 1 + literals + 2 + match_length / 255 + 1;
+        if (worst > static_cast<size_t>(op_end - op))
+            return false;
+        UINT8 * token = op++;
+        *token = static_cast<UINT8>((literals >= 15 ? 15 : literals) << 4);
+        if (literals >= 15)
+            op = WriteLength(op, literals - 15);
+        if (literals > 0)
+            memcpy(op, anchor, literals);   // -- anchor may be null when empty
+        op += literals;
+        if (0 == match_length)
+            return true;
+        *op++ = static_cast<UINT8>(offset);
+        *op++ = static_cast<UINT8>(offset >> 8);
+        size_t const extra = match_length - MinMatch;
+        *token |= static_cast<UINT8>(extra >= 15 ? 15 : extra);
+        if (extra >= 15)
+            op = WriteLength(op, extra - 15);
+        return true;
+    };
+
+    if (size > MatchLimit) {
+        // -- positions of the last occurrence of each hashed 4 bytes
+        std::vector<UINT> table(size_t(1) << HashLog, 0);
+        UINT8 const * const match_limit = end - MatchLimit;
+        UINT8 const * const extend_limit = end - LastLiterals;
+        UINT8 const * ip = base;
+        while (ip < match_limit) {
+            UINT const sequence = Read32(ip);
+            UINT const h = Hash(sequence);
+            UINT8 const * ref = base + table[h];
+            table[h] = static_cast<UINT>(ip - base);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > MaxOffset || Read32(ref) != sequence) {
+                // -- skip faster through data that does not compress
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            UINT8 const * match_end = ip + MinMatch;
+            UINT8 const * ref_end = ref + MinMatch;
+            while (match_end < extend_limit && *match_end == *ref_end) {
+                ++match_end;
+                ++ref_end;
+            }
+            if (!emit(ip - anchor, ip - ref, match_end - ip))
+                return 0;
+            ip = match_end;
+            anchor = ip;
+            if (ip - 2 > base)
+                table[Hash(Read32(ip - 2))] = static_cast<UINT>(ip - 2 - base);
+        }
+    }
+    if (!emit(end - anchor, 0, 0))
+        return 0;
+    return op - static_cast<UINT8 *>(dst);
+}
+
+bool Lz4Decompress (void const * src, size_t size, void * dst, size_t dst_size) {
+    UINT8 const * ip = static_cast<UINT8 const *>(src);
+    UINT8 const * const ip_end = ip + size;
+    UINT8 * const out = static_cast<UINT8 *>(dst);
+    UINT8 * op = out;
+    UINT8 * const op_end = out + dst_size;
+
+    // -- false when the length runs past the input
+    auto read_length = [&] (size_t * length) -> bool {
+        UINT8 byte;
+        do {
+            if (ip >= ip_end)
+                return false;
+            byte = *ip++;
+            *length += byte;
+        } while (255 == byte);
+        return true;
+    };
+
+    // NOTE(omid): most sequences are a few literals and a short match, so
+    // while both buffers have slack they are copied with fixed size memcpys
+    // (plain moves) that may write past the sequence; the excess is
+    // overwritten by what follows. Only the block tail takes exact copies.
+    for (;;) {
+        if (ip >= ip_end)
+            return false;
+        UINT8 const token = *ip++;
+
+        size_t literals = token >> 4;
+        if (
+            literals < 15 &&
+            static_cast<size_t>(ip_end - ip) >= WildCopy &&
+            static_cast<size_t>(op_end - op) >= WildCopy
+        ) {
+            memcpy(op, ip, WildCopy);
+        } else {
+            if (15 == literals && !read_length(&literals))
+                return false;
+            if (
+                literals > static_cast<size_t>(ip_end - ip) ||
+                literals > static_cast<size_t>(op_end - op)
+            ) {
+                return false;
+            }
+            if (literals > 0)
+                memcpy(op, ip, literals);
+        }
+        op += literals;
+        ip += literals;
+        if (ip == ip_end)
+            break;      // -- the last sequence has no match
+
+        if (ip_end - ip < 2)
+            return false;
+        size_t const offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        if (0 == offset || offset > static_cast<size_t>(op - out))
+            return false;
+        size_t length = token & 15;
+        if (15 == length && !read_length(&length))
+            return false;
+        length += MinMatch;
+        if (length > static_cast<size_t>(op_end - op))
+            return false;
+
+        UINT8 const * match = op - offset;
+        UINT8 * const match_end = op + length;
+        if (static_cast<size_t>(op_end - match_end) < WildCopy) {
+            // -- block tail, exact
+            if (offset >= length) {
+                memcpy(op, match, length);
+                op = match_end;
+            } else {
+                while (op < match_end)
+                    *op++ = *match++;
+            }
+            continue;
+        }
+        if (offset < 8) {
+            // -- short repeats (runs): double the copied period until a
+            // -- whole 8 byte step only reads bytes already written
+            size_t period = offset;
+            while (period < 8 && op < match_end) {
+                memcpy(op, op - period, period);
+                op += period;
+                period *= 2;
+            }
+            match = op - period;
+        }
+        if (static_cast<size_t>(op - match) >= WildCopy) {
+            while (op < match_end) {
+                memcpy(op, match, WildCopy);
+                op += WildCopy;
+                match += WildCopy;
+            }
+        } else {
+            // -- overlapping, but every 8 byte step reads what is written
+            while (op < match_end) {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+            }
+        }
+        op = match_end;
+    }
+    return op == op_end;
+}
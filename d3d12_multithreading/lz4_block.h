@@ -0,0 +1,27 @@
+#pragma once
+
+// NOTE(omid): LZ4 block codec
+/*
+    Reads and writes the reference lz4 *block* format (no frame, no
+    checksums, those are the pack's job): sequences of a token, literals,
+    a 16-bit back offset and a match length, with the last 5 bytes
+    always literals. The compressor is the plain greedy single-hash one,
+    good enough for a cooker; the decoder is the part that matters at load.
+
+    Decoding reads back what it already wrote (matches), so never decode
+    into write-combined memory, decode into cached memory and stream it.
+*/
+
+// -- worst case compressed size of size bytes
+inline size_t
+Lz4CompressBound (size_t size) {
+    return size + size / 255 + 16;
+}
+
+//
+// -- returns the compressed size, 0 if it does not fit in capacity
+size_t Lz4Compress (void const * src, size_t size, void * dst, size_t capacity);
+
+//
+// -- false on malformed input or if it does not decode to exactly dst_size
+bool Lz4Decompress (void const * src, size_t size, void * dst, size_t dst_size);
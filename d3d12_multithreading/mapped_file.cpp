@@ -0,0 +1,63 @@
+#include "stdafx.h"
+#include "mapped_file.h"
+
+MappedFile::MappedFile () :
+    file_(INVALID_HANDLE_VALUE), mapping_(nullptr), data_(nullptr), size_(0)
+{
+}
+MappedFile::~MappedFile () {
+    Close();
+}
+HRESULT MappedFile::Open (LPCWSTR filename) {
+    Close();
+    CREATEFILE2_EXTENDED_PARAMETERS params = {};
+    params.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+    params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+    params.dwFileFlags = FILE_FLAG_SEQUENTIAL_SCAN;
+    params.dwSecurityQosFlags = SECURITY_ANONYMOUS;
+    file_ = CreateFile2(
+        filename,
+        GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING,
+        &params
+    );
+    if (INVALID_HANDLE_VALUE == file_)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    LARGE_INTEGER size = {};
+    if (FALSE == GetFileSizeEx(file_, &size)) {
+        HRESULT const hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+    // -- an empty file can not be mapped, it is not a valid asset either
+    if (0 == size.QuadPart) {
+        Close();
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+    mapping_ = CreateFileMapping(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (nullptr == mapping_) {
+        HRESULT const hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+    data_ = static_cast<UINT8 const *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (nullptr == data_) {
+        HRESULT const hr = HRESULT_FROM_WIN32(GetLastError());
+        Close();
+        return hr;
+    }
+    size_ = static_cast<UINT64>(size.QuadPart);
+    return S_OK;
+}
+void MappedFile::Close () {
+    if (nullptr != data_)
+        UnmapViewOfFile(data_);
+    if (nullptr != mapping_)
+        CloseHandle(mapping_);
+    if (INVALID_HANDLE_VALUE != file_)
+        CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    mapping_ = nullptr;
+    data_ = nullptr;
+    size_ = 0;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// NOTE(omid): Read-only view of a whole file
+/*
+    Nothing is read up front: pages fault in on first touch, and on a warm
+    start they come straight out of the file cache, with no copy into a
+    heap buffer. Pointers into the view stay valid until Close().
+*/
+
+struct MappedFile {
+private:
+    HANDLE file_;
+    HANDLE mapping_;
+    UINT8 const * data_;
+    UINT64 size_;
+public:
+    MappedFile ();
+    ~MappedFile ();
+
+    HRESULT Open (LPCWSTR filename);
+    void Close ();
+
+    UINT8 const * Data () const { return data_; }
+    UINT64 Size () const { return size_; }
+};
@@ -0,0 +1,288 @@
+#include "stdafx.h"
+#include "mesh_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+//
+// -- symmetric 4x4 plane quadric (upper triangle only)
+struct Quadric {
+    double a00, a01, a02, a03;
+    double a11, a12, a13;
+    double a22, a23;
+    double a33;
+};
+static void AddPlane (Quadric * q, double const n[3], double d) {
+    q->a00 += n[0] * n[0]; q->a01 += n[0] * n[1]; q->a02 += n[0] * n[2]; q->a03 += n[0] * d;
+    q->a11 += n[1] * n[1]; q->a12 += n[1] * n[2]; q->a13 += n[1] * d;
+    q->a22 += n[2] * n[2]; q->a23 += n[2] * d;
+    q->a33 += d * d;
+}
+static void AddQuadric (Quadric * q, Quadric const & other) {
+    q->a00 += other.a00; q->a01 += other.a01; q->a02 += other.a02; q->a03 += other.a03;
+    q->a11 += other.a11; q->a12 += other.a12; q->a13 += other.a13;
+    q->a22 += other.a22; q->a23 += other.a23;
+    q->a33 += other.a33;
+}
+// -- sum of squared distances to the accumulated planes
+static double QuadricError (Quadric const & q, float const p[3]) {
+    double const x = p[0];
+    double const y = p[1];
+    double const z = p[2];
+    double const error =
+        q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z + 2.0 * q.a03 * x +
+        q.a11 * y * y + 2.0 * q.a12 * y * z + 2.0 * q.a13 * y +
+        q.a22 * z * z + 2.0 * q.a23 * z +
+        q.a33;
+    return error > 0.0 ? error : 0.0;
+}
+static void TriangleNormal (
+    float const p0[3], float const p1[3], float const p2[3],
+    double n[3]
+) {
+    double const e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double const e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+float SimplifyMesh (
+    StandardVertex const * vertices,
+    UINT const * indices,
+    UINT index_count,
+    UINT target_index_count,
+    float max_error,
+    std::vector<UINT> * out
+) {
+    out->assign(indices, indices + index_count);
+    if (index_count <= target_index_count || index_count < 3)
+        return 0.0f;
+
+    UINT lo = UINT_MAX;
+    UINT hi = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        lo = std::min(lo, indices[i]);
+        hi = std::max(hi, indices[i]);
+    }
+    UINT const vertex_count = hi - lo + 1;
+    std::vector<UINT> & triangles = *out;
+    for (UINT & index : triangles)
+        index -= lo;
+    auto position = [vertices, lo] (UINT v) { return vertices[lo + v].position; };
+
+    // -- weld by position, several vertices on one position is a uv seam
+    std::vector<UINT> position_id(vertex_count);
+    std::vector<bool> locked(vertex_count, false);
+    {
+        struct KeyHash {
+            size_t operator() (std::pair<UINT64, UINT> const & key) const {
+                return std::hash<UINT64>()(key.first) ^ (key.second * 0x9E3779B9u);
+            }
+        };
+        std::unordered_map<std::pair<UINT64, UINT>, UINT, KeyHash> welded;
+        std::vector<UINT> seam_count(vertex_count, 0);
+        std::vector<bool> referenced(vertex_count, false);
+        for (UINT index : triangles)
+            referenced[index] = true;
+        for (UINT v = 0; v < vertex_count; ++v) {
+            UINT bits[3];
+            memcpy(bits, position(v), sizeof(bits));
+            auto const key = std::make_pair(
+                (static_cast<UINT64>(bits[0]) << 32) | bits[1], bits[2]
+            );
+            auto const inserted = welded.insert(std::make_pair(key, v));
+            position_id[v] = inserted.first->second;
+            if (referenced[v])
+                ++seam_count[position_id[v]];
+        }
+        for (UINT v = 0; v < vertex_count; ++v)
+            if (seam_count[position_id[v]] > 1)
+                locked[v] = true;
+
+        // -- an edge without its reverse twin is on an open border
+        std::unordered_map<UINT64, UINT> edges;
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+            for (int k = 0; k < 3; ++k) {
+                UINT64 const a = position_id[triangles[t + k]];
+                UINT64 const b = position_id[triangles[t + (k + 1) % 3]];
+                ++edges[(a << 32) | b];
+            }
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+            for (int k = 0; k < 3; ++k) {
+                UINT const va = triangles[t + k];
+                UINT const vb = triangles[t + (k + 1) % 3];
+                UINT64 const a = position_id[va];
+                UINT64 const b = position_id[vb];
+                if (0 == edges.count((b << 32) | a)) {
+                    locked[va] = true;
+                    locked[vb] = true;
+                }
+            }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count, Quadric {});
+    for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+        float const * p0 = position(triangles[t + 0]);
+        double n[3];
+        TriangleNormal(p0, position(triangles[t + 1]), position(triangles[t + 2]), n);
+        double const length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (0.0 == length)
+            continue;
+        for (int k = 0; k < 3; ++k)
+            n[k] /= length;
+        double const d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        for (int k = 0; k < 3; ++k)
+            AddPlane(&quadrics[triangles[t + k]], n, d);
+    }
+
+    struct Collapse {
+        double error;
+        UINT from;
+        UINT to;
+    };
+    double const max_error_sq = static_cast<double>(max_error) * max_error;
+    double result_error_sq = 0.0;
+    std::vector<Collapse> collapses;
+    std::vector<UINT> adjacency_offset;
+    std::vector<UINT> adjacency;
+    std::vector<UINT> remap(vertex_count);
+    std::vector<bool> touched(vertex_count);
+
+    // -- each pass collapses a batch of cheap, independent edges
+    while (triangles.size() > target_index_count) {
+        UINT const triangle_count = static_cast<UINT>(triangles.size() / 3);
+
+        adjacency_offset.assign(vertex_count + 1, 0);
+        for (UINT index : triangles)
+            ++adjacency_offset[index + 1];
+        for (UINT v = 0; v < vertex_count; ++v)
+            adjacency_offset[v + 1] += adjacency_offset[v];
+        adjacency.resize(triangles.size());
+        {
+            std::vector<UINT> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+            for (UINT i = 0; i < triangles.size(); ++i)
+                adjacency[fill[triangles[i]]++] = i / 3;
+        }
+
+        collapses.clear();
+        for (UINT t = 0; t < triangle_count; ++t)
+            for (int k = 0; k < 3; ++k) {
+                UINT const a = triangles[t * 3 + k];
+                UINT const b = triangles[t * 3 + (k + 1) % 3];
+                if (!locked[a]) {
+                    Quadric q = quadrics[a];
+                    AddQuadric(&q, quadrics[b]);
+                    collapses.push_back({QuadricError(q, position(b)), a, b});
+                }
+                if (!locked[b]) {
+                    Quadric q = quadrics[b];
+                    AddQuadric(&q, quadrics[a]);
+                    collapses.push_back({QuadricError(q, position(a)), b, a});
+                }
+            }
+        std::sort(collapses.begin(), collapses.end(), [] (Collapse const & x, Collapse const & y) {
+            return x.error < y.error;
+        });
+
+        for (UINT v = 0; v < vertex_count; ++v)
+            remap[v] = v;
+        touched.assign(vertex_count, false);
+        UINT removed_triangles = 0;
+        UINT const removable = (static_cast<UINT>(triangles.size()) - target_index_count) / 3;
+        for (Collapse const & collapse : collapses) {
+            if (collapse.error > max_error_sq || removed_triangles >= removable)
+                break;
+            UINT const u = collapse.from;
+            UINT const v = collapse.to;
+            if (touched[u] || touched[v])
+                continue;
+
+            // -- reject collapses that flip a remaining triangle
+            bool flips = false;
+            UINT shared = 0;
+            for (UINT a = adjacency_offset[u]; a < adjacency_offset[u + 1] && !flips; ++a) {
+                UINT const * tri = &triangles[adjacency[a] * 3];
+                if (tri[0] == v || tri[1] == v || tri[2] == v) {
+                    ++shared;
+                    continue;
+                }
+                float const * p[3];
+                float const * q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = position(tri[k]);
+                    q[k] = tri[k] == u ? position(v) : p[k];
+                }
+                double before[3];
+                double after[3];
+                TriangleNormal(p[0], p[1], p[2], before);
+                TriangleNormal(q[0], q[1], q[2], after);
+                // -- also reject normals turning by more than ~75 degrees,
+                // -- those collapses leave slivers along locked borders
+                double const dot =
+                    before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                double const lengths = sqrt(
+                    (before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                    (after[0] * after[0] + after[1] * after[1] + after[2] * after[2])
+                );
+                flips = dot <= 0.25 * lengths;
+            }
+            if (flips)
+                continue;
+
+            remap[u] = v;
+            AddQuadric(&quadrics[v], quadrics[u]);
+            result_error_sq = std::max(result_error_sq, collapse.error);
+            removed_triangles += shared;
+            // -- triangles around u changed, leave them alone for this pass
+            for (UINT a = adjacency_offset[u]; a < adjacency_offset[u + 1]; ++a) {
+                UINT const * tri = &triangles[adjacency[a] * 3];
+                for (int k = 0; k < 3; ++k)
+                    touched[tri[k]] = true;
+            }
+        }
+        if (0 == removed_triangles)
+            break;  // -- nothing cheap enough left
+
+        size_t write = 0;
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+            UINT const a = remap[triangles[t + 0]];
+            UINT const b = remap[triangles[t + 1]];
+            UINT const c = remap[triangles[t + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            triangles[write++] = a;
+            triangles[write++] = b;
+            triangles[write++] = c;
+        }
+        triangles.resize(write);
+    }
+    for (UINT & index : triangles)
+        index += lo;
+    return static_cast<float>(sqrt(result_error_sq));
+}
+UINT SelectLod (
+    PackDraw const & draw,
+    CullFrustum const & frustum,
+    UINT current_lod
+) {
+    if (0 == draw.lod_count)
+        return 0;
+    float const d[3] = {
+        draw.bounds_center[0] - frustum.eye[0],
+        draw.bounds_center[1] - frustum.eye[1],
+        draw.bounds_center[2] - frustum.eye[2],
+    };
+    float const distance = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if (distance <= draw.bounds_radius)
+        return 0;   // -- camera inside the bounds
+    float const size = draw.bounds_radius * frustum.projection_scale / distance;
+
+    UINT lod = std::min(current_lod, draw.lod_count);
+    // -- only switch once the size is clearly past the threshold
+    while (lod < draw.lod_count && size < LodScreenSizes[lod] * (1.0f - LodHysteresis))
+        ++lod;
+    while (lod > 0 && size > LodScreenSizes[lod - 1] * (1.0f + LodHysteresis))
+        --lod;
+    return lod;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+
+#include "asset_pack.h"
+#include "vertex_compression.h"
+#include "meshlets.h"
+
+// NOTE(omid): Discrete LODs
+/*
+    The cooker simplifies every draw with quadric error metrics, collapsing
+    vertices onto their neighbours (no new vertices, so every LOD keeps
+    indexing the draw's own vertex range). Seams and open borders are
+    locked so uv and silhouette edges do not crack.
+
+    At runtime a draw picks its LOD from the projected size of its bounding
+    sphere, with some hysteresis so it does not flicker across a threshold.
+*/
+
+static constexpr UINT MaxLods = 3;              // -- on top of the full draw
+static constexpr UINT MinLodTriangles = 64;     // -- smaller draws are not simplified
+// -- share of the full draw's triangles each LOD aims for
+static constexpr float LodTriangleRatios[MaxLods] = {0.5f, 0.25f, 0.125f};
+// -- LOD n + 1 is used below LodScreenSizes[n] (sphere radius over half the
+// -- screen height)
+static constexpr float LodScreenSizes[MaxLods] = {0.5f, 0.25f, 0.125f};
+static constexpr float LodHysteresis = 0.1f;
+// -- largest collapse error allowed, relative to the draw's bounding radius
+static constexpr float LodMaxError = 0.05f;
+// -- shadow pass renders this many LODs coarser than its own pick
+static constexpr UINT ShadowLodBias = 1;
+
+//
+// -- simplify draw-relative triangles down to about target_index_count
+// -- returns the largest collapse error (model space distance)
+float SimplifyMesh (
+    StandardVertex const * vertices,   // -- already offset by vertex_base
+    UINT const * indices,
+    UINT index_count,
+    UINT target_index_count,
+    float max_error,
+    std::vector<UINT> * out
+);
+
+//
+// -- next LOD for a draw seen from the frustum's eye
+// -- (0 is the full draw, up to draw.lod_count)
+UINT SelectLod (
+    PackDraw const & draw,
+    CullFrustum const & frustum,
+    UINT current_lod
+);
@@ -0,0 +1,437 @@
+#include "stdafx.h"
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+//
+// -- absolute [first, last] vertex range referenced by a draw
+bool DrawVertexRange (
+    PackDraw const & draw,
+    UINT const * indices,
+    UINT vertex_count,
+    UINT * first,
+    UINT * last
+) {
+    if (0 == draw.index_count)
+        return false;
+    UINT lo = UINT_MAX;
+    UINT hi = 0;
+    for (UINT i = 0; i < draw.index_count; ++i) {
+        UINT const index = indices[draw.index_start + i];
+        lo = std::min(lo, index);
+        hi = std::max(hi, index);
+    }
+    *first = std::min(draw.vertex_base + lo, vertex_count - 1);
+    *last = std::min(draw.vertex_base + hi, vertex_count - 1);
+    return true;
+}
+void BuildVertexGroups (
+    PackDraw const * draws,
+    UINT draw_count,
+    UINT const * indices,
+    UINT vertex_count,
+    std::vector<VertexGroup> * groups
+) {
+    groups->clear();
+    if (0 == vertex_count)
+        return;
+
+    struct Range {
+        UINT first;
+        UINT last;
+        UINT draw;
+    };
+    std::vector<Range> ranges;
+    ranges.reserve(draw_count);
+    for (UINT i = 0; i < draw_count; ++i) {
+        Range range = {0, 0, i};
+        if (DrawVertexRange(draws[i], indices, vertex_count, &range.first, &range.last))
+            ranges.push_back(range);
+    }
+    std::sort(ranges.begin(), ranges.end(), [] (Range const & a, Range const & b) {
+        return a.first < b.first;
+    });
+
+    // -- sweep over sorted ranges, every run of overlapping ranges
+    // -- becomes one group
+    size_t group_begin = 0;
+    while (group_begin < ranges.size()) {
+        VertexGroup group = {};
+        group.first_vertex = ranges[group_begin].first;
+        group.last_vertex = ranges[group_begin].last;
+        size_t group_end = group_begin;
+        while (group_end < ranges.size() && ranges[group_end].first <= group.last_vertex) {
+            group.last_vertex = std::max(group.last_vertex, ranges[group_end].last);
+            group.draws.push_back(ranges[group_end].draw);
+            ++group_end;
+        }
+        groups->push_back(std::move(group));
+        group_begin = group_end;
+    }
+}
+//
+// -- simulate a FIFO post-transform cache (what most hardware looks like)
+VertexCacheStats AnalyzeVertexCache (
+    UINT const * indices,
+    UINT index_count,
+    UINT cache_size
+) {
+    VertexCacheStats stats = {};
+    if (index_count < 3)
+        return stats;
+
+    UINT lo = UINT_MAX;
+    UINT hi = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        lo = std::min(lo, indices[i]);
+        hi = std::max(hi, indices[i]);
+    }
+    // -- timestamp of the miss that brought a vertex in, FIFO evicts the oldest
+    std::vector<UINT> inserted(hi - lo + 1, 0);
+    UINT time = cache_size + 1;
+    UINT misses = 0;
+    UINT unique = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        UINT & stamp = inserted[indices[i] - lo];
+        if (0 == stamp)
+            ++unique;
+        if (time - stamp > cache_size) {
+            stamp = time++;
+            ++misses;
+        }
+    }
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(index_count / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+    return stats;
+}
+//
+// -- scoring from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+static float VertexScore (INT cache_position, UINT live_triangles) {
+    static constexpr float CacheDecayPower = 1.5f;
+    static constexpr float LastTriangleScore = 0.75f;
+    static constexpr float ValenceBoostScale = 2.0f;
+    static constexpr float ValenceBoostPower = 0.5f;
+
+    if (0 == live_triangles)
+        return -1.0f;   // -- nothing left to draw with this vertex
+    float score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // -- used by the previous triangle, slightly penalized so
+            // -- strips do not keep turning back on themselves
+            score = LastTriangleScore;
+        } else {
+            float const scaler = 1.0f / (VertexCacheSize - 3);
+            score = powf(1.0f - (cache_position - 3) * scaler, CacheDecayPower);
+        }
+    }
+    // -- favour vertices with few triangles left to get rid of them
+    score += ValenceBoostScale * powf(static_cast<float>(live_triangles), -ValenceBoostPower);
+    return score;
+}
+void OptimizeVertexCache (UINT * indices, UINT index_count) {
+    UINT const triangle_count = index_count / 3;
+    if (triangle_count < 2)
+        return;
+
+    // -- work on compact local vertex ids
+    UINT lo = UINT_MAX;
+    UINT hi = 0;
+    for (UINT i = 0; i < index_count; ++i) {
+        lo = std::min(lo, indices[i]);
+        hi = std::max(hi, indices[i]);
+    }
+    UINT const vertex_count = hi - lo + 1;
+
+    // -- vertex -> triangle adjacency, first live[v] entries are undrawn
+    std::vector<UINT> live(vertex_count, 0);
+    for (UINT i = 0; i < index_count; ++i)
+        ++live[indices[i] - lo];
+    std::vector<UINT> adjacency_offset(vertex_count + 1, 0);
+    for (UINT v = 0; v < vertex_count; ++v)
+        adjacency_offset[v + 1] = adjacency_offset[v] + live[v];
+    std::vector<UINT> adjacency(index_count);
+    {
+        std::vector<UINT> fill(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (UINT i = 0; i < index_count; ++i)
+            adjacency[fill[indices[i] - lo]++] = i / 3;
+    }
+
+    std::vector<INT> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (UINT v = 0; v < vertex_count; ++v)
+        vertex_score[v] = VertexScore(-1, live[v]);
+    std::vector<float> triangle_score(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    for (UINT t = 0; t < triangle_count; ++t)
+        triangle_score[t] =
+            vertex_score[indices[t * 3 + 0] - lo] +
+            vertex_score[indices[t * 3 + 1] - lo] +
+            vertex_score[indices[t * 3 + 2] - lo];
+
+    std::vector<UINT> output;
+    output.reserve(index_count);
+    UINT cache[VertexCacheSize];
+    UINT cache_count = 0;
+    UINT next_candidate = 0;    // -- dead-end restart cursor
+
+    INT best = 0;
+    for (UINT t = 1; t < triangle_count; ++t)
+        if (triangle_score[t] > triangle_score[best])
+            best = t;
+
+    while (best >= 0) {
+        UINT const triangle = static_cast<UINT>(best);
+        emitted[triangle] = true;
+        // -- room for the three vertices pushed past the end before eviction
+        UINT new_cache[VertexCacheSize + 3];
+        UINT new_count = 0;
+        for (UINT k = 0; k < 3; ++k) {
+            UINT const index = indices[triangle * 3 + k];
+            UINT const v = index - lo;
+            output.push_back(index);
+            new_cache[new_count++] = v;
+
+            // -- drop the triangle from the vertex' live list
+            UINT * list = &adjacency[adjacency_offset[v]];
+            for (UINT a = 0; a < live[v]; ++a)
+                if (list[a] == triangle) {
+                    list[a] = list[live[v] - 1];
+                    --live[v];
+                    break;
+                }
+        }
+        for (UINT c = 0; c < cache_count; ++c) {
+            UINT const v = cache[c];
+            if (v != new_cache[0] && v != new_cache[1] && v != new_cache[2])
+                new_cache[new_count++] = v;
+        }
+
+        // -- evicted vertices lose their cache bonus
+        for (UINT c = VertexCacheSize; c < new_count; ++c)
+            cache_position[new_cache[c]] = -1;
+        cache_count = std::min(new_count, VertexCacheSize);
+        for (UINT c = 0; c < cache_count; ++c) {
+            cache[c] = new_cache[c];
+            cache_position[cache[c]] = static_cast<INT>(c);
+        }
+
+        // -- rescore everything the cache touched and pick the next best
+        best = -1;
+        float best_score = -FLT_MAX;
+        for (UINT c = 0; c < new_count; ++c) {
+            UINT const v = new_cache[c];
+            float const score = VertexScore(cache_position[v], live[v]);
+            float const delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            UINT const * list = &adjacency[adjacency_offset[v]];
+            for (UINT a = 0; a < live[v]; ++a)
+                triangle_score[list[a]] += delta;
+        }
+        for (UINT c = 0; c < cache_count; ++c) {
+            UINT const v = cache[c];
+            UINT const * list = &adjacency[adjacency_offset[v]];
+            for (UINT a = 0; a < live[v]; ++a)
+                if (triangle_score[list[a]] > best_score) {
+                    best_score = triangle_score[list[a]];
+                    best = static_cast<INT>(list[a]);
+                }
+        }
+        if (best < 0) {
+            // -- nothing in the cache has work left, restart anywhere
+            while (next_candidate < triangle_count && emitted[next_candidate])
+                ++next_candidate;
+            if (next_candidate < triangle_count)
+                best = static_cast<INT>(next_candidate);
+        }
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+void OptimizeOverdraw (
+    UINT * indices,
+    UINT index_count,
+    StandardVertex const * vertices,
+    UINT cache_size
+) {
+    UINT const triangle_count = index_count / 3;
+    if (triangle_count < 2)
+        return;
+
+    // -- a triangle that misses on all three vertices starts a new cluster,
+    // -- reordering at those points does not hurt the vertex cache much
+    std::vector<UINT> cluster_start;
+    {
+        UINT lo = UINT_MAX;
+        UINT hi = 0;
+        for (UINT i = 0; i < index_count; ++i) {
+            lo = std::min(lo, indices[i]);
+            hi = std::max(hi, indices[i]);
+        }
+        std::vector<UINT> inserted(hi - lo + 1, 0);
+        UINT time = cache_size + 1;
+        for (UINT t = 0; t < triangle_count; ++t) {
+            UINT misses = 0;
+            for (UINT k = 0; k < 3; ++k) {
+                UINT & stamp = inserted[indices[t * 3 + k] - lo];
+                if (time - stamp > cache_size) {
+                    stamp = time++;
+                    ++misses;
+                }
+            }
+            if (0 == t || 3 == misses)
+                cluster_start.push_back(t);
+        }
+    }
+    UINT const cluster_count = static_cast<UINT>(cluster_start.size());
+    if (cluster_count < 2)
+        return;
+    cluster_start.push_back(triangle_count);
+
+    // -- area weighted centroid and (unnormalized) normal per cluster
+    struct Cluster {
+        float centroid[3];
+        float normal[3];
+        float area;
+        float sort_key;
+        UINT first_triangle;
+        UINT triangle_count;
+    };
+    std::vector<Cluster> clusters(cluster_count);
+    float mesh_centroid[3] = {0.0f, 0.0f, 0.0f};
+    float mesh_area = 0.0f;
+    for (UINT c = 0; c < cluster_count; ++c) {
+        Cluster & cluster = clusters[c];
+        cluster = {};
+        cluster.first_triangle = cluster_start[c];
+        cluster.triangle_count = cluster_start[c + 1] - cluster_start[c];
+        for (UINT t = cluster_start[c]; t < cluster_start[c + 1]; ++t) {
+            float const * p0 = vertices[indices[t * 3 + 0]].position;
+            float const * p1 = vertices[indices[t * 3 + 1]].position;
+            float const * p2 = vertices[indices[t * 3 + 2]].position;
+            float const e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float const e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            // NOTE(omid): front faces wind clockwise in a right handed view,
+            // so the outward normal is the negated cross product
+            float const n[3] = {
+                -(e1[1] * e2[2] - e1[2] * e2[1]),
+                -(e1[2] * e2[0] - e1[0] * e2[2]),
+                -(e1[0] * e2[1] - e1[1] * e2[0]),
+            };
+            float const area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                cluster.centroid[k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+                cluster.normal[k] += n[k];
+            }
+            cluster.area += area;
+        }
+        for (int k = 0; k < 3; ++k)
+            mesh_centroid[k] += cluster.centroid[k];
+        mesh_area += cluster.area;
+        if (cluster.area > 0.0f)
+            for (int k = 0; k < 3; ++k)
+                cluster.centroid[k] /= cluster.area;
+    }
+    if (0.0f == mesh_area)
+        return;     // -- all degenerate, order does not matter
+    for (int k = 0; k < 3; ++k)
+        mesh_centroid[k] /= mesh_area;
+
+    // -- clusters facing away from the center are likely to occlude the rest
+    for (Cluster & cluster : clusters) {
+        float const length = sqrtf(
+            cluster.normal[0] * cluster.normal[0] +
+            cluster.normal[1] * cluster.normal[1] +
+            cluster.normal[2] * cluster.normal[2]
+        );
+        cluster.sort_key = 0.0f;
+        if (length > 0.0f)
+            for (int k = 0; k < 3; ++k)
+                cluster.sort_key +=
+                    (cluster.centroid[k] - mesh_centroid[k]) * cluster.normal[k] / length;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [] (Cluster const & a, Cluster const & b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    std::vector<UINT> output;
+    output.reserve(index_count);
+    for (Cluster const & cluster : clusters)
+        output.insert(
+            output.end(),
+            indices + cluster.first_triangle * 3,
+            indices + (cluster.first_triangle + cluster.triangle_count) * 3
+        );
+    std::copy(output.begin(), output.end(), indices);
+}
+void OptimizeMeshes (
+    StandardVertex * vertices,
+    UINT vertex_count,
+    UINT * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    std::vector<VertexCacheStats> * before,
+    std::vector<VertexCacheStats> * after
+) {
+    before->assign(draw_count, VertexCacheStats {});
+    after->assign(draw_count, VertexCacheStats {});
+    for (UINT i = 0; i < draw_count; ++i) {
+        PackDraw const & draw = draws[i];
+        UINT * draw_indices = indices + draw.index_start;
+        (*before)[i] = AnalyzeVertexCache(draw_indices, draw.index_count, AnalyzeCacheSize);
+        OptimizeVertexCache(draw_indices, draw.index_count);
+        OptimizeOverdraw(
+            draw_indices, draw.index_count,
+            vertices + draw.vertex_base, AnalyzeCacheSize
+        );
+    }
+
+    // -- renumber vertices in the order the optimized draws fetch them,
+    // -- per group since overlapping draws share their vertices
+    std::vector<VertexGroup> groups;
+    BuildVertexGroups(draws, draw_count, indices, vertex_count, &groups);
+    std::vector<UINT> remap;
+    std::vector<StandardVertex> reordered;
+    for (VertexGroup const & group : groups) {
+        UINT const first = group.first_vertex;
+        UINT const count = group.last_vertex - first + 1;
+        remap.assign(count, UINT_MAX);
+        UINT next = 0;
+        for (UINT d : group.draws) {
+            PackDraw const & draw = draws[d];
+            for (UINT k = 0; k < draw.index_count; ++k) {
+                UINT const v = draw.vertex_base + indices[draw.index_start + k] - first;
+                if (UINT_MAX == remap[v])
+                    remap[v] = next++;
+            }
+        }
+        // -- keep unreferenced vertices, at the end of the group
+        for (UINT v = 0; v < count; ++v)
+            if (UINT_MAX == remap[v])
+                remap[v] = next++;
+
+        reordered.resize(count);
+        for (UINT v = 0; v < count; ++v)
+            reordered[remap[v]] = vertices[first + v];
+        std::copy(reordered.begin(), reordered.end(), vertices + first);
+
+        // -- rebase each draw on the lowest vertex it now references
+        for (UINT d : group.draws) {
+            PackDraw & draw = draws[d];
+            UINT * draw_indices = indices + draw.index_start;
+            UINT base = UINT_MAX;
+            for (UINT k = 0; k < draw.index_count; ++k) {
+                draw_indices[k] = first + remap[draw.vertex_base + draw_indices[k] - first];
+                base = std::min(base, draw_indices[k]);
+            }
+            for (UINT k = 0; k < draw.index_count; ++k)
+                draw_indices[k] -= base;
+            draw.vertex_base = base;
+        }
+    }
+    for (UINT i = 0; i < draw_count; ++i)
+        (*after)[i] = AnalyzeVertexCache(
+            indices + draws[i].index_start, draws[i].index_count, AnalyzeCacheSize
+        );
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+
+#include "asset_pack.h"
+#include "vertex_compression.h"
+
+// NOTE(omid): Cooker stage that reorders each draw for the post-transform
+// vertex cache, then for overdraw and finally renumbers vertices in the
+// order they are first fetched.
+
+static constexpr UINT VertexCacheSize = 32;     // -- LRU size the optimizer targets
+static constexpr UINT AnalyzeCacheSize = 16;    // -- FIFO size used for ACMR/ATVR
+
+// -- draws whose vertex ranges overlap, the vertices in [first, last]
+// -- can only be renumbered (or quantized) for all of them at once
+struct VertexGroup {
+    UINT first_vertex;
+    UINT last_vertex;
+    std::vector<UINT> draws;
+};
+
+struct VertexCacheStats {
+    float acmr;     // -- average cache misses per triangle (0.5 .. 3)
+    float atvr;     // -- average transforms per unique vertex (1 is optimal)
+};
+
+bool DrawVertexRange (
+    PackDraw const & draw,
+    UINT const * indices,
+    UINT vertex_count,
+    UINT * first,
+    UINT * last
+);
+void BuildVertexGroups (
+    PackDraw const * draws,
+    UINT draw_count,
+    UINT const * indices,
+    UINT vertex_count,
+    std::vector<VertexGroup> * groups
+);
+
+VertexCacheStats AnalyzeVertexCache (
+    UINT const * indices,
+    UINT index_count,
+    UINT cache_size
+);
+
+//
+// -- Forsyth style greedy triangle reordering, indices are draw-relative
+void OptimizeVertexCache (UINT * indices, UINT index_count);
+
+//
+// -- Tipsify style: split the cache-optimized sequence into clusters at
+// -- cache flushes and emit the outward facing clusters first
+void OptimizeOverdraw (
+    UINT * indices,
+    UINT index_count,
+    StandardVertex const * vertices,   // -- already offset by vertex_base
+    UINT cache_size
+);
+
+//
+// -- run all stages over every draw, renumbering the vertices of each
+// -- vertex group in first-use order (draws' vertex_base gets rebased)
+void OptimizeMeshes (
+    StandardVertex * vertices,
+    UINT vertex_count,
+    UINT * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    std::vector<VertexCacheStats> * before,
+    std::vector<VertexCacheStats> * after
+);
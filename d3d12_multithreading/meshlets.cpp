@@ -0,0 +1,233 @@
+#include "stdafx.h"
+#include "meshlets.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static void Normalize (float v[3]) {
+    float const length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0.0f)
+        for (int k = 0; k < 3; ++k)
+            v[k] /= length;
+}
+static float Dot (float const a[3], float const b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+void BoundingSphere (
+    StandardVertex const * vertices,
+    UINT const * indices,
+    UINT index_count,
+    float center[3],
+    float * radius
+) {
+    // -- sphere around the aabb center, not minimal but cheap and tight
+    // -- enough for clusters of this size
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (UINT i = 0; i < index_count; ++i)
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(lo[k], vertices[indices[i]].position[k]);
+            hi[k] = std::max(hi[k], vertices[indices[i]].position[k]);
+        }
+    float radius_sq = 0.0f;
+    for (int k = 0; k < 3; ++k)
+        center[k] = index_count > 0 ? (lo[k] + hi[k]) * 0.5f : 0.0f;
+    for (UINT i = 0; i < index_count; ++i) {
+        float const * p = vertices[indices[i]].position;
+        float const d[3] = {p[0] - center[0], p[1] - center[1], p[2] - center[2]};
+        radius_sq = std::max(radius_sq, Dot(d, d));
+    }
+    *radius = sqrtf(radius_sq);
+}
+//
+// -- sphere and normal cone of one meshlet's triangles
+static void ComputeBounds (
+    StandardVertex const * vertices,
+    UINT const * indices,
+    UINT index_count,
+    PackMeshlet * meshlet
+) {
+    BoundingSphere(vertices, indices, index_count, meshlet->center, &meshlet->radius);
+
+    // NOTE(omid): front faces wind clockwise in a right handed view,
+    // so the outward normal is the negated cross product
+    UINT const triangle_count = index_count / 3;
+    std::vector<float> normals(triangle_count * 3, 0.0f);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (UINT t = 0; t < triangle_count; ++t) {
+        float const * p0 = vertices[indices[t * 3 + 0]].position;
+        float const * p1 = vertices[indices[t * 3 + 1]].position;
+        float const * p2 = vertices[indices[t * 3 + 2]].position;
+        float const e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        float const e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float * n = &normals[t * 3];
+        n[0] = -(e1[1] * e2[2] - e1[2] * e2[1]);
+        n[1] = -(e1[2] * e2[0] - e1[0] * e2[2]);
+        n[2] = -(e1[0] * e2[1] - e1[1] * e2[0]);
+        Normalize(n);   // -- degenerate triangles stay zero
+        for (int k = 0; k < 3; ++k)
+            axis[k] += n[k];
+    }
+    Normalize(axis);
+
+    float min_dot = 1.0f;
+    for (UINT t = 0; t < triangle_count; ++t) {
+        float const * n = &normals[t * 3];
+        if (0.0f == Dot(n, n))
+            continue;
+        min_dot = std::min(min_dot, Dot(axis, n));
+    }
+    // -- cone wider than ~84 degrees (half angle) is not worth testing
+    if (0.0f == Dot(axis, axis) || min_dot <= 0.1f) {
+        for (int k = 0; k < 3; ++k) {
+            meshlet->cone_apex[k] = meshlet->center[k];
+            meshlet->cone_axis[k] = 0.0f;
+        }
+        meshlet->cone_cutoff = 1.0f;
+        return;
+    }
+    // -- move the apex back along the axis until it sits behind every
+    // -- triangle plane, then the test is exact for any eye position
+    float max_t = 0.0f;
+    for (UINT t = 0; t < triangle_count; ++t) {
+        float const * n = &normals[t * 3];
+        if (0.0f == Dot(n, n))
+            continue;
+        float const * p0 = vertices[indices[t * 3 + 0]].position;
+        float const to_center[3] = {
+            meshlet->center[0] - p0[0],
+            meshlet->center[1] - p0[1],
+            meshlet->center[2] - p0[2],
+        };
+        max_t = std::max(max_t, Dot(to_center, n) / Dot(axis, n));
+    }
+    for (int k = 0; k < 3; ++k) {
+        meshlet->cone_apex[k] = meshlet->center[k] - axis[k] * max_t;
+        meshlet->cone_axis[k] = axis[k];
+    }
+    meshlet->cone_cutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+void BuildMeshlets (
+    StandardVertex const * vertices,
+    UINT const * indices,
+    UINT index_count,
+    std::vector<PackMeshlet> * out
+) {
+    out->clear();
+    UINT const triangle_count = index_count / 3;
+
+    UINT meshlet_vertices[MeshletMaxVertices];
+    UINT vertex_count = 0;
+    UINT first_triangle = 0;
+    auto flush = [&] (UINT end_triangle) {
+        PackMeshlet meshlet = {};
+        meshlet.index_start = first_triangle * 3;
+        meshlet.index_count = (end_triangle - first_triangle) * 3;
+        ComputeBounds(
+            vertices, indices + meshlet.index_start,
+            meshlet.index_count, &meshlet
+        );
+        out->push_back(meshlet);
+        first_triangle = end_triangle;
+        vertex_count = 0;
+    };
+    for (UINT t = 0; t < triangle_count; ++t) {
+        // -- count vertices this triangle would add
+        UINT added[3];
+        UINT added_count = 0;
+        for (UINT k = 0; k < 3; ++k) {
+            UINT const v = indices[t * 3 + k];
+            bool found = false;
+            for (UINT m = 0; m < vertex_count && !found; ++m)
+                found = meshlet_vertices[m] == v;
+            for (UINT a = 0; a < added_count && !found; ++a)
+                found = added[a] == v;
+            if (!found)
+                added[added_count++] = v;
+        }
+        if (
+            vertex_count + added_count > MeshletMaxVertices ||
+            t - first_triangle >= MeshletMaxTriangles
+        ) {
+            flush(t);
+        }
+        for (UINT a = 0; a < added_count; ++a)
+            meshlet_vertices[vertex_count++] = added[a];
+    }
+    if (first_triangle < triangle_count)
+        flush(triangle_count);
+}
+void BuildCullFrustum (
+    float const m[16],
+    float const eye[3],
+    CullFrustum * frustum
+) {
+    // -- columns of the matrix, clip = (x, y, z, 1) * m
+    auto column = [m] (int c, int k) { return m[k * 4 + c]; };
+    for (int k = 0; k < 4; ++k) {
+        frustum->planes[0][k] = column(3, k) + column(0, k);   // -- left
+        frustum->planes[1][k] = column(3, k) - column(0, k);   // -- right
+        frustum->planes[2][k] = column(3, k) + column(1, k);   // -- bottom
+        frustum->planes[3][k] = column(3, k) - column(1, k);   // -- top
+        frustum->planes[4][k] = column(2, k);                  // -- near (z >= 0)
+        frustum->planes[5][k] = column(3, k) - column(2, k);   // -- far
+    }
+    for (int p = 0; p < 6; ++p) {
+        float * plane = frustum->planes[p];
+        float const length = sqrtf(Dot(plane, plane));
+        if (length > 0.0f)
+            for (int k = 0; k < 4; ++k)
+                plane[k] /= length;
+    }
+    for (int k = 0; k < 3; ++k)
+        frustum->eye[k] = eye[k];
+}
+static bool MeshletVisible (
+    PackMeshlet const & meshlet,
+    CullFrustum const & frustum,
+    bool cone_cull
+) {
+    for (int p = 0; p < 6; ++p) {
+        float const * plane = frustum.planes[p];
+        if (Dot(plane, meshlet.center) + plane[3] < -meshlet.radius)
+            return false;
+    }
+    if (cone_cull && meshlet.cone_cutoff < 1.0f) {
+        float view[3] = {
+            meshlet.cone_apex[0] - frustum.eye[0],
+            meshlet.cone_apex[1] - frustum.eye[1],
+            meshlet.cone_apex[2] - frustum.eye[2],
+        };
+        Normalize(view);
+        if (Dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff)
+            return false;
+    }
+    return true;
+}
+UINT CullMeshlets (
+    PackMeshlet const * meshlets,
+    UINT meshlet_count,
+    CullFrustum const & frustum,
+    bool cone_cull,
+    DrawRange * runs
+) {
+    UINT run_count = 0;
+    for (UINT i = 0; i < meshlet_count; ++i) {
+        PackMeshlet const & meshlet = meshlets[i];
+        if (!MeshletVisible(meshlet, frustum, cone_cull))
+            continue;
+        if (
+            run_count > 0 &&
+            runs[run_count - 1].index_start + runs[run_count - 1].index_count ==
+            meshlet.index_start
+        ) {
+            runs[run_count - 1].index_count += meshlet.index_count;
+        } else {
+            runs[run_count].index_start = meshlet.index_start;
+            runs[run_count].index_count = meshlet.index_count;
+            ++run_count;
+        }
+    }
+    return run_count;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include "asset_pack.h"
+#include "vertex_compression.h"
+
+// NOTE(omid): Meshlets are runs of consecutive triangles inside a draw
+// (after the mesh optimizer has ordered them), so a visible meshlet is
+// just a sub-range of the draw's indices. Neighbouring visible meshlets
+// are merged back into a single DrawIndexedInstanced.
+
+static constexpr UINT MeshletMaxVertices = 64;
+static constexpr UINT MeshletMaxTriangles = 124;
+
+//
+// -- view to cull against, all in model space
+struct CullFrustum {
+    float planes[6][4]; // -- normalized, inside is dot(xyz, p) + w >= 0
+    float eye[3];
+    float projection_scale; // -- 1 / tan(fov_y / 2), for LOD screen size
+};
+
+// -- one contiguous run of visible indices
+struct DrawRange {
+    UINT index_start;   // -- relative to the draw's index_start
+    UINT index_count;
+};
+
+//
+// -- model space sphere around the triangles (draw-relative indices)
+void BoundingSphere (
+    StandardVertex const * vertices,   // -- already offset by vertex_base
+    UINT const * indices,
+    UINT index_count,
+    float center[3],
+    float * radius
+);
+
+//
+// -- split one draw (draw-relative indices) into meshlets
+void BuildMeshlets (
+    StandardVertex const * vertices,   // -- already offset by vertex_base
+    UINT const * indices,
+    UINT index_count,
+    std::vector<PackMeshlet> * out
+);
+
+//
+// -- extract planes from a row-major model * view * projection
+// -- (row vector convention, d3d clip space)
+void BuildCullFrustum (
+    float const model_view_proj[16],
+    float const eye[3],
+    CullFrustum * frustum
+);
+
+//
+// -- frustum and (optionally) cone test every meshlet, visible neighbours
+// -- are merged into runs (runs needs room for meshlet_count entries)
+// -- returns the number of runs
+UINT CullMeshlets (
+    PackMeshlet const * meshlets,
+    UINT meshlet_count,
+    CullFrustum const & frustum,
+    bool cone_cull,
+    DrawRange * runs
+);
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
+
+#include "dds_reader.h"
 
 // NOTE(omid): ComPtr manages lifetime on cpu side 
 // and is agnostic toward gpu lifetime of a resource 
@@ -83,56 +87,79 @@ ReadDataFromFile (LPCWSTR filename, byte ** data, UINT * size) {
     return S_OK;
 }
 inline HRESULT
+WriteDataToFile (LPCWSTR filename, void const * data, UINT size) {
+    Microsoft::WRL::Wrappers::FileHandle file(CreateFile2(
+        filename,
+        GENERIC_WRITE, 0, CREATE_ALWAYS,
+        nullptr
+    ));
+    if (INVALID_HANDLE_VALUE == file.Get())
+        return HRESULT_FROM_WIN32(GetLastError());
+    DWORD written = 0;
+    if (FALSE == WriteFile(file.Get(), data, size, &written, nullptr))
+        return HRESULT_FROM_WIN32(GetLastError());
+    return written == size ? S_OK : E_FAIL;
+}
+//
+// -- overwrite bytes in place, the rest of the file is left as it is
+inline HRESULT
+WriteDataToFileAt (LPCWSTR filename, UINT64 offset, void const * data, UINT size) {
+    Microsoft::WRL::Wrappers::FileHandle file(CreateFile2(
+        filename,
+        GENERIC_WRITE, 0, OPEN_EXISTING,
+        nullptr
+    ));
+    if (INVALID_HANDLE_VALUE == file.Get())
+        return HRESULT_FROM_WIN32(GetLastError());
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD written = 0;
+    if (FALSE == WriteFile(file.Get(), data, size, &written, &overlapped))
+        return HRESULT_FROM_WIN32(GetLastError());
+    return written == size ? S_OK : E_FAIL;
+}
+//
+// -- size and last write time, a cheap stand-in for the file's contents
+inline HRESULT
+GetFileStamp (LPCWSTR filename, UINT64 * size, UINT64 * write_time) {
+    WIN32_FILE_ATTRIBUTE_DATA data = {};
+    if (FALSE == GetFileAttributesEx(filename, GetFileExInfoStandard, &data))
+        return HRESULT_FROM_WIN32(GetLastError());
+    *size = static_cast<UINT64>(data.nFileSizeHigh) << 32 | data.nFileSizeLow;
+    *write_time =
+        static_cast<UINT64>(data.ftLastWriteTime.dwHighDateTime) << 32 |
+        data.ftLastWriteTime.dwLowDateTime;
+    return S_OK;
+}
+inline bool
+FileExists (LPCWSTR filename) {
+    DWORD const attributes = GetFileAttributes(filename);
+    return
+        attributes != INVALID_FILE_ATTRIBUTES &&
+        0 == (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+//
+// -- texels of mips [first_mip, first_mip + mip_count) of the first array
+// -- item, only the header and those mips are read (see DdsReader)
+inline HRESULT
 ReadDataFromDDSFile (
-    LPCWSTR filename, byte ** data, UINT * offset, UINT * size
+    LPCWSTR filename,
+    UINT first_mip,
+    UINT mip_count,
+    DdsInfo * info,
+    std::vector<UINT8> * data
 ) {
-    if (FAILED(ReadDataFromFile(filename, data, size)))
-        throw std::exception();
-    // -- dds files start with a magic number
-    static constexpr UINT DDS_MAGIC = 0x20534444;
-    UINT magic_number = *reinterpret_cast<UINT const *>(*data);
-    if (magic_number != DDS_MAGIC)
-        return E_FAIL;
-    struct DDS_PIXELFORMAT {
-        UINT size;
-        UINT flags;
-        UINT four_cc;
-        UINT rgb_bit_count;
-        UINT r_bit_mask;
-        UINT g_bit_mask;
-        UINT b_bit_mask;
-        UINT a_bit_mask;
-    };
-    struct DDS_HEADER {
-        UINT size;
-        UINT flags;
-        UINT height;
-        UINT width;
-        UINT pitch_or_linear_size;
-        UINT depth;
-        UINT mipmap_count;
-        UINT reserved1[11];
-        DDS_PIXELFORMAT dds_pixel_format;
-        UINT caps;
-        UINT caps2;
-        UINT caps3;
-        UINT caps4;
-        UINT reserved2;
-    };
-
-    DDS_HEADER const * header =
-        reinterpret_cast<DDS_HEADER const *>(*data + sizeof(UINT));
-    if (
-        sizeof(DDS_HEADER) != header->size ||
-        sizeof(DDS_PIXELFORMAT) != header->dds_pixel_format.size
-    ) {
-        return E_FAIL;
-    }
-    ptrdiff_t const data_offset = sizeof(UINT) + sizeof(DDS_HEADER);
-    *offset = data_offset;
-    *size = *size - data_offset;
-
-    return S_OK;
+    DdsReader reader;
+    HRESULT hr = reader.Open(filename);
+    if (FAILED(hr))
+        return hr;
+    *info = reader.Info();
+    if (first_mip >= info->mip_count)
+        return E_INVALIDARG;
+    mip_count = std::min(mip_count, info->mip_count - first_mip);
+    data->resize(static_cast<size_t>(reader.MipRangeSize(first_mip, mip_count)));
+    return reader.ReadMips(0, first_mip, mip_count, data->data(), data->size());
 }
 
 // -- setting objects names for debugging purposes
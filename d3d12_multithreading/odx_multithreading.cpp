@@ -1,8 +1,29 @@
 #include "stdafx.h"
 #include "odx_multithreading.h"
 #include "frame_resource.h"
+#include "asset_cooker.h"
+#include "vertex_compression.h"
+#include "mesh_lod.h"
+#include "fast_copy.h"
 #include "win32_app.h"
 
+#include <algorithm>
+#include <atomic>
+
+// -- ids of the resources the upload tracker follows
+static constexpr UINT UploadVertices = 0;
+static constexpr UINT UploadPositions = 1;
+static constexpr UINT UploadIndices = 2;
+static constexpr UINT UploadFirstTexture = 3;
+
+// -- crc every payload of a cached pack when loading it
+// -- (header, toc and bounds are always checked)
+#if defined(_DEBUG) || defined(DBG)
+static constexpr bool VerifyPackPayloads = true;
+#else
+static constexpr bool VerifyPackPayloads = false;
+#endif
+
 OdxMultithreading * OdxMultithreading::s_app = nullptr;
 
 // -- body of a worker thread:
@@ -17,45 +38,82 @@ void OdxMultithreading::WorkerThread (int thread_index) {
         WaitForSingleObject(worker_begin_render_frame_[thread_index], INFINITE);
 #endif // !SINGLETHREADED
 
-        ID3D12GraphicsCommandList * shadow_cmdlist =
-            current_frame_resource_->shadow_cmdlists_[thread_index].Get();
+        // -- lights drawn this frame, the others keep their cached tile
+        UINT const shadow_lights = shadow_lights_;
+
+        // -- reset this worker's own cmdlists, off the main thread
+        LARGE_INTEGER setup_start, setup_end;
+        QueryPerformanceCounter(&setup_start);
+        current_frame_resource_->InitWorker(&command_pool_, thread_index, shadow_lights);
+        QueryPerformanceCounter(&setup_end);
+        frame_timings_.WorkerSetup(
+            thread_index, setup_end.QuadPart - setup_start.QuadPart
+        );
+
         ID3D12GraphicsCommandList * scene_cmdlist =
-            current_frame_resource_->scene_cmdlists_[thread_index].Get();
+            current_frame_resource_->scene_cmdlists_[thread_index];
+        // -- this worker's chunk of the frame's constants, for both passes
+        ConstantCursor constants_cursor = {};
 
         //
-        // -- shadow pass
+        // -- shadow pass, one list per light into the light's atlas tile
         //
 
-        // -- populate cmdlist
-        SetCommonPipelineState(shadow_cmdlist);
-        current_frame_resource_->Bind(shadow_cmdlist, FALSE, nullptr, nullptr);
-
-        // -- set null SRVs for diffuse/normal textures
-        shadow_cmdlist->SetGraphicsRootDescriptorTable(
-            0, cbv_srv_heap_->GetGPUDescriptorHandleForHeapStart()
-        );
-
         // -- distribute objects over threads
         // -- by drawing only 1/NumContexts objs per worker
         // -- i.e., every obj such that obj_num % NumContexts == thread_index
 
-        PIXBeginEvent(shadow_cmdlist, 0, L"worker thread drawing shadow pass...");
-        for (
-            int j = thread_index;
-            j < ArrayCount(SampleAssets::Draws);
-            j += NumContexts
-        ) {
-            SampleAssets::DrawParameters draw_args = SampleAssets::Draws[j];
-            shadow_cmdlist->DrawIndexedInstanced(
-                draw_args.IndexCount,
-                1,
-                draw_args.IndexStart,
-                draw_args.VertexBase,
-                0
+        shadow_triangles_[thread_index] = 0;
+        UINT bound_index_format = DXGI_FORMAT_UNKNOWN;
+        bool constants_written = false;
+        LARGE_INTEGER shadow_start, shadow_end;
+        QueryPerformanceCounter(&shadow_start);
+        for (UINT light = 0; light < NumLights; ++light) {
+            if (0 == (shadow_lights & 1u << light))
+                continue;
+            ID3D12GraphicsCommandList * shadow_cmdlist =
+                current_frame_resource_->shadow_cmdlists_[light * NumContexts + thread_index];
+            CullFrustum const & frustum = shadow_frustums_[light];
+            UINT8 * lods = &shadow_lods_[light * draws_.size()];
+
+            // -- populate cmdlist
+            SetCommonPipelineState(shadow_cmdlist, FALSE);
+            current_frame_resource_->BindShadow(shadow_cmdlist, light);
+
+            // -- set null SRVs for diffuse/normal textures
+            shadow_cmdlist->SetGraphicsRootDescriptorTable(
+                0, cbv_srv_heap_->GetGPUDescriptorHandleForHeapStart()
             );
+
+            PIXBeginEvent(shadow_cmdlist, 0, L"worker thread drawing shadow pass...");
+            bound_index_format = DXGI_FORMAT_UNKNOWN;
+            for (
+                int j = thread_index;
+                j < static_cast<int>(draws_.size());
+                j += NumContexts
+            ) {
+                PackDraw const & draw_args = draws_[j];
+                SetIndexBuffer(shadow_cmdlist, draw_args, &bound_index_format);
+                // -- the draw's constants this frame, written once (first
+                // -- light drawn) and reused by the other lights and the scene pass
+                if (!constants_written)
+                    draw_constants_[j] = WriteDrawConstants(draw_args, &constants_cursor);
+                shadow_cmdlist->SetGraphicsRootConstantBufferView(4, draw_constants_[j]);
+                // -- pick from the light's view, then go coarser still
+                lods[j] = static_cast<UINT8>(SelectLod(draw_args, frustum, lods[j]));
+                UINT const lod = std::min(lods[j] + ShadowLodBias, draw_args.lod_count);
+                shadow_triangles_[thread_index] += DrawCulled(
+                    shadow_cmdlist, draw_args, lod, frustum, thread_index
+                );
+            }
+            PIXEndEvent(shadow_cmdlist);
+            ThrowIfFailed(shadow_cmdlist->Close());
+            constants_written = true;
         }
-        PIXEndEvent(shadow_cmdlist);
-        ThrowIfFailed(shadow_cmdlist->Close());
+        QueryPerformanceCounter(&shadow_end);
+        frame_timings_.WorkerShadow(
+            thread_index, shadow_end.QuadPart - shadow_start.QuadPart
+        );
 
 #if !SINGLETHREADED
         // -- submit shadow pass
@@ -68,7 +126,7 @@ void OdxMultithreading::WorkerThread (int thread_index) {
 
         // -- populate the cmdlist.
         // -- to be send only after shadow pass has been submitted
-        SetCommonPipelineState(scene_cmdlist);
+        SetCommonPipelineState(scene_cmdlist, TRUE);
         CD3DX12_CPU_DESCRIPTOR_HANDLE hrtv(
             rtv_heap_->GetCPUDescriptorHandleForHeapStart(),
             frame_index_,
@@ -77,36 +135,46 @@ void OdxMultithreading::WorkerThread (int thread_index) {
         CD3DX12_CPU_DESCRIPTOR_HANDLE hdsv(
             dsv_heap_->GetCPUDescriptorHandleForHeapStart()
         );
-        current_frame_resource_->Bind(scene_cmdlist, TRUE, &hrtv, &hdsv);
+        current_frame_resource_->Bind(scene_cmdlist, &hrtv, &hdsv);
 
         PIXBeginEvent(scene_cmdlist, 0, L"worker thread drawing scene pass...");
+        scene_triangles_[thread_index] = 0;
         D3D12_GPU_DESCRIPTOR_HANDLE cbv_srv_heap_start =
             cbv_srv_heap_->GetGPUDescriptorHandleForHeapStart();
         UINT const cbv_srv_descriptor_size =
             device_->GetDescriptorHandleIncrementSize(
                 D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
         UINT const null_srv_count = 2;
+        bound_index_format = DXGI_FORMAT_UNKNOWN;
         for (
             int j = thread_index;
-            j < ArrayCount(SampleAssets::Draws);
+            j < static_cast<int>(draws_.size());
             j += NumContexts
         ) {
-            SampleAssets::DrawParameters draw_args = SampleAssets::Draws[j];
-            // -- set diffuse and normal maps for current obj
+            PackDraw const & draw_args = draws_[j];
+            // -- set diffuse and normal maps for current obj,
+            // -- null srvs while the copy queue has not delivered them yet
+            UINT const maps = UploadFirstTexture + draw_args.diffuse_texture_index;
+            bool const maps_ready =
+                upload_tracker_.Ready(maps) && upload_tracker_.Ready(maps + 1);
             CD3DX12_GPU_DESCRIPTOR_HANDLE cbv_srv_handle (
                 cbv_srv_heap_start,
-                null_srv_count + draw_args.DiffuseTextureIndex,
+                maps_ready ? null_srv_count + draw_args.diffuse_texture_index : 0,
                 cbv_srv_descriptor_size
             );
             scene_cmdlist->SetGraphicsRootDescriptorTable(
                 0, cbv_srv_handle
             );
-            scene_cmdlist->DrawIndexedInstanced(
-                draw_args.IndexCount,
-                1,
-                draw_args.IndexStart,
-                draw_args.VertexBase,
-                0
+            SetIndexBuffer(scene_cmdlist, draw_args, &bound_index_format);
+            // -- every light cached, the shadow pass wrote no constants
+            if (!constants_written)
+                draw_constants_[j] = WriteDrawConstants(draw_args, &constants_cursor);
+            scene_cmdlist->SetGraphicsRootConstantBufferView(4, draw_constants_[j]);
+            scene_lods_[j] = static_cast<UINT8>(
+                SelectLod(draw_args, scene_frustum_, scene_lods_[j])
+            );
+            scene_triangles_[thread_index] += DrawCulled(
+                scene_cmdlist, draw_args, scene_lods_[j], scene_frustum_, thread_index
             );
         }
         PIXEndEvent(scene_cmdlist);
@@ -119,7 +187,8 @@ void OdxMultithreading::WorkerThread (int thread_index) {
 #endif // !SINGLETHREADED
 }
 void OdxMultithreading::SetCommonPipelineState (
-    ID3D12GraphicsCommandList * cmdlist
+    ID3D12GraphicsCommandList * cmdlist,
+    BOOL scene_pass
 ) {
     cmdlist->SetGraphicsRootSignature(rootsig_.Get());
 
@@ -131,8 +200,10 @@ void OdxMultithreading::SetCommonPipelineState (
     cmdlist->RSSetViewports(1, &viewport_);
     cmdlist->RSSetScissorRects(1, &scissor_rect_);
     cmdlist->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    cmdlist->IASetVertexBuffers(0, 1, &vb_view_);
-    cmdlist->IASetIndexBuffer(&ib_view_);
+    // -- depth-only shadow pass fetches just the position stream
+    cmdlist->IASetVertexBuffers(
+        0, 1, scene_pass ? &vb_view_ : &position_vb_view_
+    );
     cmdlist->SetGraphicsRootDescriptorTable(
         3, sampler_heap_->GetGPUDescriptorHandleForHeapStart()
     );
@@ -145,6 +216,157 @@ void OdxMultithreading::SetCommonPipelineState (
     // -- bc they depends on the frame resource being used
 
     // -- SRVs are set elsewhere bc they change based on obj being drawn
+
+    // -- index buffer is set elsewhere bc its format changes per draw
+}
+//
+// -- switch between the 16-bit and 32-bit index views only when needed
+void OdxMultithreading::SetIndexBuffer (
+    ID3D12GraphicsCommandList * cmdlist,
+    PackDraw const & draw,
+    UINT * bound_format
+) {
+    if (draw.index_format == *bound_format)
+        return;
+    cmdlist->IASetIndexBuffer(
+        DXGI_FORMAT_R16_UINT == draw.index_format ? &ib16_view_ : &ib_view_
+    );
+    *bound_format = draw.index_format;
+}
+//
+// -- per-draw constants (model matrix, position dequantization),
+// -- written to the frame's constants, returns the address to bind
+D3D12_GPU_VIRTUAL_ADDRESS OdxMultithreading::WriteDrawConstants (
+    PackDraw const & draw,
+    ConstantCursor * cursor
+) {
+    DrawCBuffer cbuf;
+    cbuf.model = draw_model_;
+    cbuf.position_offset = XMFLOAT3(draw.position_offset);
+    cbuf.padding0 = 0.0f;
+    cbuf.position_scale = XMFLOAT3(draw.position_scale);
+    cbuf.padding1 = 0.0f;
+    D3D12_GPU_VIRTUAL_ADDRESS const address =
+        current_frame_resource_->constants_.Write(cursor, cbuf);
+    if (0 == address)
+        ThrowIfFailed(E_OUTOFMEMORY);   // -- sized for every draw
+    return address;
+}
+//
+// -- draw only the meshlets that survive culling (whole draw if it has none)
+// -- coarser LODs have no meshlets and are always drawn whole
+// -- returns the number of triangles submitted
+UINT OdxMultithreading::DrawCulled (
+    ID3D12GraphicsCommandList * cmdlist,
+    PackDraw const & draw,
+    UINT lod,
+    CullFrustum const & frustum,
+    int thread_index
+) {
+    if (lod > 0) {
+        PackLod const & range = lods_[draw.lod_start + lod - 1];
+        cmdlist->DrawIndexedInstanced(
+            range.index_count, 1, range.index_start, draw.vertex_base, 0
+        );
+        return range.index_count / 3;
+    }
+    if (0 == draw.meshlet_count) {
+        cmdlist->DrawIndexedInstanced(
+            draw.index_count, 1, draw.index_start, draw.vertex_base, 0
+        );
+        return draw.index_count / 3;
+    }
+    DrawRange * runs = cull_runs_[thread_index].data();
+    UINT const run_count = CullMeshlets(
+        &meshlets_[draw.meshlet_start], draw.meshlet_count,
+        frustum, true, runs
+    );
+    UINT index_count = 0;
+    for (UINT r = 0; r < run_count; ++r) {
+        cmdlist->DrawIndexedInstanced(
+            runs[r].index_count,
+            1,
+            draw.index_start + runs[r].index_start,
+            draw.vertex_base,
+            0
+        );
+        index_count += runs[r].index_count;
+    }
+    return index_count / 3;
+}
+//
+// -- rebuild the dirty constant blocks and bump their versions
+void OdxMultithreading::UpdateConstants () {
+    if (dirty_cbuffers_ & 1u << ConstantsStatic) {
+        StaticCBuffer & cbuf = cbuffers_.static_constants;
+        cbuf.ambient_color = {0.1f, 0.2f, 0.3f, 1.0f};
+        for (int i = 0; i < NumLights; ++i) {
+            cbuf.light_colors[i] = lights_[i].color;
+            cbuf.light_falloffs[i] = lights_[i].falloff;
+            shadow_atlas_.TileTransform(i, &cbuf.shadow_tiles[i].x);
+        }
+        float const atlas_width = static_cast<float>(shadow_atlas_.Width());
+        float const atlas_height = static_cast<float>(shadow_atlas_.Height());
+        cbuf.smap_dims = {
+            atlas_width, atlas_height, 1.0f / atlas_width, 1.0f / atlas_height
+        };
+        cbuf.shadow_light_count = NumLights;
+    }
+    if (dirty_cbuffers_ & 1u << ConstantsFrame) {
+        for (int i = 0; i < NumLights; ++i) {
+            FrameCBuffer::Light & light = cbuffers_.frame.lights[i];
+            light.position = lights_[i].position;
+            light.direction = lights_[i].direction;
+            // -- what the light's tile was drawn with (see OnUpdate)
+            light.view = shadow_views_[i];
+            light.projection = shadow_projections_[i];
+        }
+    }
+    if (dirty_cbuffers_ & 1u << ConstantsShadowPass) {
+        // -- each light's shadow pass is drawn from its pov into its tile,
+        // -- with the matrices the scene samples that tile with
+        for (int i = 0; i < NumLights; ++i) {
+            PassCBuffer & cbuf = cbuffers_.shadow_passes[i];
+            cbuf.view = shadow_views_[i];
+            cbuf.projection = shadow_projections_[i];
+            cbuf.sample_smap = FALSE;
+        }
+    }
+    if (dirty_cbuffers_ & 1u << ConstantsScenePass) {
+        // -- scene pass is drawn from camera pov and samples the smap
+        PassCBuffer & cbuf = cbuffers_.scene_pass;
+        camera_.Get3DViewProjMatrices(
+            &cbuf.view, &cbuf.projection,
+            90.0f, viewport_.Width, viewport_.Height
+        );
+        cbuf.sample_smap = TRUE;
+    }
+    for (UINT i = 0; i < ConstantBlockCount; ++i)
+        if (dirty_cbuffers_ & 1u << i)
+            ++cbuffers_.versions[i];
+    dirty_cbuffers_ = 0;
+}
+//
+// -- cull in model space: planes of model * view * proj, eye unscaled
+void OdxMultithreading::UpdateCullFrustum (
+    Camera * camera,
+    float width, float height,
+    CullFrustum * frustum
+) {
+    XMFLOAT4X4 view;
+    XMFLOAT4X4 proj;
+    camera->Get3DViewProjMatrices(&view, &proj, 90.0f, width, height);
+    // NOTE(omid): camera hands out transposed matrices (for hlsl)
+    XMMATRIX const model_view_proj =
+        XMMatrixScaling(SceneScale, SceneScale, SceneScale) *
+        XMMatrixTranspose(XMLoadFloat4x4(&view)) *
+        XMMatrixTranspose(XMLoadFloat4x4(&proj));
+    XMFLOAT4X4 m;
+    XMStoreFloat4x4(&m, model_view_proj);
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, XMVectorScale(camera->eye_, 1.0f / SceneScale));
+    BuildCullFrustum(&m._11, &eye.x, frustum);
+    frustum->projection_scale = proj._22;
 }
 //
 // -- load rendering pipeline dependencies
@@ -202,13 +424,17 @@ void OdxMultithreading::LoadPipeLine () {
 
     // -- describe and create swapchain
     DXGI_SWAP_CHAIN_DESC1 swapchain_desc = {};
-    swapchain_desc.BufferCount = FrameCount;
+    swapchain_desc.BufferCount = BackBufferCount;
     swapchain_desc.Width = width_;
     swapchain_desc.Height = height_;
     swapchain_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     swapchain_desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
     swapchain_desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
     swapchain_desc.SampleDesc.Count = 1;
+    // -- low latency waits on the swapchain before sampling input
+    // -- instead of queuing frames_in_flight_ frames in Present
+    if (low_latency_)
+        swapchain_desc.Flags = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
 
     ComPtr<IDXGISwapChain1> swap_chain;
     ThrowIfFailed(factory->CreateSwapChainForHwnd(
@@ -226,12 +452,18 @@ void OdxMultithreading::LoadPipeLine () {
 
     ThrowIfFailed(swap_chain.As(&swapchain_));
     frame_index_ = swapchain_->GetCurrentBackBufferIndex();
+    if (low_latency_) {
+        ComPtr<IDXGISwapChain2> swapchain2;
+        ThrowIfFailed(swapchain_.As(&swapchain2));
+        ThrowIfFailed(swapchain2->SetMaximumFrameLatency(1));
+        frame_latency_waitable_ = swapchain2->GetFrameLatencyWaitableObject();
+    }
 
     // -- create descriptor heaps
     {
         // -- describe and create a RTV descriptor heap
         D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
-        rtv_heap_desc.NumDescriptors = FrameCount;
+        rtv_heap_desc.NumDescriptors = BackBufferCount;
         rtv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
         rtv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(device_->CreateDescriptorHeap(
@@ -239,10 +471,10 @@ void OdxMultithreading::LoadPipeLine () {
             IID_PPV_ARGS(&rtv_heap_)
         ));
         // -- describe and create a DSV descriptor heap
-        // -- each frame has its own depstncls (to write shadows onto)
-        // -- and then there is one for the scene itself
+        // -- one for the scene depstncl, then a slot per shadow map
+        // -- (see ShadowMaps): up to frames_in_flight_, map_count used
         D3D12_DESCRIPTOR_HEAP_DESC dsv_heap_desc = {};
-        dsv_heap_desc.NumDescriptors = 1 + FrameCount * 1;
+        dsv_heap_desc.NumDescriptors = 1 + frames_in_flight_;
         dsv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
         dsv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
         ThrowIfFailed(device_->CreateDescriptorHeap(
@@ -254,20 +486,16 @@ void OdxMultithreading::LoadPipeLine () {
             Heap layout:
                 null views,
                 object diffuse + normal textures views,
-                frame 1's shadow buffer,
-                frame 1's 2x cbuffers,
-                frame 2's shadow buffer,
-                frame 2's 2x cbuffers,
-                frame 3's shadow buffer,
-                frame 3's 2x cbuffers,
+                shadow map views from ShadowMaps (up to frames_in_flight_,
+                map_count used),
+            (cbuffers are bound by address, they need no views)
         */
         UINT const null_srv_count = 2;  // null descriptors needed for out of bounds behaviour reads
-        UINT const cbv_count = FrameCount * 2;
         UINT const srv_count =
-            ArrayCount(SampleAssets::Textures) + (FrameCount * 1);
+            assets_.texture_count + frames_in_flight_;
         D3D12_DESCRIPTOR_HEAP_DESC cbv_srv_heap_desc = {};
         cbv_srv_heap_desc.NumDescriptors =
-            null_srv_count + cbv_count + srv_count;
+            null_srv_count + srv_count;
         cbv_srv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
         cbv_srv_heap_desc.Flags =
             D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
@@ -315,7 +543,7 @@ void OdxMultithreading::LoadAssets () {
             feature_data.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
         }
         // NOTE(omid): Performance tip: order from most frequent used 
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[4];
+        CD3DX12_DESCRIPTOR_RANGE1 ranges[3];
         // -- two frequenctly changed diffuse + normal maps
         // -- using register t1 and t2
         ranges[0].Init(
@@ -323,39 +551,53 @@ void OdxMultithreading::LoadAssets () {
             2 /* num of descriptors */, 1 /* t1, t2 */, 0 /* space0 */,
             D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC
         );
-        // -- one frequently changed cbuffer
-        ranges[1].Init(
-            D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
-            1 /* num of descriptors */, 0 /* b0 */, 0 /* space0 */,
-            D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC
-        );
         // -- one infrequenctly changed shadow texture
         // -- using register t0
-        ranges[2].Init(
+        ranges[1].Init(
             D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
             1 /* num of descriptors */, 0 /* t0 */
         );
-        ranges[3].Init(
+        ranges[2].Init(
             D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER,
             2 /* num of descriptors */, 0 /* s0 */
         );
 
-        CD3DX12_ROOT_PARAMETER1 root_params[4];
+        CD3DX12_ROOT_PARAMETER1 root_params[7];
         root_params[0].InitAsDescriptorTable(
             1 /* num of ranges */,
             &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL
         );
-        root_params[1].InitAsDescriptorTable(
-            1 /* num of ranges */,
-            &ranges[1], D3D12_SHADER_VISIBILITY_ALL
+        // -- per-pass constants, changed every pass
+        root_params[1].InitAsConstantBufferView(
+            0 /* b0 */, 0 /* space0 */,
+            D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+            D3D12_SHADER_VISIBILITY_ALL
         );
         root_params[2].InitAsDescriptorTable(
             1 /* num of ranges */,
-            &ranges[2], D3D12_SHADER_VISIBILITY_PIXEL
+            &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL
         );
         root_params[3].InitAsDescriptorTable(
             1 /* num of ranges */,
-            &ranges[3], D3D12_SHADER_VISIBILITY_PIXEL
+            &ranges[2], D3D12_SHADER_VISIBILITY_PIXEL
+        );
+        // -- per-draw constants, changed every draw, bound by address
+        // -- (written before the cmdlist executes and left alone until done)
+        root_params[4].InitAsConstantBufferView(
+            1 /* b1 */, 0 /* space0 */,
+            D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+            D3D12_SHADER_VISIBILITY_VERTEX
+        );
+        // -- per-frame lights (b2) and static lights (b3), rarely rewritten
+        root_params[5].InitAsConstantBufferView(
+            2 /* b2 */, 0 /* space0 */,
+            D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+            D3D12_SHADER_VISIBILITY_PIXEL
+        );
+        root_params[6].InitAsConstantBufferView(
+            3 /* b3 */, 0 /* space0 */,
+            D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE,
+            D3D12_SHADER_VISIBILITY_PIXEL
         );
 
         CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC root_sig_desc;
@@ -388,6 +630,7 @@ void OdxMultithreading::LoadAssets () {
     //
     {
         ComPtr<ID3DBlob> vertex_shader;
+        ComPtr<ID3DBlob> shadow_vertex_shader;
         ComPtr<ID3DBlob> pixel_shader;
 #if defined(_DEBUG)
         // -- enable better shader debugging with graphics debugging tools
@@ -395,14 +638,27 @@ void OdxMultithreading::LoadAssets () {
 #else
         UINT compile_flags = D3DCOMPILE_OPTIMIZATION_LEVEL3;
 #endif
-        auto str = GetAssetFullPath(L"shaders.hlsl");
+        // -- vertex decode has to match the layout stored in the pack
+        bool const compressed_vertices =
+            PackVertexCompressed == assets_.vertex_format;
+        D3D_SHADER_MACRO const compressed_defines [] = {
+            {"COMPRESSED_VERTICES", "1"},
+            {nullptr, nullptr}
+        };
         ThrowIfFailed(D3DCompileFromFile(
             GetAssetFullPath(L"shaders.hlsl").c_str(),
-            nullptr, nullptr,
+            compressed_vertices ? compressed_defines : nullptr, nullptr,
             "VSMain", "vs_5_0",
             compile_flags, 0,
             &vertex_shader, nullptr
         ));
+        ThrowIfFailed(D3DCompileFromFile(
+            GetAssetFullPath(L"shaders.hlsl").c_str(),
+            compressed_vertices ? compressed_defines : nullptr, nullptr,
+            "VSShadow", "vs_5_0",
+            compile_flags, 0,
+            &shadow_vertex_shader, nullptr
+        ));
         ThrowIfFailed(D3DCompileFromFile(
             GetAssetFullPath(L"shaders.hlsl").c_str(),
             nullptr, nullptr,
@@ -412,10 +668,16 @@ void OdxMultithreading::LoadAssets () {
         ));
 
         D3D12_INPUT_LAYOUT_DESC input_layout_desc;
-        input_layout_desc.pInputElementDescs =
-            SampleAssets::StandardVertexDescription;
-        input_layout_desc.NumElements =
-            ArrayCount(SampleAssets::StandardVertexDescription);
+        if (compressed_vertices) {
+            input_layout_desc.pInputElementDescs = CompressedVertexDescription;
+            input_layout_desc.NumElements =
+                ArrayCount(CompressedVertexDescription);
+        } else {
+            input_layout_desc.pInputElementDescs =
+                SampleAssets::StandardVertexDescription;
+            input_layout_desc.NumElements =
+                ArrayCount(SampleAssets::StandardVertexDescription);
+        }
 
         CD3DX12_DEPTH_STENCIL_DESC depthstncl_desc(D3D12_DEFAULT);
         depthstncl_desc.DepthEnable = true;
@@ -447,6 +709,19 @@ void OdxMultithreading::LoadAssets () {
 
         // -- alter description and create pso for rendering the smap
         // -- smap doesn't use pixel shader nor render targets
+        // -- and only fetches positions (from the position stream)
+        if (compressed_vertices) {
+            pso_desc.InputLayout.pInputElementDescs =
+                CompressedPositionDescription;
+            pso_desc.InputLayout.NumElements =
+                ArrayCount(CompressedPositionDescription);
+        } else {
+            pso_desc.InputLayout.pInputElementDescs =
+                StandardPositionDescription;
+            pso_desc.InputLayout.NumElements =
+                ArrayCount(StandardPositionDescription);
+        }
+        pso_desc.VS = CD3DX12_SHADER_BYTECODE(shadow_vertex_shader.Get());
         pso_desc.PS = CD3DX12_SHADER_BYTECODE(0, 0);
         pso_desc.RTVFormats[0] = DXGI_FORMAT_UNKNOWN;
         pso_desc.NumRenderTargets = 0;
@@ -472,7 +747,7 @@ void OdxMultithreading::LoadAssets () {
     CD3DX12_CPU_DESCRIPTOR_HANDLE hrtv(
         rtv_heap_->GetCPUDescriptorHandleForHeapStart()
     );
-    for (UINT i = 0; i < FrameCount; ++i) {
+    for (UINT i = 0; i < BackBufferCount; ++i) {
         ThrowIfFailed(swapchain_->GetBuffer(
             i, IID_PPV_ARGS(&render_targets_[i])
         ));
@@ -522,114 +797,171 @@ void OdxMultithreading::LoadAssets () {
         );
     }
     //
-    // -- load scene assets
+    // -- load scene assets (the pack was parsed before creating the pipeline)
     //
-    UINT file_size = 0;
-    UINT8 * asset_data;
-    ThrowIfFailed(ReadDataFromFile(
-        GetAssetFullPath(SampleAssets::DataFilename).c_str(),
-        &asset_data, &file_size
-    ));
+    draws_.assign(assets_.draws, assets_.draws + assets_.draw_count);
+    meshlets_.assign(assets_.meshlets, assets_.meshlets + assets_.meshlet_count);
+    lods_.assign(assets_.lods, assets_.lods + assets_.lod_count);
+    scene_lods_.assign(draws_.size(), 0);
+    shadow_lods_.assign(draws_.size() * NumLights, 0);
+    total_triangles_ = 0;
+    UINT max_meshlets = 0;
+    for (PackDraw const & draw : draws_) {
+        total_triangles_ += draw.index_count / 3;
+        max_meshlets = std::max(max_meshlets, draw.meshlet_count);
+    }
+    for (int i = 0; i < NumContexts; ++i)
+        cull_runs_[i].resize(max_meshlets);
+    //
+    // -- heaps for the scene buffers and textures, and the copy queue filling them
+    // NOTE(omid): separate heaps per category keeps us on resource heap tier 1,
+    // the allocations are never freed, they live as long as the pools
+    // NOTE(omid): resources start in COMMON, the copy queue promotes them to
+    // COPY_DEST and the graphics queue to whatever read state it needs
+    buffer_heaps_.Init(
+        device_.Get(), D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS
+    );
+    texture_heaps_.Init(
+        device_.Get(), D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES
+    );
+    ThrowIfFailed(upload_service_.Init(device_.Get()));
+    task_pool_.Init(load_threads_);
+    upload_tracker_.Init(UploadFirstTexture + assets_.texture_count);
+    HeapAllocation allocation;
     // -- create vertex buffer:
     {
-        ThrowIfFailed(device_->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(SampleAssets::VertexDataSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
+        ThrowIfFailed(buffer_heaps_.CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(assets_.vertex_data_size),
+            D3D12_RESOURCE_STATE_COMMON,
             nullptr,
-            IID_PPV_ARGS(&vb_)
+            &vb_,
+            &allocation
         ));
         NAME_D3D12_OBJECT(vb_);
         {
-            ThrowIfFailed(device_->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(SampleAssets::VertexDataSize),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&vb_upload_)
+            UploadAllocation vb_upload;
+            ThrowIfFailed(upload_service_.Allocate(
+                assets_.vertex_data_size, sizeof(UINT), &vb_upload
             ));
 
-            // -- copy data to upload heap and 
-            // -- then schecule a copy from upload heap to vertex buffer
-            D3D12_SUBRESOURCE_DATA vertex_data = {};
-            vertex_data.pData = asset_data + SampleAssets::VertexDataOffset;
-            vertex_data.RowPitch = SampleAssets::VertexDataSize;
-            vertex_data.SlicePitch = vertex_data.RowPitch;
-
-            PIXBeginEvent(cmdlist.Get(), 0, L"copy vertex data to default resource...");
-            UpdateSubresources<1>(
-                cmdlist.Get(),
-                vb_.Get(),
-                vb_upload_.Get(),
-                0 /* intermediate offset */,
-                0 /* first subresource */,
-                1 /* num of subresources */,
-                &vertex_data
+            // -- copy data to upload ring and
+            // -- then schecule a copy from upload ring to vertex buffer
+            StreamCopy(vb_upload.cpu, assets_.vertex_data, assets_.vertex_data_size);
+
+            ID3D12GraphicsCommandList * copy_cmdlist = nullptr;
+            ThrowIfFailed(upload_service_.Record(&copy_cmdlist));
+            PIXBeginEvent(copy_cmdlist, 0, L"copy vertex data to default resource...");
+            copy_cmdlist->CopyBufferRegion(
+                vb_.Get(), 0,
+                vb_upload.buffer, vb_upload.offset,
+                assets_.vertex_data_size
             );
-            cmdlist->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-                vb_.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-            ));
-            PIXEndEvent(cmdlist.Get());
+            PIXEndEvent(copy_cmdlist);
+            upload_tracker_.Track(UploadVertices, upload_service_.BatchTicket());
         }
         // -- initialize vertex buffer view
         vb_view_.BufferLocation = vb_->GetGPUVirtualAddress();
-        vb_view_.SizeInBytes = SampleAssets::VertexDataSize;
-        vb_view_.StrideInBytes = SampleAssets::StandardVertexStride;
+        vb_view_.SizeInBytes = assets_.vertex_data_size;
+        vb_view_.StrideInBytes = assets_.vertex_stride;
+    }
+    // -- create position-only vertex buffer (for the shadow pass):
+    {
+        UINT const vertex_count =
+            assets_.vertex_data_size / assets_.vertex_stride;
+        UINT const position_stride = PositionStride(assets_.vertex_format);
+        UINT const position_data_size = vertex_count * position_stride;
+        ThrowIfFailed(buffer_heaps_.CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(position_data_size),
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            &position_vb_,
+            &allocation
+        ));
+        NAME_D3D12_OBJECT(position_vb_);
+        {
+            UploadAllocation position_vb_upload;
+            ThrowIfFailed(upload_service_.Allocate(
+                position_data_size, sizeof(UINT), &position_vb_upload
+            ));
+
+            // -- de-interleave straight into the upload ring and
+            // -- then schedule a copy from upload ring to position buffer
+            DeinterleavePositions(
+                assets_.vertex_data, vertex_count,
+                assets_.vertex_stride, position_stride,
+                position_vb_upload.cpu
+            );
+
+            ID3D12GraphicsCommandList * copy_cmdlist = nullptr;
+            ThrowIfFailed(upload_service_.Record(&copy_cmdlist));
+            PIXBeginEvent(copy_cmdlist, 0, L"copy position data to default resource...");
+            copy_cmdlist->CopyBufferRegion(
+                position_vb_.Get(), 0,
+                position_vb_upload.buffer, position_vb_upload.offset,
+                position_data_size
+            );
+            PIXEndEvent(copy_cmdlist);
+            upload_tracker_.Track(UploadPositions, upload_service_.BatchTicket());
+        }
+        // -- initialize position buffer view
+        position_vb_view_.BufferLocation = position_vb_->GetGPUVirtualAddress();
+        position_vb_view_.SizeInBytes = position_data_size;
+        position_vb_view_.StrideInBytes = position_stride;
     }
     // -- create index buffer:
+    // NOTE(omid): one buffer, 16-bit indices first then the 32-bit ones
     {
-        ThrowIfFailed(device_->CreateCommittedResource(
-            &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-            D3D12_HEAP_FLAG_NONE,
-            &CD3DX12_RESOURCE_DESC::Buffer(SampleAssets::IndexDataSize),
-            D3D12_RESOURCE_STATE_COPY_DEST,
+        UINT const index16_region_size = (assets_.index16_data_size + 3) & ~3u;
+        UINT const index_buffer_size =
+            index16_region_size + assets_.index_data_size;
+        ThrowIfFailed(buffer_heaps_.CreateResource(
+            CD3DX12_RESOURCE_DESC::Buffer(index_buffer_size),
+            D3D12_RESOURCE_STATE_COMMON,
             nullptr,
-            IID_PPV_ARGS(&ib_)
+            &ib_,
+            &allocation
         ));
         NAME_D3D12_OBJECT(ib_);
         {
-            ThrowIfFailed(device_->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                D3D12_HEAP_FLAG_NONE,
-                &CD3DX12_RESOURCE_DESC::Buffer(SampleAssets::IndexDataSize),
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&ib_upload_)
+            UploadAllocation ib_upload;
+            ThrowIfFailed(upload_service_.Allocate(
+                index_buffer_size, sizeof(UINT), &ib_upload
             ));
 
-            // -- copy data to upload heap and 
-            // -- then schecule a copy from upload heap to index buffer
-            D3D12_SUBRESOURCE_DATA index_data = {};
-            index_data.pData = asset_data + SampleAssets::IndexDataOffset;
-            index_data.RowPitch = SampleAssets::IndexDataSize;
-            index_data.SlicePitch = index_data.RowPitch;
-
-            PIXBeginEvent(cmdlist.Get(), 0, L"copy index data to default resource...");
-            UpdateSubresources<1>(
-                cmdlist.Get(),
-                ib_.Get(),
-                ib_upload_.Get(),
-                0 /* intermediate offset */,
-                0 /* first subresource */,
-                1 /* num of subresources */,
-                &index_data
+            // -- copy both regions to upload ring and
+            // -- then schecule a copy from upload ring to index buffer
+            if (assets_.index16_data_size > 0)
+                StreamCopy(ib_upload.cpu, assets_.index16_data, assets_.index16_data_size);
+            if (assets_.index_data_size > 0)
+                StreamCopy(
+                    ib_upload.cpu + index16_region_size,
+                    assets_.index_data,
+                    assets_.index_data_size
+                );
+
+            ID3D12GraphicsCommandList * copy_cmdlist = nullptr;
+            ThrowIfFailed(upload_service_.Record(&copy_cmdlist));
+            PIXBeginEvent(copy_cmdlist, 0, L"copy index data to default resource...");
+            copy_cmdlist->CopyBufferRegion(
+                ib_.Get(), 0,
+                ib_upload.buffer, ib_upload.offset,
+                index_buffer_size
             );
-            cmdlist->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-                ib_.Get(),
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                D3D12_RESOURCE_STATE_INDEX_BUFFER
-            ));
-            PIXEndEvent(cmdlist.Get());
+            PIXEndEvent(copy_cmdlist);
+            upload_tracker_.Track(UploadIndices, upload_service_.BatchTicket());
         }
-        // -- initialize index buffer view
-        ib_view_.BufferLocation = ib_->GetGPUVirtualAddress();
-        ib_view_.SizeInBytes = SampleAssets::IndexDataSize;
-        ib_view_.Format = SampleAssets::StandardIndexFormat;
+        // -- initialize index buffer views
+        ib16_view_.BufferLocation = ib_->GetGPUVirtualAddress();
+        ib16_view_.SizeInBytes = assets_.index16_data_size;
+        ib16_view_.Format = DXGI_FORMAT_R16_UINT;
+        ib_view_.BufferLocation = ib_->GetGPUVirtualAddress() + index16_region_size;
+        ib_view_.SizeInBytes = assets_.index_data_size;
+        ib_view_.Format = assets_.index_format;
     }
+    // -- geometry goes first in a batch of its own, so the first frames
+    // -- only wait for it and not for the textures
+    UINT64 ticket = 0;
+    ThrowIfFailed(upload_service_.Submit(&ticket));
     //
     // -- create shader resources
     {
@@ -666,89 +998,24 @@ void OdxMultithreading::LoadAssets () {
             cbvsrv_handle.Offset(cbv_srv_descriptor_size);
         }
         // -- create each texture and srv descriptor
-        UINT const srv_count = ArrayCount(SampleAssets::Textures);
-        PIXBeginEvent(cmdlist.Get(), 0, L"copy diffuse and normal data to default resource");
-        for (UINT i = 0; i < srv_count; ++i) {
-            // -- describe and create a Texture2D
-            SampleAssets::TextureResource const & tex =
-                SampleAssets::Textures[i];
-            CD3DX12_RESOURCE_DESC tex_desc(
-                D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-                0 /* alignment */,
-                tex.Width,
-                tex.Height,
-                1 /* depthorarray size */,
-                static_cast<UINT16>(tex.MipLevels),
-                tex.Format,
-                1 /* sample count */,
-                0 /* sample quality */,
-                D3D12_TEXTURE_LAYOUT_UNKNOWN,
-                D3D12_RESOURCE_FLAG_NONE
-            );
-            ThrowIfFailed(device_->CreateCommittedResource(
-                &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-                D3D12_HEAP_FLAG_NONE,
-                &tex_desc,
-                D3D12_RESOURCE_STATE_COPY_DEST,
-                nullptr,
-                IID_PPV_ARGS(&textures_[i])
-            ));
-            NAME_D3D12_OBJECT_INDEXED(textures_, i);
-            {
-                UINT const subresource_count =
-                    tex_desc.DepthOrArraySize * tex_desc.MipLevels;
-                UINT64 upload_buf_size = GetRequiredIntermediateSize(
-                    textures_[i].Get(), 0 /*first subresource */, subresource_count
-                );
-                ThrowIfFailed(device_->CreateCommittedResource(
-                    &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-                    D3D12_HEAP_FLAG_NONE,
-                    &CD3DX12_RESOURCE_DESC::Buffer(upload_buf_size),
-                    D3D12_RESOURCE_STATE_GENERIC_READ,
-                    nullptr,
-                    IID_PPV_ARGS(&texture_uploads_[i])
-                ));
-
-                // -- copy data to intermediate upload heap
-                // -- and schedule a copy from upload heap to the Texture2D
-                D3D12_SUBRESOURCE_DATA texture_data = {};
-                texture_data.pData = asset_data + tex.Data->Offset;
-                texture_data.RowPitch = tex.Data->Pitch;
-                texture_data.SlicePitch = tex.Data->Size;
-
-                UpdateSubresources(
-                    cmdlist.Get(),
-                    textures_[i].Get(),
-                    texture_uploads_[i].Get(),
-                    0 /* intermediate offset */,
-                    0 /* first subresource */,
-                    subresource_count,
-                    &texture_data
-                );
-                cmdlist->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-                    textures_[i].Get(),
-                    D3D12_RESOURCE_STATE_COPY_DEST,
-                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-                ));
-            }
-            // -- describe and create an SRV
-            D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
-            srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-            srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-            srv_desc.Format = tex.Format;
-            srv_desc.Texture2D.MipLevels = tex.MipLevels;
-            srv_desc.Texture2D.MostDetailedMip = 0;
-            srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
-            device_->CreateShaderResourceView(
-                textures_[i].Get(),
-                &srv_desc,
-                cbvsrv_handle
-            );
-            cbvsrv_handle.Offset(cbv_srv_descriptor_size);
-        }
-        PIXEndEvent(cmdlist.Get());
+        LoadTextures(cbvsrv_handle, cbv_srv_descriptor_size);
+    }
+    // -- everything has been staged in the upload ring, drop the file bytes
+    FreeAssetPack();
+    {
+        char message[256];
+        sprintf_s(
+            message,
+            "heaps: buffers %u (%.1f of %.1f MB), textures %u (%.1f of %.1f MB)\n",
+            buffer_heaps_.HeapCount(),
+            buffer_heaps_.UsedSize() / (1024.0 * 1024.0),
+            buffer_heaps_.ReservedSize() / (1024.0 * 1024.0),
+            texture_heaps_.HeapCount(),
+            texture_heaps_.UsedSize() / (1024.0 * 1024.0),
+            texture_heaps_.ReservedSize() / (1024.0 * 1024.0)
+        );
+        OutputDebugStringA(message);
     }
-    free(asset_data);
     //
     // -- create samplers
     {
@@ -816,6 +1083,8 @@ void OdxMultithreading::LoadAssets () {
 
         light_cameras_[i].Set(eye, at, up);
     }
+    // -- new frame resources below, every constant block is to be written
+    dirty_cbuffers_ = (1u << ConstantBlockCount) - 1;
     // -- close the cmdlist and use it to execute gpu inital setup
     ThrowIfFailed(cmdlist->Close());
     ID3D12CommandList * cmdlists [] = {cmdlist.Get()};
@@ -824,25 +1093,68 @@ void OdxMultithreading::LoadAssets () {
     );
 
     // -- create frame resources
-    for (int i = 0; i < FrameCount; ++i) {
+    // NOTE(omid): constants for every draw (shared by both passes),
+    // plus the chunk tail each worker may leave unused
+    UINT64 const constants_size =
+        draws_.size() * CalculateCBufferByteSize(sizeof(DrawCBuffer)) +
+        NumContexts * FrameConstants::ChunkSize;
+    draw_constants_.assign(draws_.size(), 0);
+    command_pool_.Init(device_.Get());
+    // -- one square tile per light at the chosen preset, independent of
+    // -- the swapchain size (the shader reads the size from constants)
+    if (!shadow_atlas_.Init(
+        shadow_resolution_, shadow_resolution_, NumLights,
+        D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION
+    )) {
+        ThrowIfFailed(E_INVALIDARG);
+    }
+    // -- the fewest atlases the pipelining allows unless asked for more,
+    // -- dsvs after the scene depth, srvs after the textures
+    {
+        // -- a cached tile is read frames after it was drawn, in the one map
+        UINT const map_count = cache_shadows_ ? 1 : std::min(
+            std::max(shadow_map_count_, ShadowMaps::MinCount()), frames_in_flight_
+        );
+        ThrowIfFailed(shadow_maps_.Init(
+            device_.Get(),
+            shadow_atlas_.Width(), shadow_atlas_.Height(),
+            map_count, shadow_alias_,
+            dsv_heap_.Get(), 1,
+            cbv_srv_heap_.Get(), 2 + static_cast<UINT>(textures_.size())
+        ));
+        // -- against an atlas per frame in flight, as before
+        ShadowMapStats const stats = shadow_maps_.Stats();
+        char message[256];
+        sprintf_s(
+            message,
+            "shadows: %u lights at %ux%u, atlas %ux%u (%.1f MB), %u for %u frames%s: "
+            "%.1f MB, was %.1f MB\n",
+            NumLights, shadow_resolution_, shadow_resolution_,
+            shadow_atlas_.Width(), shadow_atlas_.Height(),
+            stats.map_bytes / (1024.0 * 1024.0),
+            stats.count, frames_in_flight_,
+            stats.heap_bytes < stats.map_bytes * stats.count ? " aliased" : "",
+            stats.heap_bytes / (1024.0 * 1024.0),
+            stats.map_bytes * frames_in_flight_ / (1024.0 * 1024.0)
+        );
+        OutputDebugStringA(message);
+    }
+    shadow_cache_.Init(cache_shadows_, shadow_budget_);
+    ThrowIfFailed(shadow_timer_.Init(device_.Get(), cmdqueue_.Get(), frames_in_flight_));
+    for (int i = 0; i < static_cast<int>(frames_in_flight_); ++i) {
         frame_resources_[i] = new FrameResource(
             device_.Get(),
             pso_.Get(), pso_smap_.Get(),
-            dsv_heap_.Get(), cbv_srv_heap_.Get(),
-            &viewport_, i
-        );
-        frame_resources_[i]->WriteCBuffers(
-            &viewport_,
-            &camera_,
-            light_cameras_,
-            lights_
+            cbv_srv_heap_.Get(), shadow_atlas_,
+            constants_size
         );
     }
     current_frame_resource_index_ = 0;
     current_frame_resource_ = frame_resources_[current_frame_resource_index_];
 
     // -- create syncronization objects
-    // -- and wait until assets hav been uploaded to gpu
+    // -- and wait until the setup cmdlist has executed
+    // NOTE(omid): asset copies keep running on the upload queue
     {
         ThrowIfFailed(device_->CreateFence(
             fence_value_, D3D12_FENCE_FLAG_NONE,
@@ -869,9 +1181,388 @@ void OdxMultithreading::LoadAssets () {
             fence_->SetEventOnCompletion(fence_to_wait_for, fence_event_)
         );
         WaitForSingleObject(fence_event_, INFINITE);
+
+        ID3D12Fence * const fences [WaitFenceCount] = {
+            fence_.Get(), upload_service_.Fence()
+        };
+        ThrowIfFailed(fence_waiter_.Init(fences, WaitFenceCount, frames_in_flight_));
+    }
+}
+//
+// -- create the pack textures and their srvs and stage their data
+// NOTE(omid): footprints, srvs and the row copies into the upload ring run
+// as jobs on the task pool, only resource creation, ring allocation and
+// recording the copies stay on the main thread
+void OdxMultithreading::LoadTextures (
+    D3D12_CPU_DESCRIPTOR_HANDLE first_srv,
+    UINT descriptor_size
+) {
+    struct TextureJob {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[D3D12_REQ_MIP_LEVELS];
+        UINT row_counts[D3D12_REQ_MIP_LEVELS];
+        UINT64 row_sizes[D3D12_REQ_MIP_LEVELS];
+        UINT64 upload_size;
+        UploadAllocation upload;
+        bool upload_layout;     // -- texels already laid out like the footprints
+        UINT first_chunk;       // -- of a compressed pack
+        UINT chunk_count;
+        std::vector<UINT8> unpacked;    // -- decoded texels when not in upload layout
+    };
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER prepared;
+    LARGE_INTEGER end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    UINT const texture_count = assets_.texture_count;
+    textures_.resize(texture_count);
+    std::vector<TextureJob> jobs(texture_count);
+    HeapAllocation allocation;
+    for (UINT i = 0; i < texture_count; ++i) {
+        // -- describe and create a Texture2D
+        SampleAssets::TextureResource const & tex = assets_.textures[i];
+        CD3DX12_RESOURCE_DESC tex_desc(
+            D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+            0 /* alignment */,
+            tex.Width,
+            tex.Height,
+            1 /* depthorarray size */,
+            static_cast<UINT16>(tex.MipLevels),
+            tex.Format,
+            1 /* sample count */,
+            0 /* sample quality */,
+            D3D12_TEXTURE_LAYOUT_UNKNOWN,
+            D3D12_RESOURCE_FLAG_NONE
+        );
+        ThrowIfFailed(texture_heaps_.CreateResource(
+            tex_desc,
+            D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            &textures_[i],
+            &allocation
+        ));
+        NAME_D3D12_OBJECT_INDEXED(textures_, i);
+    }
+    // -- copyable footprints and srv of each texture
+    task_pool_.ParallelFor(texture_count, [&] (UINT i) {
+        SampleAssets::TextureResource const & tex = assets_.textures[i];
+        TextureJob & job = jobs[i];
+        D3D12_RESOURCE_DESC const tex_desc = textures_[i]->GetDesc();
+        device_->GetCopyableFootprints(
+            &tex_desc, 0 /* first subresource */, tex.MipLevels, 0 /* base offset */,
+            job.layouts, job.row_counts, job.row_sizes, &job.upload_size
+        );
+        // -- packs cook texels in this layout (see LayoutTexturesForUpload),
+        // -- but it is the device's call, check before copying in one go
+        job.upload_layout = true;
+        for (UINT m = 0; m < tex.MipLevels; ++m)
+            job.upload_layout = job.upload_layout &&
+                tex.Data[m].Offset - tex.Data[0].Offset == job.layouts[m].Offset &&
+                tex.Data[m].Pitch == job.layouts[m].Footprint.RowPitch;
+        UINT const last_mip = tex.MipLevels - 1;
+        job.upload_layout = job.upload_layout &&
+            tex.Data[last_mip].Offset + UINT64(tex.Data[last_mip].Size) >=
+            tex.Data[0].Offset + job.upload_size;
+
+        // -- describe and create an SRV
+        D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+        srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srv_desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srv_desc.Format = tex.Format;
+        srv_desc.Texture2D.MipLevels = tex.MipLevels;
+        srv_desc.Texture2D.MostDetailedMip = 0;
+        srv_desc.Texture2D.ResourceMinLODClamp = 0.0f;
+        device_->CreateShaderResourceView(
+            textures_[i].Get(),
+            &srv_desc,
+            CD3DX12_CPU_DESCRIPTOR_HANDLE(first_srv, i, descriptor_size)
+        );
+    });
+    QueryPerformanceCounter(&prepared);
+    UINT whole_copies = 0;
+    for (TextureJob const & job : jobs)
+        whole_copies += job.upload_layout ? 1 : 0;
+    // -- compressed pack: which chunks make up each texture (ParsePack
+    // -- made sure none is shared), and where to decode the odd ones
+    bool const compressed = nullptr != assets_.texture_chunks;
+    std::vector<UINT> chunk_textures(assets_.texture_chunk_count);
+    std::vector<UINT> group_chunks;
+    for (UINT i = 0; compressed && i < texture_count; ++i) {
+        SampleAssets::TextureResource const & tex = assets_.textures[i];
+        TextureJob & job = jobs[i];
+        UINT64 texture_end = 0;
+        for (UINT m = 0; m < tex.MipLevels; ++m)
+            texture_end = std::max(texture_end, UINT64(tex.Data[m].Offset) + tex.Data[m].Size);
+        if (!FindTextureChunks(
+            assets_, tex.Data[0].Offset, texture_end, &job.first_chunk, &job.chunk_count
+        )) {
+            ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+        }
+        for (UINT c = 0; c < job.chunk_count; ++c)
+            chunk_textures[job.first_chunk + c] = i;
+        if (!job.upload_layout)
+            job.unpacked.resize(static_cast<size_t>(texture_end - tex.Data[0].Offset));
+    }
+    std::atomic<bool> decoded(true);
+    LONGLONG decode_ticks = 0;
+
+    // -- stage about a batch worth of textures at a time:
+    // -- allocate here, fill the ring on the pool, then record the copies
+    // NOTE(omid): every group starts with nothing pending in the ring and
+    // stays well under its size, so allocating never has to submit (and
+    // retire) part of the group before its copies are recorded
+    UINT64 ticket = 0;
+    UINT64 staged_bytes = 0;
+    UINT first = 0;
+    while (first < texture_count) {
+        UINT last = first;
+        UINT64 group_size = 0;
+        do {
+            ThrowIfFailed(upload_service_.Allocate(
+                jobs[last].upload_size,
+                D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT,
+                &jobs[last].upload
+            ));
+            group_size += jobs[last].upload_size;
+            ++last;
+        } while (
+            last < texture_count &&
+            group_size + jobs[last].upload_size <= UploadBatchSize
+        );
+
+        if (compressed) {
+            // -- chunks are finer grained than textures, decode those in parallel
+            LARGE_INTEGER decode_start;
+            LARGE_INTEGER decode_end;
+            QueryPerformanceCounter(&decode_start);
+            group_chunks.clear();
+            for (UINT i = first; i < last; ++i)
+                for (UINT c = 0; c < jobs[i].chunk_count; ++c)
+                    group_chunks.push_back(jobs[i].first_chunk + c);
+            task_pool_.ParallelFor(static_cast<UINT>(group_chunks.size()), [&] (UINT k) {
+                PackChunk const & chunk = assets_.texture_chunks[group_chunks[k]];
+                UINT const i = chunk_textures[group_chunks[k]];
+                TextureJob & job = jobs[i];
+                UINT64 const rel = chunk.raw_offset - assets_.textures[i].Data[0].Offset;
+                if (!job.upload_layout) {
+                    if (!DecodePackChunk(chunk, assets_.texture_payload, job.unpacked.data() + rel))
+                        decoded = false;
+                    return;
+                }
+                // NOTE(omid): lz4 reads back what it wrote, so decode into a
+                // cached scratch and stream that into the write-combined ring
+                static thread_local std::vector<UINT8> scratch;
+                scratch.resize(PackChunkSize);
+                if (!DecodePackChunk(chunk, assets_.texture_payload, scratch.data())) {
+                    decoded = false;
+                    return;
+                }
+                if (rel < job.upload_size)
+                    StreamCopy(
+                        job.upload.cpu + rel,
+                        scratch.data(),
+                        static_cast<size_t>(std::min<UINT64>(chunk.raw_size, job.upload_size - rel))
+                    );
+            });
+            if (!decoded)
+                ThrowIfFailed(HRESULT_FROM_WIN32(ERROR_INVALID_DATA));
+            QueryPerformanceCounter(&decode_end);
+            decode_ticks += decode_end.QuadPart - decode_start.QuadPart;
+        }
+
+        task_pool_.ParallelFor(last - first, [&] (UINT job_index) {
+            UINT const i = first + job_index;
+            SampleAssets::TextureResource const & tex = assets_.textures[i];
+            TextureJob const & job = jobs[i];
+            if (job.upload_layout) {
+                // -- compressed ones were decoded in place above
+                if (!compressed)
+                    StreamCopy(
+                        job.upload.cpu,
+                        assets_.texture_data + tex.Data[0].Offset,
+                        static_cast<size_t>(job.upload_size)
+                    );
+                return;
+            }
+            UINT8 const * texels = compressed ?
+                job.unpacked.data() : assets_.texture_data + tex.Data[0].Offset;
+            for (UINT m = 0; m < tex.MipLevels; ++m) {
+                // -- 2d textures, one slice per mip
+                // NOTE(omid): streaming copy, the ring is write-combined
+                CopyRows(
+                    job.upload.cpu + job.layouts[m].Offset,
+                    job.layouts[m].Footprint.RowPitch,
+                    texels + (tex.Data[m].Offset - tex.Data[0].Offset),
+                    tex.Data[m].Pitch,
+                    static_cast<size_t>(job.row_sizes[m]),
+                    job.row_counts[m]
+                );
+            }
+        });
+
+        ID3D12GraphicsCommandList * copy_cmdlist = nullptr;
+        ThrowIfFailed(upload_service_.Record(&copy_cmdlist));
+        for (UINT i = first; i < last; ++i) {
+            TextureJob const & job = jobs[i];
+            for (UINT m = 0; m < assets_.textures[i].MipLevels; ++m) {
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout = job.layouts[m];
+                layout.Offset += job.upload.offset;
+                CD3DX12_TEXTURE_COPY_LOCATION const dst(textures_[i].Get(), m);
+                CD3DX12_TEXTURE_COPY_LOCATION const src(job.upload.buffer, layout);
+                copy_cmdlist->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+            }
+            upload_tracker_.Track(UploadFirstTexture + i, upload_service_.BatchTicket());
+        }
+        // -- hand over each group so textures land progressively
+        ThrowIfFailed(upload_service_.Submit(&ticket));
+        staged_bytes += group_size;
+        first = last;
+    }
+    QueryPerformanceCounter(&end);
+
+    char message[256];
+    sprintf_s(
+        message,
+        "textures: %u (%.1f MB, %u copied whole) on %u threads in %.2f ms "
+        "(footprints and srvs %.2f ms, staging %.2f ms)\n",
+        texture_count, staged_bytes / (1024.0 * 1024.0), whole_copies,
+        task_pool_.ThreadCount(),
+        (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart,
+        (prepared.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart,
+        (end.QuadPart - prepared.QuadPart) * 1000.0 / frequency.QuadPart
+    );
+    OutputDebugStringA(message);
+    if (compressed) {
+        UINT64 stored = 0;
+        for (UINT c = 0; c < assets_.texture_chunk_count; ++c)
+            stored += assets_.texture_chunks[c].size;
+        sprintf_s(
+            message,
+            "textures: %u lz4 chunks, %.1f -> %.1f MB decoded in %.2f ms\n",
+            assets_.texture_chunk_count,
+            stored / (1024.0 * 1024.0),
+            assets_.texture_data_size / (1024.0 * 1024.0),
+            decode_ticks * 1000.0 / frequency.QuadPart
+        );
+        OutputDebugStringA(message);
     }
 }
 //
+// -- map the cooked asset pack, cooking it again from the raw file when the
+// -- pack is missing, corrupt, or its cache key does not match the source
+// -- and cooker (returns true on a cache hit)
+bool OdxMultithreading::LoadAssetPack () {
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    std::wstring const pack_path =
+        GetAssetFullPath(SampleAssets::PackFilename);
+    std::wstring const source_path =
+        GetAssetFullPath(SampleAssets::DataFilename);
+    // NOTE(omid): size and write time stand in for the hash, the source
+    // is only read (and hashed) when they differ from the pack's key
+    PackSource source = {};
+    bool const has_source = SUCCEEDED(GetFileStamp(
+        source_path.c_str(), &source.size, &source.write_time
+    ));
+    UINT legacy_size = 0;
+    UINT8 * legacy_data = nullptr;
+    char const * result = "miss, no pack";
+    bool hit = false;
+    if (
+        FileExists(pack_path.c_str()) &&
+        SUCCEEDED(asset_file_.Open(pack_path.c_str()))
+    ) {
+        result = "miss, corrupt pack";
+        if (SUCCEEDED(ParsePack(
+            asset_file_.Data(), asset_file_.Size(), VerifyPackPayloads, &assets_
+        ))) {
+            result = "miss, cooker changed";
+            if (CookerVersion == assets_.cooker_version) {
+                PackSource const & key = assets_.source;
+                result = "miss, source changed";
+                if (
+                    !has_source ||      // -- shipped without the raw file
+                    (key.size == source.size && key.write_time == source.write_time)
+                ) {
+                    result = "hit";
+                    hit = true;
+                } else if (key.size == source.size) {
+                    ThrowIfFailed(ReadDataFromFile(
+                        source_path.c_str(), &legacy_data, &legacy_size
+                    ));
+                    source.hash = Hash64(legacy_data, legacy_size);
+                    if (key.hash == source.hash) {
+                        // -- touched but unchanged, refresh the stamp
+                        asset_file_.Close();
+                        WriteDataToFileAt(
+                            pack_path.c_str(),
+                            offsetof(PackHeader, source),
+                            &source, sizeof(source)
+                        );
+                        ThrowIfFailed(asset_file_.Open(pack_path.c_str()));
+                        ThrowIfFailed(ParsePack(
+                            asset_file_.Data(), asset_file_.Size(), false, &assets_
+                        ));
+                        result = "hit, source touched";
+                        hit = true;
+                    }
+                }
+            }
+        }
+        if (!hit) {
+            asset_file_.Close();
+            assets_ = {};
+        }
+    }
+    if (!hit) {
+        if (nullptr == legacy_data) {
+            ThrowIfFailed(ReadDataFromFile(
+                source_path.c_str(), &legacy_data, &legacy_size
+            ));
+            source.hash = Hash64(legacy_data, legacy_size);
+        }
+        HRESULT const hr =
+            CookLegacyAssets(legacy_data, legacy_size, source, &cooked_pack_);
+        free(legacy_data);
+        legacy_data = nullptr;
+        ThrowIfFailed(hr);
+
+        // -- keep the pack for next runs (not fatal if the folder is read-only)
+        WriteDataToFile(
+            pack_path.c_str(),
+            cooked_pack_.data(),
+            static_cast<UINT>(cooked_pack_.size())
+        );
+        ThrowIfFailed(ParsePack(
+            cooked_pack_.data(), cooked_pack_.size(), false, &assets_
+        ));
+    }
+    free(legacy_data);
+    QueryPerformanceCounter(&end);
+
+    char message[256];
+    sprintf_s(
+        message,
+        "asset cache: %s, pack %.1f MB ready in %.2f ms\n",
+        result,
+        (hit ? asset_file_.Size() : cooked_pack_.size()) / (1024.0 * 1024.0),
+        (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart
+    );
+    OutputDebugStringA(message);
+    return hit;
+}
+void OdxMultithreading::FreeAssetPack () {
+    asset_file_.Close();
+    cooked_pack_.clear();
+    cooked_pack_.shrink_to_fit();
+    assets_ = {};
+}
+//
 // -- initialize events and threads
 void OdxMultithreading::LoadContexts () {
 #if !SINGLETHREADED
@@ -926,9 +1617,24 @@ void OdxMultithreading::RestoreD3DResources () {
     OnInit();
 }
 void OdxMultithreading::ReleaseD3DResources () {
+    // -- drain the copy queue, then placed resources, then the heaps under them
+    upload_service_.Release();
+    fence_waiter_.Release();
+    command_pool_.Release();
+    shadow_maps_.Release();
+    shadow_timer_.Release();
+    textures_.clear();
+    ib_.Reset();
+    vb_.Reset();
+    position_vb_.Reset();
+    texture_heaps_.Release();
+    buffer_heaps_.Release();
     fence_.Reset();
     ResetComPtrArray(&render_targets_);
     cmdqueue_.Reset();
+    if (nullptr != frame_latency_waitable_)
+        CloseHandle(frame_latency_waitable_);
+    frame_latency_waitable_ = nullptr;
     swapchain_.Reset();
     device_.Reset();
 }
@@ -943,7 +1649,10 @@ void OdxMultithreading::WaitForGpu () {
 //
 // -- assemble the CmdlistPre list of commands
 void OdxMultithreading::BeginFrame () {
-    current_frame_resource_->Init();
+    current_frame_resource_->Init(
+        &command_pool_, &shadow_maps_, fence_waiter_.Completed(FenceGraphics),
+        shadow_lights_
+    );
 
     // -- indicate that back buffer will be used as a render target
     current_frame_resource_->cmdlists_[CmdlistPre]->ResourceBarrier(
@@ -970,6 +1679,10 @@ void OdxMultithreading::BeginFrame () {
         D3D12_CLEAR_FLAG_DEPTH,
         1.0, 0, 0, nullptr
     );
+    // -- the shadow lists run between Pre and Mid
+    shadow_timer_.Begin(
+        current_frame_resource_->cmdlists_[CmdlistPre], current_frame_resource_index_
+    );
     ThrowIfFailed(
         current_frame_resource_->cmdlists_[CmdlistPre]->Close()
     );
@@ -977,6 +1690,9 @@ void OdxMultithreading::BeginFrame () {
 //
 // -- assemble the CmdlistMid list of commands
 void OdxMultithreading::MidFrame () {
+    shadow_timer_.End(
+        current_frame_resource_->cmdlists_[CmdlistMid], current_frame_resource_index_
+    );
     // -- transition the smap from shadpw pass to readable in the scene pass
     current_frame_resource_->SwapBarriers();
     ThrowIfFailed(
@@ -1006,12 +1722,26 @@ OdxMultithreading::OdxMultithreading (UINT width, UINT height, std::wstring name
     viewport_(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)),
     scissor_rect_(0, 0, static_cast<LONG>(width), static_cast<LONG>(height)),
     keyboard_input_(), title_count_(0), cpu_time_(0),
-    fence_value_(0), rtv_descriptor_size_(0),
+    fence_value_(0), frame_latency_waitable_(nullptr), rtv_descriptor_size_(0),
+    frame_resources_(),
     current_frame_resource_index_(0),
-    current_frame_resource_(nullptr)
+    current_frame_resource_(nullptr),
+    assets_(),
+    shadow_lights_(0), shadow_views_(), shadow_projections_(),
+    scene_frustum_(), shadow_frustums_(),
+    scene_triangles_(), shadow_triangles_(), total_triangles_(0),
+    title_scene_triangles_(0), title_shadow_triangles_(0),
+    cbuffers_(), dirty_cbuffers_((1u << ConstantBlockCount) - 1),
+    cbuffer_bytes_(0), title_cbuffer_bytes_(0),
+    stall_time_(0), title_stall_time_(0)
 {
     s_app = this;
     keyboard_input_.animate = true;
+    // -- scale down the world a bit (transposed for hlsl)
+    XMStoreFloat4x4(
+        &draw_model_,
+        XMMatrixTranspose(XMMatrixScaling(SceneScale, SceneScale, SceneScale))
+    );
     ThrowIfFailed(DXGIDeclareAdapterRemovalSupport());
 }
 OdxMultithreading::~OdxMultithreading () {
@@ -1019,41 +1749,68 @@ OdxMultithreading::~OdxMultithreading () {
 }
 
 void OdxMultithreading::OnInit () {
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER start;
+    LARGE_INTEGER end;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+
+    bool const warm = LoadAssetPack();
     LoadPipeLine();
     LoadAssets();
     LoadContexts();
+
+    QueryPerformanceCounter(&end);
+    char message[128];
+    sprintf_s(
+        message,
+        "init: %s start in %.2f ms\n",
+        warm ? "warm" : "cold",
+        (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart
+    );
+    OutputDebugStringA(message);
 }
 void OdxMultithreading::OnUpdate () {
+    // -- low latency: block until the swapchain can take this frame,
+    // -- so input below is sampled as late as possible
+    if (nullptr != frame_latency_waitable_)
+        WaitForSingleObjectEx(frame_latency_waitable_, 1000, TRUE);
     timer_.Tick(NULL);
+    frame_timings_.Start();
 
     PIXSetMarker(cmdqueue_.Get(), 0, L"Getting last completed fence...");
 
-    // -- get current gpu progress against submitted workload.
-    // -- resources still scheduled for gpu execution cannot be modified
-    UINT64 const last_completed_fence = fence_->GetCompletedValue();
+    // -- copy progress as last seen by the fence waiter's thread
+    UINT64 const completed_upload = fence_waiter_.Completed(FenceUpload);
+    upload_service_.Retire(completed_upload);
+    upload_tracker_.Update(completed_upload);
 
     // -- move to next frame
     current_frame_resource_index_ =
-        (current_frame_resource_index_ + 1) % FrameCount;
+        (current_frame_resource_index_ + 1) % frames_in_flight_;
     current_frame_resource_ = frame_resources_[current_frame_resource_index_];
 
     // -- make sure current frame resource is not in use by gpu
-    // -- otherwise wait for it to complete
-    if (current_frame_resource_->fence_value_ > last_completed_fence) {
-        HANDLE event_handle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-        if (nullptr == event_handle)
-            ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-        ThrowIfFailed(fence_->SetEventOnCompletion(
-            current_frame_resource_->fence_value_, event_handle
-        ));
-        WaitForSingleObject(event_handle, INFINITE);
-        CloseHandle(event_handle);
-    }
+    // -- otherwise wait for it to complete (usually already retired)
+    ThrowIfFailed(fence_waiter_.WaitForItem(current_frame_resource_index_));
+    stall_time_ = fence_waiter_.TakeStallTime();
+    command_pool_.Recycle(
+        D3D12_COMMAND_LIST_TYPE_DIRECT, fence_waiter_.Completed(FenceGraphics)
+    );
+    // -- the frame that last used this resource is done, so are its timestamps
+    double shadow_gpu_ms = 0.0;
+    if (shadow_timer_.Read(current_frame_resource_index_, &shadow_gpu_ms))
+        frame_timings_.ShadowGpu(shadow_gpu_ms);
+    frame_timings_.Mark(PhaseFrameWait);
+    // -- so whatever the gpu read from the frame's constants is free again
+    current_frame_resource_->constants_.Reset();
 
     cpu_timer_.Tick(NULL);
     float frame_time = static_cast<float>(timer_.GetElapsedSeconds());
     float frame_change = 2.0f * frame_time;
 
+    present_latency_.InputSampled();
+
     if (keyboard_input_.left_arrow_pressed)
         camera_.RotateYaw(-frame_change);
     if (keyboard_input_.right_arrow_pressed)
@@ -1062,8 +1819,17 @@ void OdxMultithreading::OnUpdate () {
         camera_.RotatePitch(frame_change);
     if (keyboard_input_.down_arrow_pressed)
         camera_.RotatePitch(-frame_change);
+    if (
+        keyboard_input_.left_arrow_pressed || keyboard_input_.right_arrow_pressed ||
+        keyboard_input_.up_arrow_pressed || keyboard_input_.down_arrow_pressed
+    ) {
+        dirty_cbuffers_ |= 1u << ConstantsScenePass;
+    }
 
-    if (keyboard_input_.animate)
+    if (keyboard_input_.animate) {
+        // -- the lights move, their shadow passes follow once they are
+        // -- drawn again (below)
+        dirty_cbuffers_ |= 1u << ConstantsFrame;
         for (int i = 0; i < NumLights; ++i) {
             float direction = frame_change * powf(-1.0f, i);
             XMStoreFloat4(&lights_[i].position, XMVector4Transform(XMLoadFloat4(
@@ -1079,32 +1845,77 @@ void OdxMultithreading::OnUpdate () {
             );
             XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
             light_cameras_[i].Set(eye, at, up);
-
-            light_cameras_[i].Get3DViewProjMatrices(
-                &lights_[i].view,
-                &lights_[i].projection,
-                90.0f,
-                static_cast<float>(width_),
-                static_cast<float>(height_)
-            );
+            shadow_cache_.Moved(i);
         }
+    }
+    // -- pick the lights to draw, the scene samples each tile with the
+    // -- matrices it was drawn with (same as its shadow pass constants)
+    shadow_lights_ = shadow_cache_.Schedule();
+    for (int i = 0; i < NumLights; ++i) {
+        if (0 == (shadow_lights_ & 1u << i))
+            continue;
+        XMFLOAT4X4 view, projection;
+        light_cameras_[i].Get3DViewProjMatrices(
+            &view, &projection, 90.0f,
+            static_cast<float>(shadow_atlas_.TileWidth()),
+            static_cast<float>(shadow_atlas_.TileHeight())
+        );
+        if (
+            0 != memcmp(&view, &shadow_views_[i], sizeof(view)) ||
+            0 != memcmp(&projection, &shadow_projections_[i], sizeof(projection))
+        ) {
+            shadow_views_[i] = view;
+            shadow_projections_[i] = projection;
+            dirty_cbuffers_ |= 1u << ConstantsFrame | 1u << ConstantsShadowPass;
+        }
+    }
 
-    current_frame_resource_->WriteCBuffers(
-        &viewport_, &camera_, light_cameras_, lights_
-    );
+    // -- rebuild what changed, then copy what this frame resource lacks
+    UpdateConstants();
+    cbuffer_bytes_ =
+        current_frame_resource_->WriteCBuffers(cbuffers_) +
+        draws_.size() * sizeof(DrawCBuffer);    // -- written by the workers
+    // -- every light's shadow pass culls against its own view
+    UpdateCullFrustum(&camera_, viewport_.Width, viewport_.Height, &scene_frustum_);
+    for (int i = 0; i < NumLights; ++i) {
+        UpdateCullFrustum(
+            &light_cameras_[i],
+            static_cast<float>(shadow_atlas_.TileWidth()),
+            static_cast<float>(shadow_atlas_.TileHeight()),
+            &shadow_frustums_[i]
+        );
+    }
+    frame_timings_.Mark(PhaseUpdate);
 }
 void OdxMultithreading::OnRender () {
     try {
         BeginFrame();
+        frame_timings_.Mark(PhaseBegin);
+
+        // -- geometry must have landed before anything draws,
+        // -- textures are checked per draw instead (see WorkerThread)
+        UINT const geometry [] = {UploadVertices, UploadPositions, UploadIndices};
+        UINT64 const copy_wait =
+            upload_tracker_.Require(geometry, ArrayCount(geometry));
+        if (0 != copy_wait)
+            ThrowIfFailed(cmdqueue_->Wait(upload_service_.Fence(), copy_wait));
 #if SINGLETHREADED
+        // -- the workers' recording counts as scene lists here
         for (int i = 0; i < NumContexts; ++i)
             WorkerThread(i);
+        frame_timings_.Mark(PhaseSceneLists);
         MidFrame();
         EndFrame();
+        frame_timings_.Mark(PhaseMainRecord);
         cmdqueue_->ExecuteCommandLists(
-            ArrayCount(current_frame_resource_->batch_submit_),
+            current_frame_resource_->PackShadowBatch(),
             current_frame_resource_->batch_submit_
         );
+        cmdqueue_->ExecuteCommandLists(
+            ArrayCount(current_frame_resource_->batch_submit_) - ShadowCmdlistCount - 2,
+            current_frame_resource_->batch_submit_ + ShadowCmdlistCount + 2
+        );
+        frame_timings_.Mark(PhaseSubmit);
 #else
         // -- tell each worker to start drawing
         for (int i = 0; i < NumContexts; ++i)
@@ -1112,54 +1923,147 @@ void OdxMultithreading::OnRender () {
 
         MidFrame();
         EndFrame();
+        frame_timings_.Mark(PhaseMainRecord);
 
         WaitForMultipleObjects(
             NumContexts,
             worker_finish_shadow_pass_,
             TRUE, INFINITE
         );
+        frame_timings_.Mark(PhaseShadowLists);
 
         // -- we can choose to use ExecuteCmdLists on one thread (any thread)
         // -- or use ExecuteCmdList from multiple threads
+        // -- cached lights recorded nothing, only submit the lists drawn
         cmdqueue_->ExecuteCommandLists(
-            NumContexts + 2,
+            current_frame_resource_->PackShadowBatch(),
             current_frame_resource_->batch_submit_ /* submit Pre, Mid and Shadow */
         );
+        frame_timings_.Mark(PhaseSubmit);
         WaitForMultipleObjects(
             NumContexts,
             worker_finished_render_frame_,
             TRUE, INFINITE
         );
+        frame_timings_.Mark(PhaseSceneLists);
 
         // -- submit remaining cmd lists
         cmdqueue_->ExecuteCommandLists(
-            ArrayCount(current_frame_resource_->batch_submit_) - NumContexts - 2,
-            current_frame_resource_->batch_submit_ + NumContexts + 2
+            ArrayCount(current_frame_resource_->batch_submit_) - ShadowCmdlistCount - 2,
+            current_frame_resource_->batch_submit_ + ShadowCmdlistCount + 2
         );
+        frame_timings_.Mark(PhaseSubmit);
 #endif
         cpu_timer_.Tick(NULL);
         if (TitlebarThrottle == title_count_) {
-            WCHAR str[64];
-            swprintf_s(str, L"%.4f CPU", cpu_time_ / title_count_);
+            // -- triangles per frame after culling and LOD selection,
+            // -- and their share of the full detail scene (per light)
+            double const frames = title_count_;
+            double const submitted =
+                100.0 / (std::max<UINT64>(total_triangles_, 1) * frames);
+            WCHAR str[128];
+            swprintf_s(
+                str,
+                L"%.4f CPU, stall %.2f, tris scene %.0fk (%.1f%%) shadow %.0fk (%.1f%%), cb %.1f KB",
+                cpu_time_ / title_count_,
+                title_stall_time_ / frames,
+                title_scene_triangles_ / frames / 1000.0,
+                title_scene_triangles_ * submitted,
+                title_shadow_triangles_ / frames / 1000.0,
+                title_shadow_triangles_ * submitted / NumLights,
+                title_cbuffer_bytes_ / frames / 1024.0
+            );
             SetCustomWindowText(str, Win32App::GetHwnd());
+
+            double present_ms = 0.0, display_ms = 0.0;
+            if (present_latency_.Average(&present_ms, &display_ms)) {
+                char message[160], display[32];
+                if (display_ms >= 0.0)
+                    sprintf_s(display, "%.2f ms", display_ms);
+                else
+                    sprintf_s(display, "n/a");
+                sprintf_s(
+                    message,
+                    "latency: %s, %u in flight, input to present %.2f ms, to display %s\n",
+                    low_latency_ ? "low" : "throughput", frames_in_flight_,
+                    present_ms, display
+                );
+                OutputDebugStringA(message);
+            }
+            {
+                // -- depth texels written by the shadow passes, each light
+                // -- drawn clears and rasterizes at most its whole tile
+                double const lights_drawn = shadow_cache_.TakeDrawnAverage();
+                double const texels =
+                    lights_drawn * shadow_atlas_.TileWidth() * shadow_atlas_.TileHeight();
+                // -- and how often a frame got an atlas still in flight
+                ShadowMapStats const maps = shadow_maps_.Stats();
+                char message[256];
+                sprintf_s(
+                    message,
+                    "shadows: %ux%u preset, %s, %.2f of %u lights drawn per frame, "
+                    "fill %.2f Mtexels per frame, %.1f Mtexels/s, %u maps, shared %.1f%%\n",
+                    shadow_atlas_.TileWidth(), shadow_atlas_.TileHeight(),
+                    shadow_cache_.Enabled() ? "cached" : "uncached",
+                    lights_drawn, NumLights,
+                    texels / 1e6, texels * timer_.GetFramesPerSecond() / 1e6,
+                    maps.count, maps.shared * 100.0 / std::max<UINT64>(maps.acquires, 1)
+                );
+                OutputDebugStringA(message);
+            }
+            char timings[384];
+            if (frame_timings_.Report(timings, sizeof(timings)))
+                OutputDebugStringA(timings);
+            // -- pool hit rates since start, and how many allocators it took
+            CommandPoolStats const pool = command_pool_.Stats(D3D12_COMMAND_LIST_TYPE_DIRECT);
+            if (pool.acquires > 0) {
+                char message[192];
+                sprintf_s(
+                    message,
+                    "cmd pool: %llu acquires, allocator hits %.1f%%, list hits %.1f%%, "
+                    "%u allocators, %u lists, in flight %u (peak %u)\n",
+                    pool.acquires,
+                    pool.allocator_hits * 100.0 / pool.acquires,
+                    pool.list_hits * 100.0 / pool.acquires,
+                    pool.allocators, pool.lists,
+                    pool.in_flight, pool.in_flight_high_water
+                );
+                OutputDebugStringA(message);
+            }
             title_count_ = 0;
             cpu_time_ = 0;
+            title_stall_time_ = 0;
+            title_scene_triangles_ = 0;
+            title_shadow_triangles_ = 0;
+            title_cbuffer_bytes_ = 0;
         } else {
             ++title_count_;
             cpu_time_ += cpu_timer_.GetElapsedSeconds() * 1000;
+            title_stall_time_ += stall_time_;
             cpu_timer_.ResetElaspedTime();
+            title_cbuffer_bytes_ += cbuffer_bytes_;
+            for (int i = 0; i < NumContexts; ++i) {
+                title_scene_triangles_ += scene_triangles_[i];
+                title_shadow_triangles_ += shadow_triangles_[i];
+            }
         }
 
         // -- present and update frame index
         PIXBeginEvent(cmdqueue_.Get(), 0, L"Presenting to screen");
-        ThrowIfFailed(swapchain_->Present(1, 0));
+        ThrowIfFailed(swapchain_->Present(vsync_ ? 1 : 0, 0));
         PIXEndEvent(cmdqueue_.Get());
+        present_latency_.Presented(swapchain_.Get());
+        frame_timings_.Mark(PhasePresent);
         frame_index_ = swapchain_->GetCurrentBackBufferIndex();
 
         // -- signal and increment fence value
         current_frame_resource_->fence_value_ = fence_value_;
         ThrowIfFailed(cmdqueue_->Signal(fence_.Get(), fence_value_));
+        fence_waiter_.Track(current_frame_resource_index_, FenceGraphics, fence_value_);
+        current_frame_resource_->Retire(&command_pool_, &shadow_maps_, fence_value_);
         ++fence_value_;
+        frame_timings_.Mark(PhaseSubmit);
+        frame_timings_.EndFrame();
     } catch (HrException & e) {
         if (
             e.Error() == DXGI_ERROR_DEVICE_REMOVED ||
@@ -1184,7 +2088,13 @@ void OdxMultithreading::OnDestroy () {
             WaitForSingleObject(fence_event_, INFINITE);
         }
         CloseHandle(fence_event_);
+        if (nullptr != frame_latency_waitable_)
+            CloseHandle(frame_latency_waitable_);
+        frame_latency_waitable_ = nullptr;
     }
+    // -- and that the copy queue is done too (streaming may still be going)
+    upload_service_.Release();
+    fence_waiter_.Release();
 
     // -- close thread events and thread handles
     for (int i = 0; i < NumContexts; ++i) {
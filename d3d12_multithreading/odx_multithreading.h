@@ -4,6 +4,23 @@
 #include "camera.h"
 #include "timer.h"
 #include "squid_room.h"
+#include "asset_pack.h"
+#include "mapped_file.h"
+#include "meshlets.h"
+#include "heap_pool.h"
+#include "upload_service.h"
+#include "upload_tracker.h"
+#include "task_pool.h"
+#include "frame_constants.h"
+#include "constant_blocks.h"
+#include "present_latency.h"
+#include "fence_waiter.h"
+#include "command_pool.h"
+#include "frame_timings.h"
+#include "shadow_atlas.h"
+#include "shadow_maps.h"
+#include "shadow_cache.h"
+#include "gpu_timer.h"
 
 using namespace DirectX;
 
@@ -11,25 +28,22 @@ using Microsoft::WRL::ComPtr;
 
 struct FrameResource;
 
+// -- fences the fence waiter watches
+enum WaitFence {
+    FenceGraphics = 0,
+    FenceUpload,
+    WaitFenceCount
+};
+
 struct LightState {
     XMFLOAT4 position;
     XMFLOAT4 direction;
     XMFLOAT4 color;
     XMFLOAT4 falloff;
-
-    XMFLOAT4X4 view;
-    XMFLOAT4X4 projection;
 };
 
-struct SceneCBuffer {
-    XMFLOAT4X4 model;
-    XMFLOAT4X4 view;
-    XMFLOAT4X4 projection;
-    XMFLOAT4 ambient_color;
-    BOOL sample_smap;       // -- shadow map
-    BOOL padding[3];        // -- align to be float4s
-    LightState lights[NumLights];
-};
+// -- model matrix of the whole scene (scales the world down a bit)
+static constexpr float SceneScale = 0.1f;
 
 struct OdxMultithreading : public OdxSample {
 private:
@@ -46,7 +60,7 @@ private:
     CD3DX12_RECT scissor_rect_;
     ComPtr<IDXGISwapChain3> swapchain_;
     ComPtr<ID3D12Device> device_;
-    ComPtr<ID3D12Resource> render_targets_[FrameCount];
+    ComPtr<ID3D12Resource> render_targets_[BackBufferCount];
     ComPtr<ID3D12Resource> depth_stencil_;
     ComPtr<ID3D12CommandAllocator> cmdalloc_;
     ComPtr<ID3D12CommandQueue> cmdqueue_;
@@ -58,15 +72,44 @@ private:
     ComPtr<ID3D12PipelineState> pso_;
     ComPtr<ID3D12PipelineState> pso_smap_;
 
+    // -- heaps the app resources are placed in
+    // NOTE(omid): declared before the resources so they are destroyed after
+    HeapPool buffer_heaps_;
+    HeapPool texture_heaps_;
+    // -- copies to those resources run on their own queue,
+    // -- the tracker knows which copy batch each resource waits on
+    UploadService upload_service_;
+    UploadTracker upload_tracker_;
+    // -- cpu jobs while loading
+    TaskPool task_pool_;
+    // -- cmd allocators and lists, frames acquire what they record
+    CommandPool command_pool_;
+    // -- every light's shadow map is a tile of the atlas,
+    // -- atlases are shared by the frames in flight
+    ShadowAtlas shadow_atlas_;
+    ShadowMaps shadow_maps_;
+    // -- lights whose tile is drawn this frame (mask, set before the
+    // -- workers run), the rest sample their cached tile with the
+    // -- matrices it was drawn with
+    ShadowCache shadow_cache_;
+    UINT shadow_lights_;
+    XMFLOAT4X4 shadow_views_[NumLights];
+    XMFLOAT4X4 shadow_projections_[NumLights];
+    // -- gpu time of the shadow lists, one slot per frame resource
+    GpuTimer shadow_timer_;
+
     // -- app resources
     D3D12_VERTEX_BUFFER_VIEW vb_view_;
+    D3D12_VERTEX_BUFFER_VIEW position_vb_view_;
     D3D12_INDEX_BUFFER_VIEW ib_view_;
-    ComPtr<ID3D12Resource> textures_[ArrayCount(SampleAssets::Textures)];
-    ComPtr<ID3D12Resource> texture_uploads_[ArrayCount(SampleAssets::Textures)];
+    D3D12_INDEX_BUFFER_VIEW ib16_view_;
+    std::vector<ComPtr<ID3D12Resource>> textures_;
     ComPtr<ID3D12Resource> ib_;
-    ComPtr<ID3D12Resource> ib_upload_;
     ComPtr<ID3D12Resource> vb_;
-    ComPtr<ID3D12Resource> vb_upload_;
+    ComPtr<ID3D12Resource> position_vb_;
+    std::vector<PackDraw> draws_;
+    std::vector<PackMeshlet> meshlets_;
+    std::vector<PackLod> lods_;
     UINT rtv_descriptor_size_;
     InputState keyboard_input_;
     LightState lights_[NumLights];
@@ -77,6 +120,32 @@ private:
     int title_count_;
     double cpu_time_;
 
+    // -- meshlet culling, frustums are written in OnUpdate before workers run
+    CullFrustum scene_frustum_;
+    CullFrustum shadow_frustums_[NumLights];
+    std::vector<DrawRange> cull_runs_[NumContexts];
+    // -- current LOD of each draw per pass (kept for hysteresis),
+    // -- a draw is only ever touched by the one worker that owns it
+    std::vector<UINT8> scene_lods_;
+    std::vector<UINT8> shadow_lods_;        // -- per light, then per draw
+    UINT64 scene_triangles_[NumContexts];   // -- submitted this frame
+    UINT64 shadow_triangles_[NumContexts];  // -- all lights
+    UINT64 total_triangles_;                // -- per pass, without culling
+    UINT64 title_scene_triangles_;
+    UINT64 title_shadow_triangles_;
+    // -- every draw's model matrix for now (the pack has no transforms)
+    XMFLOAT4X4 draw_model_;
+    // -- address of each draw's constants this frame, written in the shadow
+    // -- pass and reused in the scene pass by the worker owning the draw
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> draw_constants_;
+
+    // -- constant blocks and which ones to rebuild (1 << ConstantBlock)
+    ConstantBlocks cbuffers_;
+    UINT dirty_cbuffers_;
+    // -- constant bytes written this frame and over the title interval
+    UINT64 cbuffer_bytes_;
+    UINT64 title_cbuffer_bytes_;
+
     // -- synchronization objects
     HANDLE worker_begin_render_frame_[NumContexts];
     HANDLE worker_finish_shadow_pass_[NumContexts];
@@ -86,12 +155,22 @@ private:
     HANDLE fence_event_;
     ComPtr<ID3D12Fence> fence_;
     UINT64 fence_value_;
+    // -- retires frame resources (items are their indices) and upload
+    // -- batches from its own thread, declared after the fences it holds
+    FenceWaiter fence_waiter_;
+    double stall_time_;         // -- ms blocked on the frame's fence this frame
+    double title_stall_time_;
+    // -- main thread phases and worker setup, logged at the title interval
+    FrameTimings frame_timings_;
+    // -- low latency mode, signaled when the swapchain takes a new frame
+    HANDLE frame_latency_waitable_;
+    PresentLatency present_latency_;
 
     // -- singleton object so that worker threads can share data members
     static OdxMultithreading * s_app;
 
-    // -- frame resources
-    FrameResource * frame_resources_[FrameCount];
+    // -- frame resources, only the first frames_in_flight_ are used
+    FrameResource * frame_resources_[MaxFramesInFlight];
     FrameResource * current_frame_resource_;
     int current_frame_resource_index_;
 
@@ -100,11 +179,48 @@ private:
     };
     ThreadParameter thread_parameters_[NumContexts];
 
-    void WorkerThread (int thread_index);
-    void SetCommonPipelineState (ID3D12GraphicsCommandList * cmdlist);
+    // -- asset pack, only alive while loading
+    // -- (views alias either the mapped file or the freshly cooked pack)
+    PackView assets_;
+    MappedFile asset_file_;
+    std::vector<UINT8> cooked_pack_;
 
+    void WorkerThread (int thread_index);
+    void SetCommonPipelineState (
+        ID3D12GraphicsCommandList * cmdlist,
+        BOOL scene_pass
+    );
+    void SetIndexBuffer (
+        ID3D12GraphicsCommandList * cmdlist,
+        PackDraw const & draw,
+        UINT * bound_format
+    );
+    D3D12_GPU_VIRTUAL_ADDRESS WriteDrawConstants (
+        PackDraw const & draw,
+        ConstantCursor * cursor
+    );
+    void UpdateConstants ();
+    UINT DrawCulled (
+        ID3D12GraphicsCommandList * cmdlist,
+        PackDraw const & draw,
+        UINT lod,
+        CullFrustum const & frustum,
+        int thread_index
+    );
+    void UpdateCullFrustum (
+        Camera * camera,
+        float width, float height,
+        CullFrustum * frustum
+    );
+
+    bool LoadAssetPack ();
+    void FreeAssetPack ();
     void LoadPipeLine ();
     void LoadAssets ();
+    void LoadTextures (
+        D3D12_CPU_DESCRIPTOR_HANDLE first_srv,
+        UINT descriptor_size
+    );
     void RestoreD3DResources ();
     void ReleaseD3DResources ();
     void WaitForGpu ();
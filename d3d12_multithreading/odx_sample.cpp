@@ -5,7 +5,11 @@ using namespace Microsoft::WRL;
 
 OdxSample::OdxSample (
     UINT width, UINT height, std::wstring name
-) : width_(width), height_(height), title_(name), use_warp_(false) {
+) : width_(width), height_(height), title_(name), use_warp_(false),
+    load_threads_(0), frames_in_flight_(DefaultFramesInFlight),
+    low_latency_(false), vsync_(true),
+    shadow_resolution_(DefaultShadowResolution), shadow_map_count_(0),
+    shadow_alias_(false), cache_shadows_(false), shadow_budget_(0) {
     WCHAR assetpath[512];
     GetAssetsPath(assetpath, _countof(assetpath));
     asset_path_ = assetpath;
@@ -92,6 +96,74 @@ void OdxSample::ParseCommandLineArgs (
         ) {
             use_warp_ = true;
             title_ = title_ + L" (WARP)";
+        } else if (
+            (
+                _wcsicmp(argv[i], L"-load_threads") == 0 ||
+                _wcsicmp(argv[i], L"/load_threads") == 0
+            ) && i + 1 < argc
+        ) {
+            load_threads_ = static_cast<UINT>(_wtoi(argv[++i]));
+        } else if (
+            (
+                _wcsicmp(argv[i], L"-frames_in_flight") == 0 ||
+                _wcsicmp(argv[i], L"/frames_in_flight") == 0
+            ) && i + 1 < argc
+        ) {
+            int const frames = _wtoi(argv[++i]);
+            frames_in_flight_ = static_cast<UINT>(
+                std::max(1, std::min(frames, static_cast<int>(MaxFramesInFlight)))
+            );
+        } else if (
+            _wcsicmp(argv[i], L"-low_latency") == 0 ||
+            _wcsicmp(argv[i], L"/low_latency") == 0
+        ) {
+            // -- otherwise throughput: queue up to frames_in_flight_ frames
+            low_latency_ = true;
+            title_ = title_ + L" (low latency)";
+        } else if (
+            _wcsicmp(argv[i], L"-no_vsync") == 0 ||
+            _wcsicmp(argv[i], L"/no_vsync") == 0
+        ) {
+            vsync_ = false;
+        } else if (
+            (
+                _wcsicmp(argv[i], L"-shadow_res") == 0 ||
+                _wcsicmp(argv[i], L"/shadow_res") == 0
+            ) && i + 1 < argc
+        ) {
+            // -- largest preset not above the request (at least the smallest)
+            int const requested = _wtoi(argv[++i]);
+            shadow_resolution_ = ShadowResolutions[0];
+            for (UINT resolution : ShadowResolutions)
+                if (static_cast<int>(resolution) <= requested)
+                    shadow_resolution_ = resolution;
+        } else if (
+            (
+                _wcsicmp(argv[i], L"-shadow_maps") == 0 ||
+                _wcsicmp(argv[i], L"/shadow_maps") == 0
+            ) && i + 1 < argc
+        ) {
+            // -- clamped to frames_in_flight_ once both are known
+            int const count = _wtoi(argv[++i]);
+            shadow_map_count_ = count > 0 ? static_cast<UINT>(count) : 0;
+        } else if (
+            _wcsicmp(argv[i], L"-shadow_alias") == 0 ||
+            _wcsicmp(argv[i], L"/shadow_alias") == 0
+        ) {
+            shadow_alias_ = true;
+        } else if (
+            _wcsicmp(argv[i], L"-shadow_cache") == 0 ||
+            _wcsicmp(argv[i], L"/shadow_cache") == 0
+        ) {
+            cache_shadows_ = true;
+        } else if (
+            (
+                _wcsicmp(argv[i], L"-shadow_budget") == 0 ||
+                _wcsicmp(argv[i], L"/shadow_budget") == 0
+            ) && i + 1 < argc
+        ) {
+            int const budget = _wtoi(argv[++i]);
+            shadow_budget_ = budget > 0 ? static_cast<UINT>(budget) : 0;
         }
     }
 }
@@ -12,6 +12,15 @@ protected:
     UINT height_;
     float aspect_ratio_;
     bool use_warp_;
+    UINT load_threads_;         // -- cpu threads for loading, 0 is one per core
+    UINT frames_in_flight_;     // -- frame resources, 1 to MaxFramesInFlight
+    bool low_latency_;          // -- wait on the swapchain before reading input
+    bool vsync_;
+    UINT shadow_resolution_;    // -- one of ShadowResolutions
+    UINT shadow_map_count_;     // -- 0 for the minimum, at most frames_in_flight_
+    bool shadow_alias_;         // -- shadow maps share one heap slot
+    bool cache_shadows_;        // -- redraw a light's shadows only once it moved
+    UINT shadow_budget_;        // -- cached lights redrawn per frame, 0 for all
     std::wstring GetAssetFullPath (LPCWSTR assetname);
     void GetHardwareAdapter (
         _In_ IDXGIFactory1 * factory,
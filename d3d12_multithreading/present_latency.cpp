@@ -0,0 +1,56 @@
+#include "stdafx.h"
+#include "present_latency.h"
+
+PresentLatency::PresentLatency () :
+    pending_(), next_pending_(0), last_displayed_(0), input_time_(0),
+    present_ticks_(0), presents_(0), display_ticks_(0), displays_(0)
+{
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    frequency_ = frequency.QuadPart;
+}
+void PresentLatency::InputSampled () {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    input_time_ = now.QuadPart;
+}
+void PresentLatency::Presented (IDXGISwapChain * swapchain) {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    present_ticks_ += now.QuadPart - input_time_;
+    ++presents_;
+
+    UINT present_count = 0;
+    if (SUCCEEDED(swapchain->GetLastPresentCount(&present_count))) {
+        pending_[next_pending_ % PendingCount] = {present_count, input_time_};
+        ++next_pending_;
+    }
+    // -- the latest present that made it to the screen, and when
+    DXGI_FRAME_STATISTICS stats = {};
+    if (
+        FAILED(swapchain->GetFrameStatistics(&stats)) ||
+        stats.PresentCount == last_displayed_
+    ) {
+        return;
+    }
+    last_displayed_ = stats.PresentCount;
+    for (Pending const & pending : pending_) {
+        if (pending.present_count == stats.PresentCount && 0 != pending.input_time) {
+            display_ticks_ += stats.SyncQPCTime.QuadPart - pending.input_time;
+            ++displays_;
+            break;
+        }
+    }
+}
+bool PresentLatency::Average (double * present_ms, double * display_ms) {
+    if (0 == presents_)
+        return false;
+    *present_ms = present_ticks_ * 1000.0 / frequency_ / presents_;
+    *display_ms = displays_ > 0 ?
+        display_ticks_ * 1000.0 / frequency_ / displays_ : -1.0;
+    present_ticks_ = 0;
+    presents_ = 0;
+    display_ticks_ = 0;
+    displays_ = 0;
+    return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// NOTE(omid): Input-to-present and input-to-display latency
+/*
+    InputSampled() stamps the moment a frame reads its input, Presented()
+    is called right after that frame's Present: the time in between is
+    the cpu side of the latency. The present count of the frame is kept
+    with its input stamp, and once DXGI reports (frame statistics) the
+    vblank at which that present count reached the screen, the time from
+    input to display is known too. Windowed swapchains may not report
+    statistics, then only the first is measured.
+*/
+
+struct PresentLatency {
+private:
+    struct Pending {
+        UINT present_count;
+        LONGLONG input_time;
+    };
+    static constexpr UINT PendingCount = 16;   // -- presents awaiting display
+
+    Pending pending_[PendingCount];
+    UINT next_pending_;
+    UINT last_displayed_;
+    LONGLONG frequency_;
+    LONGLONG input_time_;
+
+    LONGLONG present_ticks_;
+    UINT presents_;
+    LONGLONG display_ticks_;
+    UINT displays_;
+public:
+    PresentLatency ();
+
+    void InputSampled ();
+    void Presented (IDXGISwapChain * swapchain);
+
+    //
+    // -- averages in ms since the last call, display_ms < 0 if unknown
+    // -- (false if nothing was presented)
+    bool Average (double * present_ms, double * display_ms);
+};
@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "ring_allocator.h"
+
+RingAllocator::RingAllocator () :
+    size_(0), head_(0), tail_(0)
+{
+}
+void RingAllocator::Init (UINT64 size) {
+    size_ = size;
+    head_ = 0;
+    tail_ = 0;
+    markers_.clear();
+}
+bool RingAllocator::Allocate (UINT64 size, UINT64 alignment, UINT64 * offset) {
+    assert(alignment > 0 && 0 == (alignment & (alignment - 1)));
+    if (0 == size || size > size_)
+        return false;
+    if (head_ == tail_) {
+        // -- empty, restart at offset 0 instead of wrapping around later
+        head_ += (size_ - head_ % size_) % size_;
+        tail_ = head_;
+    }
+    UINT64 const position = head_ % size_;
+    UINT64 start = (position + alignment - 1) & ~(alignment - 1);
+    UINT64 padding = start - position;
+    if (start + size > size_) {
+        // -- wrap, the bytes up to the end are wasted
+        start = 0;
+        padding = size_ - position;
+    }
+    UINT64 const needed = padding + size;
+    if (head_ - tail_ + needed > size_)
+        return false;
+    head_ += needed;
+    *offset = start;
+    return true;
+}
+void RingAllocator::Commit (UINT64 fence_value) {
+    if (0 == PendingSize())
+        return;
+    assert(markers_.empty() || markers_.back().fence_value <= fence_value);
+    markers_.push_back({fence_value, head_});
+}
+void RingAllocator::Retire (UINT64 completed_fence) {
+    while (!markers_.empty() && markers_.front().fence_value <= completed_fence) {
+        tail_ = markers_.front().end;
+        markers_.pop_front();
+    }
+}
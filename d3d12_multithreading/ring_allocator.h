@@ -0,0 +1,48 @@
+#pragma once
+
+#include <deque>
+
+// NOTE(omid): Fence-tracked ring over an abstract range
+/*
+    Allocations are carved linearly from the head and handed back in bulk
+    from the tail: Commit(fence) closes everything allocated so far under
+    that fence value and Retire(completed) frees all the regions whose
+    fence has passed. An allocation that does not fit before the end of
+    the range wraps around to offset 0 (the skipped bytes retire with it).
+
+    Head and tail are running totals, not offsets, so a full ring and an
+    empty one never look the same.
+*/
+
+struct RingAllocator {
+private:
+    struct Marker {
+        UINT64 fence_value;
+        UINT64 end;     // -- head when the marker was committed
+    };
+    UINT64 size_;
+    UINT64 head_;
+    UINT64 tail_;
+    std::deque<Marker> markers_;
+public:
+    RingAllocator ();
+
+    void Init (UINT64 size);
+
+    // -- false if the ring has no room until more fences complete
+    // -- (alignment must be a power of two)
+    bool Allocate (UINT64 size, UINT64 alignment, UINT64 * offset);
+    void Commit (UINT64 fence_value);
+    void Retire (UINT64 completed_fence);
+
+    UINT64 Size () const { return size_; }
+    UINT64 UsedSize () const { return head_ - tail_; }
+    // -- bytes allocated since the last Commit
+    UINT64 PendingSize () const {
+        return head_ - (markers_.empty() ? tail_ : markers_.back().end);
+    }
+    // -- fence the oldest in-flight region waits on, 0 if none
+    UINT64 OldestFence () const {
+        return markers_.empty() ? 0 : markers_.front().fence_value;
+    }
+};
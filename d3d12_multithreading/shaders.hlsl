@@ -8,21 +8,37 @@ SamplerState sample_clamp : register(s1);
 #define NUM_LIGHTS 3
 #define SHADOW_DEPTH_BIAS 0.00005f
 
-struct LightState {
+// -- constants by update frequency (keep in sync with c++ side)
+struct FrameLight {
     float3 position;
     float3 direction;
-    float4 color;
-    float4 falloff;
     float4x4 view;
     float4x4 projection;
 };
-cbuffer SceneConstantBuffer : register(b0){
-    float4x4 model;
+// -- per pass: point of view (the scene's or one light's)
+cbuffer PassConstantBuffer : register(b0) {
     float4x4 view;
     float4x4 projection;
-    float4 ambient_color;
     bool sample_smap;
-    LightState lights[NUM_LIGHTS];
+};
+// -- per-draw constants
+cbuffer DrawConstantBuffer : register(b1) {
+    float4x4 model;
+    float3 position_offset;
+    float3 position_scale;
+};
+// -- per frame: lights that move
+cbuffer FrameConstantBuffer : register(b2) {
+    FrameLight lights[NUM_LIGHTS];
+};
+// -- static: set at load
+cbuffer StaticConstantBuffer : register(b3) {
+    float4 ambient_color;
+    float4 light_colors[NUM_LIGHTS];
+    float4 light_falloffs[NUM_LIGHTS];
+    float4 shadow_tiles[NUM_LIGHTS];    // -- uv scale (xy) and offset (zw) in the atlas
+    float4 smap_dims;                   // -- atlas size (xy) and its inverse (zw)
+    uint shadow_light_count;
 };
 struct PSInput {
     float4 position : SV_POSITION;
@@ -89,18 +105,26 @@ float4 CalcUnshadowedAmountPCF2x2(int light_index, float4 posworld) {
     float2 shadow_tex_coord = 0.5f * lightspace_pos.xy + 0.5f;
     shadow_tex_coord.y = 1.0f - shadow_tex_coord.y;
     
+    // -- into the light's atlas tile, kept a texel inside its edges
+    // -- so the 2x2 footprint never reads a neighbor tile
+    float4 tile = shadow_tiles[light_index];
+    float2 texel_units = smap_dims.zw;
+    shadow_tex_coord = clamp(
+        saturate(shadow_tex_coord) * tile.xy + tile.zw,
+        tile.zw + 0.5f * texel_units,
+        tile.zw + tile.xy - 1.5f * texel_units
+    );
+    
     // -- depth bias to avoid pixel self-shadowing
     float lightspace_depth = lightspace_pos.z - SHADOW_DEPTH_BIAS;
     
     // -- find sub-pixel weights
-    float2 smap_dims = float2(1280.0f, 720.0f); // needs to be kept in sync with c++ side
     float4 subpixel_coords = float4(1.0f, 1.0f, 1.0f, 1.0f);
-    subpixel_coords.xy = frac(smap_dims * shadow_tex_coord);
+    subpixel_coords.xy = frac(smap_dims.xy * shadow_tex_coord);
     subpixel_coords.zw = 1.0f - subpixel_coords.xy;
     float4 bilinear_weights = subpixel_coords.zxzx * subpixel_coords.wwyy;
     
     // -- 2x2 percentage closer filtering
-    float2 texel_units = 1.0f / smap_dims;
     float4 shadow_depths;
     shadow_depths.x = smap.Sample(sample_clamp, shadow_tex_coord);
     shadow_depths.y = smap.Sample(sample_clamp, shadow_tex_coord + float2(texel_units.x, 0.0f));
@@ -111,13 +135,32 @@ float4 CalcUnshadowedAmountPCF2x2(int light_index, float4 posworld) {
     float4 shadow_tests = (shadow_depths >= lightspace_depth) ? 1.0f : 0.0f;
     return dot(bilinear_weights, shadow_tests);
 }
+#ifdef COMPRESSED_VERTICES
+//
+// -- octahedral decode (keep in sync with OctDecode on c++ side)
+float3 OctDecode(float2 e) {
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += n.xy >= 0.0f ? -t : t;
+    return normalize(n);
+}
+PSInput VSMain(
+    float4 qpos : POSITION, float2 oct_normal : NORMAL,
+    float2 uv : TEXCOORD0, float2 oct_tangent : TANGENT
+) {
+    float3 pos = qpos.xyz;
+    float3 normal = OctDecode(oct_normal);
+    float3 tangent = OctDecode(oct_tangent);
+#else
 PSInput VSMain(
     float3 pos : POSITION, float3 normal : NORMAL,
     float2 uv : TEXCOORD0, float3 tangent : TANGENT
 ) {
+#endif
     PSInput result;
     
-    float4 newpos = float4(pos, 1.0f);
+    // -- dequantize (identity for uncompressed vertices)
+    float4 newpos = float4(position_offset + pos * position_scale, 1.0f);
     
     normal.z *= -1.0f;
     newpos = mul(newpos, model);
@@ -134,6 +177,20 @@ PSInput VSMain(
     
     return result;
 }
+//
+// -- depth-only vertex shader, fed by the tightly packed position stream
+float4 VSShadow(
+#ifdef COMPRESSED_VERTICES
+    float4 pos : POSITION
+#else
+    float3 pos : POSITION
+#endif
+) : SV_POSITION {
+    float4 newpos = float4(position_offset + pos.xyz * position_scale, 1.0f);
+    newpos = mul(newpos, model);
+    newpos = mul(newpos, view);
+    return mul(newpos, projection);
+}
 float4 PSMain(PSInput input) : SV_TARGET{
     float4 diffuse_color = diffuse_map.Sample(sample_wrap, input.uv);
     float3 pixel_normal = CalcPerPixelNormal(input.uv, input.normal, input.tangent);
@@ -141,10 +198,11 @@ float4 PSMain(PSInput input) : SV_TARGET{
     
     for(int i = 0;i < NUM_LIGHTS;++i) {
         float4 light_pass = CalcLightingColor(
-            lights[i].position, lights[i].direction, lights[i].color,
-            lights[i].falloff, input.worldpos.xyz, pixel_normal
+            lights[i].position, lights[i].direction, light_colors[i],
+            light_falloffs[i], input.worldpos.xyz, pixel_normal
         );
-        if (sample_smap && i == 0)
+        // -- every light casts shadows (a tile each in the atlas)
+        if (sample_smap && i < (int)shadow_light_count)
             light_pass *= CalcUnshadowedAmountPCF2x2(i, input.worldpos);
         total_light += light_pass;
     }
@@ -0,0 +1,54 @@
+#include "stdafx.h"
+#include "shadow_atlas.h"
+
+#include <algorithm>
+
+ShadowAtlas::ShadowAtlas () :
+    tile_width_(0), tile_height_(0), tile_count_(0), columns_(0), rows_(0)
+{
+}
+bool ShadowAtlas::Init (
+    UINT tile_width,
+    UINT tile_height,
+    UINT tile_count,
+    UINT max_dimension
+) {
+    tile_width_ = tile_width;
+    tile_height_ = tile_height;
+    tile_count_ = tile_count;
+    columns_ = 0;
+    rows_ = 0;
+    UINT best_tiles = 0;
+    UINT best_side = 0;
+    for (UINT columns = 1; columns <= tile_count; ++columns) {
+        UINT const rows = (tile_count + columns - 1) / columns;
+        UINT64 const width = UINT64(columns) * tile_width;
+        UINT64 const height = UINT64(rows) * tile_height;
+        if (width > max_dimension || height > max_dimension)
+            continue;
+        UINT const tiles = columns * rows;
+        UINT const side = static_cast<UINT>(std::max(width, height));
+        if (0 == columns_ || tiles < best_tiles || (tiles == best_tiles && side < best_side)) {
+            columns_ = columns;
+            rows_ = rows;
+            best_tiles = tiles;
+            best_side = side;
+        }
+    }
+    return 0 != columns_;
+}
+ShadowTile ShadowAtlas::Tile (UINT index) const {
+    return {
+        (index % columns_) * tile_width_,
+        (index / columns_) * tile_height_,
+        tile_width_,
+        tile_height_
+    };
+}
+void ShadowAtlas::TileTransform (UINT index, float * scale_offset) const {
+    ShadowTile const tile = Tile(index);
+    scale_offset[0] = static_cast<float>(tile.width) / Width();
+    scale_offset[1] = static_cast<float>(tile.height) / Height();
+    scale_offset[2] = static_cast<float>(tile.x) / Width();
+    scale_offset[3] = static_cast<float>(tile.y) / Height();
+}
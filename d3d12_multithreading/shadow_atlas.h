@@ -0,0 +1,41 @@
+#pragma once
+
+// NOTE(omid): Shadow maps of all the lights packed into one texture
+/*
+    Tiles are all the same size and laid out in a grid, the grid shape
+    is the one wasting the fewest tiles that still fits the max texture
+    dimension (squarer wins ties). Each light renders into its own tile
+    (viewport and scissor) and the shader remaps its light-space uvs into
+    the tile with a scale and offset.
+*/
+
+struct ShadowTile {
+    UINT x;
+    UINT y;
+    UINT width;
+    UINT height;
+};
+
+struct ShadowAtlas {
+private:
+    UINT tile_width_;
+    UINT tile_height_;
+    UINT tile_count_;
+    UINT columns_;
+    UINT rows_;
+public:
+    ShadowAtlas ();
+
+    // -- false if even a single column/row does not fit max_dimension
+    bool Init (UINT tile_width, UINT tile_height, UINT tile_count, UINT max_dimension);
+
+    ShadowTile Tile (UINT index) const;
+    // -- uv scale (xy) and offset (zw) from a tile's [0, 1] into the atlas
+    void TileTransform (UINT index, float * scale_offset) const;
+
+    UINT Width () const { return tile_width_ * columns_; }
+    UINT Height () const { return tile_height_ * rows_; }
+    UINT TileWidth () const { return tile_width_; }
+    UINT TileHeight () const { return tile_height_; }
+    UINT TileCount () const { return tile_count_; }
+};
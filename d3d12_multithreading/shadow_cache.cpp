@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "shadow_cache.h"
+
+static constexpr UINT AllLights = (1u << NumLights) - 1;
+
+ShadowCache::ShadowCache () :
+    stale_(AllLights), next_(0), budget_(0), enabled_(false), filled_(false),
+    frames_(0), drawn_(0)
+{
+}
+void ShadowCache::Init (bool enabled, UINT budget) {
+    enabled_ = enabled;
+    budget_ = budget;
+    filled_ = false;
+    stale_ = AllLights;
+    next_ = 0;
+    frames_ = 0;
+    drawn_ = 0;
+}
+UINT ShadowCache::Schedule () {
+    ++frames_;
+    if (!enabled_) {
+        drawn_ += NumLights;
+        return AllLights;
+    }
+    UINT scheduled = 0;
+    UINT count = 0;
+    UINT const start = next_;
+    for (UINT i = 0; i < NumLights; ++i) {
+        UINT const light = (start + i) % NumLights;
+        if (0 == (stale_ & 1u << light))
+            continue;
+        if (filled_ && budget_ > 0 && count == budget_)
+            break;
+        scheduled |= 1u << light;
+        ++count;
+        next_ = (light + 1) % NumLights;
+    }
+    stale_ &= ~scheduled;
+    filled_ = true;
+    drawn_ += count;
+    return scheduled;
+}
+double ShadowCache::TakeDrawnAverage () {
+    double const average = frames_ > 0 ? double(drawn_) / frames_ : 0.0;
+    frames_ = 0;
+    drawn_ = 0;
+    return average;
+}
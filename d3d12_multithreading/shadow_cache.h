@@ -0,0 +1,45 @@
+#pragma once
+
+// NOTE(omid): Which lights redraw their shadow map tile this frame
+/*
+    Without caching every light is drawn every frame. With caching a
+    tile keeps its depth until its light moves (Moved), only stale lights
+    are scheduled, and a still light records no shadow pass at all. The
+    scene samples each tile with the matrices it was drawn with, so a
+    stale tile is late, never wrong.
+
+    A budget spreads a redraw over frames: at most budget stale lights a
+    frame, round robin so none starves. The first frame after Init draws
+    every tile regardless: until then the atlas holds no depth and the
+    lights no matrices, and the scene samples every light. The room only has static casters
+    (one model matrix for the whole pack), a tile is a light's static
+    depth; dynamic casters would be drawn into a copy of it each frame.
+
+    The cached depth must survive between frames: one shadow map shared
+    by every frame in flight (see ShadowMaps), never aliased.
+*/
+
+struct ShadowCache {
+private:
+    UINT stale_;        // -- mask of the lights whose tile is out of date
+    UINT next_;         // -- round robin start
+    UINT budget_;       // -- lights drawn per frame, 0 for no limit
+    bool enabled_;
+    bool filled_;       // -- every tile drawn once since Init
+    UINT64 frames_;
+    UINT64 drawn_;
+public:
+    ShadowCache ();
+
+    // -- every tile starts stale
+    void Init (bool enabled, UINT budget);
+    void Moved (UINT light) { stale_ |= 1u << light; }
+
+    // -- mask of the lights to draw this frame, fresh from then on,
+    // -- the first after Init ignores the budget
+    UINT Schedule ();
+
+    bool Enabled () const { return enabled_; }
+    // -- lights drawn per frame since the last call
+    double TakeDrawnAverage ();
+};
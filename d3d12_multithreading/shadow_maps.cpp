@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "shadow_maps.h"
+#include "odx_helper.h"
+
+ShadowMaps::ShadowMaps () :
+    aliased_(false), last_(0), stats_()
+{
+}
+HRESULT ShadowMaps::Init (
+    ID3D12Device * device,
+    UINT width,
+    UINT height,
+    UINT count,
+    bool aliased,
+    ID3D12DescriptorHeap * dsv_heap,
+    UINT dsv_first,
+    ID3D12DescriptorHeap * cbv_srv_heap,
+    UINT srv_first
+) {
+    Release();
+    aliased_ = aliased && count > 1;
+
+    CD3DX12_RESOURCE_DESC const desc (
+        D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+        0,
+        width, height,
+        1, 1,
+        DXGI_FORMAT_R32_TYPELESS,
+        1, 0,
+        D3D12_TEXTURE_LAYOUT_UNKNOWN,
+        D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL
+    );
+    D3D12_RESOURCE_ALLOCATION_INFO const info =
+        device->GetResourceAllocationInfo(0, 1, &desc);
+    UINT64 const slot_size =
+        (info.SizeInBytes + info.Alignment - 1) & ~(info.Alignment - 1);
+
+    D3D12_HEAP_DESC heap_desc = {};
+    heap_desc.SizeInBytes = slot_size * (aliased_ ? 1 : count);
+    heap_desc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+    heap_desc.Alignment = info.Alignment;
+    heap_desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+    HRESULT hr = device->CreateHeap(&heap_desc, IID_PPV_ARGS(&heap_));
+    if (FAILED(hr))
+        return hr;
+    NAME_D3D12_OBJECT(heap_);
+
+    // NOTE(omid): performance tip: in the runtime,
+    // specify the desired clear value at resource creation time
+    D3D12_CLEAR_VALUE clear_value;
+    clear_value.Format = DXGI_FORMAT_D32_FLOAT;
+    clear_value.DepthStencil.Depth = 1.0f;
+    clear_value.DepthStencil.Stencil = 0;
+
+    D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc = {};
+    dsv_desc.Format = DXGI_FORMAT_D32_FLOAT;
+    dsv_desc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+    dsv_desc.Texture2D.MipSlice = 0;
+    // NOTE(omid): the srv is for sampling the smap in the scene pass,
+    // it uses the same tex the shadow pass renders depth into
+    D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+    srv_desc.Format = DXGI_FORMAT_R32_FLOAT;
+    srv_desc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srv_desc.Texture2D.MipLevels = 1;
+    srv_desc.Shader4ComponentMapping =
+        D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+    UINT const dsv_size =
+        device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    UINT const srv_size =
+        device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    maps_.resize(count);
+    for (UINT i = 0; i < count; ++i) {
+        Map & map = maps_[i];
+        hr = device->CreatePlacedResource(
+            heap_.Get(),
+            aliased_ ? 0 : i * slot_size,
+            &desc,
+            D3D12_RESOURCE_STATE_DEPTH_WRITE,
+            &clear_value,
+            IID_PPV_ARGS(&map.resource)
+        );
+        if (FAILED(hr)) {
+            Release();
+            return hr;
+        }
+        SetNameIndexed(map.resource.Get(), L"shadow_map", i);
+
+        CD3DX12_CPU_DESCRIPTOR_HANDLE const dsv (
+            dsv_heap->GetCPUDescriptorHandleForHeapStart(), dsv_first + i, dsv_size
+        );
+        device->CreateDepthStencilView(map.resource.Get(), &dsv_desc, dsv);
+        CD3DX12_CPU_DESCRIPTOR_HANDLE const srv_cpu (
+            cbv_srv_heap->GetCPUDescriptorHandleForHeapStart(), srv_first + i, srv_size
+        );
+        device->CreateShaderResourceView(map.resource.Get(), &srv_desc, srv_cpu);
+        map.dsv = dsv;
+        map.srv = CD3DX12_GPU_DESCRIPTOR_HANDLE(
+            cbv_srv_heap->GetGPUDescriptorHandleForHeapStart(), srv_first + i, srv_size
+        );
+        map.fence_value = 0;
+        map.used = false;
+    }
+    last_ = count;
+    stats_.count = count;
+    stats_.map_bytes = info.SizeInBytes;
+    stats_.heap_bytes = heap_desc.SizeInBytes;
+    return S_OK;
+}
+void ShadowMaps::Release () {
+    maps_.clear();
+    heap_.Reset();
+    last_ = 0;
+    stats_ = ShadowMapStats();
+}
+ShadowMap ShadowMaps::Acquire (UINT64 completed) {
+    // -- least recently used first, fence values only grow
+    UINT index = 0;
+    for (UINT i = 1; i < maps_.size(); ++i)
+        if (maps_[i].fence_value < maps_[index].fence_value)
+            index = i;
+    Map & map = maps_[index];
+    ++stats_.acquires;
+    if (map.fence_value > completed)
+        ++stats_.shared;
+    ShadowMap const result = {
+        map.resource.Get(), map.dsv, map.srv, index,
+        aliased_ && index != last_,
+        !map.used
+    };
+    map.used = true;
+    last_ = index;
+    return result;
+}
+void ShadowMaps::Retire (UINT index, UINT64 fence_value) {
+    maps_[index].fence_value = fence_value;
+}
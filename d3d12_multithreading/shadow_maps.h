@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Shadow atlases shared by the frames in flight
+/*
+    Every frame used to own a whole atlas. All the passes run on the one
+    direct queue though, in submission order, and each frame transitions
+    its atlas write -> read -> write, so a frame's shadow pass cannot
+    start before the previous frame's scene pass is done sampling: one
+    atlas is enough however many frames are in flight (MinCount). More
+    can be kept to compare, or for when a pass moves to another queue.
+
+    Acquire hands out the map with the oldest fence value (least recently
+    used), Retire ages it with the fence value its frame was submitted
+    under. A map handed out while still in flight is counted as shared.
+
+    All maps are placed in one heap. Aliased, they all start at offset 0
+    (the heap holds a single map): switching maps then needs an aliasing
+    barrier, and the full clear every frame initializes the new one.
+
+    A placed depth map's first use must be a full clear (or discard): a
+    map reports its first use since Init, with a shadow cache too where
+    only the redrawn tiles are cleared after that.
+*/
+
+struct ShadowMap {
+    ID3D12Resource * resource;
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv;
+    D3D12_GPU_DESCRIPTOR_HANDLE srv;
+    UINT index;
+    bool alias_barrier;     // -- aliased and not the map used last
+    bool first_use;         // -- not acquired since Init, needs a full clear
+};
+
+struct ShadowMapStats {
+    UINT count;
+    UINT64 map_bytes;
+    UINT64 heap_bytes;
+    UINT64 acquires;
+    UINT64 shared;          // -- acquired while its last frame was in flight
+};
+
+struct ShadowMaps {
+private:
+    struct Map {
+        ComPtr<ID3D12Resource> resource;
+        D3D12_CPU_DESCRIPTOR_HANDLE dsv;
+        D3D12_GPU_DESCRIPTOR_HANDLE srv;
+        UINT64 fence_value;     // -- last submission using it, 0 if none
+        bool used;              // -- acquired since Init
+    };
+    ComPtr<ID3D12Heap> heap_;
+    std::vector<Map> maps_;
+    bool aliased_;
+    UINT last_;                 // -- map acquired last, maps_.size() if none
+    ShadowMapStats stats_;
+public:
+    ShadowMaps ();
+
+    static UINT MinCount () { return 1; }
+
+    //
+    // -- count maps (R32, width x height, in DEPTH_WRITE) with their dsvs at
+    // -- dsv_first and srvs at srv_first on, one heap slot each unless aliased
+    HRESULT Init (
+        ID3D12Device * device,
+        UINT width,
+        UINT height,
+        UINT count,
+        bool aliased,
+        ID3D12DescriptorHeap * dsv_heap,
+        UINT dsv_first,
+        ID3D12DescriptorHeap * cbv_srv_heap,
+        UINT srv_first
+    );
+    // -- the gpu must be done with every map
+    void Release ();
+
+    ShadowMap Acquire (UINT64 completed);
+    void Retire (UINT index, UINT64 fence_value);
+
+    ShadowMapStats Stats () const { return stats_; }
+};
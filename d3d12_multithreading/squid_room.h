@@ -20,6 +20,7 @@
 
 namespace SampleAssets {
 wchar_t const DataFilename [] = L"SquidRoom.bin";
+wchar_t const PackFilename [] = L"SquidRoom.odxp";   // -- cooked from DataFilename
 
 D3D12_INPUT_ELEMENT_DESC const StandardVertexDescription [] = {
     {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
@@ -4,6 +4,11 @@
 #define WIN32_LEAN_AND_MEAN
 #endif // !WIN32_LEAN_AND_MEAN
 
+// -- keep windows.h from defining min/max macros (we use std::min/max)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // !NOMINMAX
+
 #include <windows.h>
 
 #include <d3d12.h>
@@ -23,10 +28,18 @@
 
 #define SINGLETHREADED  FALSE
 
-static constexpr UINT FrameCount = 3;
+// -- swapchain buffers, frames in flight are set separately (at startup)
+static constexpr UINT BackBufferCount = 3;
+static constexpr UINT MaxFramesInFlight = 4;
+static constexpr UINT DefaultFramesInFlight = 3;
 
 static constexpr UINT NumContexts = 3;
 static constexpr UINT NumLights = 3;    // -- update shader code if changed
+// -- each light's shadow pass is recorded by every context, into its own list
+static constexpr UINT ShadowCmdlistCount = NumLights * NumContexts;
+// -- shadow map resolution (per light, square) presets, picked at startup
+static constexpr UINT ShadowResolutions [] = {512, 1024, 2048, 4096};
+static constexpr UINT DefaultShadowResolution = 1024;
 
 // -- number of frames to not update the titlebar
 static constexpr UINT TitlebarThrottle = 200; 
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "task_pool.h"
+
+#include <algorithm>
+
+TaskPool::TaskPool () :
+    job_(nullptr), job_count_(0), next_job_(0), finished_jobs_(0),
+    active_workers_(0), generation_(0), quit_(false)
+{
+}
+TaskPool::~TaskPool () {
+    Release();
+}
+void TaskPool::Init (UINT thread_count) {
+    Release();
+    if (0 == thread_count)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    quit_ = false;
+    for (UINT i = 1; i < thread_count; ++i)
+        threads_.emplace_back(&TaskPool::WorkerLoop, this);
+}
+void TaskPool::Release () {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    work_ready_.notify_all();
+    for (std::thread & thread : threads_)
+        thread.join();
+    threads_.clear();
+}
+void TaskPool::RunJobs () {
+    for (;;) {
+        UINT const job = next_job_.fetch_add(1);
+        if (job >= job_count_)
+            return;
+        (*job_)(job);
+        if (finished_jobs_.fetch_add(1) + 1 == job_count_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            work_done_.notify_all();
+        }
+    }
+}
+void TaskPool::WorkerLoop () {
+    UINT64 seen_generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [&] {
+                return quit_ || generation_ != seen_generation;
+            });
+            if (quit_)
+                return;
+            seen_generation = generation_;
+            ++active_workers_;
+        }
+        RunJobs();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --active_workers_;
+        }
+        work_done_.notify_all();
+    }
+}
+void TaskPool::ParallelFor (UINT job_count, std::function<void (UINT)> const & job) {
+    if (0 == job_count)
+        return;
+    {
+        // -- no worker is inside RunJobs here (see the wait below)
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_ = &job;
+        job_count_ = job_count;
+        next_job_ = 0;
+        finished_jobs_ = 0;
+        ++generation_;
+    }
+    work_ready_.notify_all();
+    RunJobs();
+
+    // -- wait for the jobs and for late workers to leave RunJobs,
+    // -- so the next call can reset the counters safely
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [&] {
+        return finished_jobs_ == job_count_ && 0 == active_workers_;
+    });
+    job_ = nullptr;
+}
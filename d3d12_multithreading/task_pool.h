@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// NOTE(omid): Fork-join pool for cpu jobs (loading, cooking)
+/*
+    ParallelFor hands out job indices from a shared counter, the calling
+    thread pitches in, and it returns once every job is done. Workers
+    sleep between calls. Separate from the render workers, which own
+    their cmdlists and run on their own events.
+*/
+
+struct TaskPool {
+private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    std::function<void (UINT)> const * job_;
+    UINT job_count_;
+    std::atomic<UINT> next_job_;
+    std::atomic<UINT> finished_jobs_;
+    UINT active_workers_;
+    UINT64 generation_;
+    bool quit_;
+
+    void WorkerLoop ();
+    void RunJobs ();
+public:
+    TaskPool ();
+    ~TaskPool ();
+
+    // -- thread_count counts the calling thread, 0 means one per core
+    void Init (UINT thread_count);
+    void Release ();
+
+    void ParallelFor (UINT job_count, std::function<void (UINT)> const & job);
+
+    UINT ThreadCount () const { return static_cast<UINT>(threads_.size()) + 1; }
+};
@@ -0,0 +1,124 @@
+#include "stdafx.h"
+#include "test.h"
+#include "asset_cooker.h"
+
+// -- draw over draw-relative indices [index_start, index_start + count)
+static PackDraw MakeDraw (UINT index_start, UINT index_count, UINT vertex_base) {
+    PackDraw draw = {};
+    draw.index_start = index_start;
+    draw.index_count = index_count;
+    draw.vertex_base = vertex_base;
+    draw.index_format = DXGI_FORMAT_R32_UINT;
+    return draw;
+}
+
+TEST(asset_cooker, indices16_boundary) {
+    // -- largest index of each draw: 0xFFFE still fits, 0xFFFF is the
+    // -- strip cut value and stays 32-bit, as does anything above
+    UINT const max_indices [] = {0, 0xFFFE, 0xFFFF, 0x10000, 0xFFFFFFFF};
+    std::vector<UINT> indices;
+    std::vector<PackDraw> draws;
+    for (UINT max_index : max_indices) {
+        draws.push_back(MakeDraw(static_cast<UINT>(indices.size()), 3, 0));
+        indices.push_back(max_index);
+        indices.push_back(0);
+        indices.push_back(max_index / 2);
+    }
+    std::vector<UINT16> indices16;
+    std::vector<UINT> indices32;
+    IndexConversionStats stats;
+    ConvertIndices16(
+        indices.data(), draws.data(), static_cast<UINT>(draws.size()), nullptr,
+        &indices16, &indices32, &stats
+    );
+    CHECK(DXGI_FORMAT_R16_UINT == draws[0].index_format);
+    CHECK(DXGI_FORMAT_R16_UINT == draws[1].index_format);
+    CHECK(DXGI_FORMAT_R32_UINT == draws[2].index_format);
+    CHECK(DXGI_FORMAT_R32_UINT == draws[3].index_format);
+    CHECK(DXGI_FORMAT_R32_UINT == draws[4].index_format);
+    CHECK(2 == stats.draws_16 && 3 == stats.draws_32);
+    CHECK(15 * sizeof(UINT) == stats.bytes_before);
+    CHECK(6 * sizeof(UINT16) + 9 * sizeof(UINT) == stats.bytes_after);
+    REQUIRE(6 == indices16.size() && 9 == indices32.size());
+    // -- no 16-bit index ever equals the cut value
+    for (UINT16 index : indices16)
+        CHECK(0xFFFF != index);
+    CHECK(0xFFFE == indices16[draws[1].index_start]);
+    CHECK(0xFFFF == indices32[draws[2].index_start]);
+    CHECK(0xFFFFFFFF == indices32[draws[4].index_start]);
+}
+
+TEST(asset_cooker, indices16_rebase) {
+    TestRandom random(30);
+    // -- interleaved narrow and wide draws, with lods and vertex bases
+    std::vector<UINT> indices;
+    std::vector<PackDraw> draws;
+    std::vector<PackLod> lods;
+    for (UINT d = 0; d < 40; ++d) {
+        bool const wide = 0 == d % 3;
+        UINT const count = 3 * (1 + random.Below(50));
+        UINT const vertex_base = random.Below(1u << 20);
+        PackDraw draw = MakeDraw(static_cast<UINT>(indices.size()), count, vertex_base);
+        for (UINT k = 0; k < count; ++k)
+            indices.push_back(wide ? 0x10000 + random.Below(1000) : random.Below(0xFFFF));
+        // -- a lod is a subset of the draw's own vertices
+        draw.lod_start = static_cast<UINT>(lods.size());
+        draw.lod_count = d % 2;
+        for (UINT l = 0; l < draw.lod_count; ++l) {
+            PackLod lod = {static_cast<UINT>(indices.size()), 3, 0.25f};
+            for (UINT k = 0; k < 3; ++k)
+                indices.push_back(indices[draw.index_start + k]);
+            lods.push_back(lod);
+        }
+        draws.push_back(draw);
+    }
+    // -- an empty draw goes narrow and takes no indices
+    draws.push_back(MakeDraw(static_cast<UINT>(indices.size()), 0, 7));
+
+    std::vector<PackDraw> const original_draws = draws;
+    std::vector<PackLod> const original_lods = lods;
+    std::vector<UINT16> indices16;
+    std::vector<UINT> indices32;
+    IndexConversionStats stats;
+    ConvertIndices16(
+        indices.data(), draws.data(), static_cast<UINT>(draws.size()), lods.data(),
+        &indices16, &indices32, &stats
+    );
+
+    // -- every range moves to its format's stream, in draw order, back to
+    // -- back, with its values (still draw-relative) unchanged
+    UINT64 next16 = 0;
+    UINT64 next32 = 0;
+    UINT64 bytes_after = 0;
+    for (UINT d = 0; d < draws.size(); ++d) {
+        PackDraw const & draw = draws[d];
+        PackDraw const & original = original_draws[d];
+        bool const narrow = DXGI_FORMAT_R16_UINT == draw.index_format;
+        CHECK(narrow == (0 != d % 3 || d == 40));
+        CHECK(draw.vertex_base == original.vertex_base);
+        CHECK(draw.index_count == original.index_count);
+        auto check_range = [&] (UINT index_start, UINT original_start, UINT count) {
+            UINT64 & next = narrow ? next16 : next32;
+            CHECK(index_start == next);
+            for (UINT k = 0; k < count; ++k) {
+                UINT const value = narrow ?
+                    indices16[index_start + k] : indices32[index_start + k];
+                CHECK(value == indices[original_start + k]);
+            }
+            next += count;
+            bytes_after += count * (narrow ? sizeof(UINT16) : sizeof(UINT));
+        };
+        check_range(draw.index_start, original.index_start, draw.index_count);
+        for (UINT l = 0; l < draw.lod_count; ++l) {
+            PackLod const & lod = lods[draw.lod_start + l];
+            PackLod const & original_lod = original_lods[draw.lod_start + l];
+            CHECK(lod.index_count == original_lod.index_count && lod.error == original_lod.error);
+            check_range(lod.index_start, original_lod.index_start, lod.index_count);
+        }
+    }
+    CHECK(next16 == indices16.size() && next32 == indices32.size());
+    CHECK(27 == stats.draws_16 && 14 == stats.draws_32);
+    CHECK(indices.size() * sizeof(UINT) == stats.bytes_before);
+    CHECK(bytes_after == stats.bytes_after);
+    CHECK(stats.bytes_after < stats.bytes_before);
+}
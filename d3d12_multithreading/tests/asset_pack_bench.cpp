@@ -0,0 +1,238 @@
+#include "stdafx.h"
+#include "bench.h"
+#include "asset_cooker.h"
+#include "asset_pack.h"
+#include "fast_copy.h"
+#include "task_pool.h"
+#include "test.h"
+#include "vertex_compression.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// NOTE(omid): Texture data load time, raw pack against lz4 chunks
+/*
+    Open and map the pack, parse it (without the payload crcs, as on a
+    warm start) and fill upload memory on the task pool: the raw pack
+    streams each texture, the lz4 one decodes its chunks into a cached
+    scratch and streams that, as LoadTextures does. Cold runs drop the
+    file from the page cache first (posix_fadvise), so they only mean
+    something on a real disk, not on tmpfs. The packs are written to the
+    working directory. Upload memory is plain cached memory here.
+
+    Texels are made up: bc1 blocks whose endpoints follow smooth noise
+    and whose indices repeat in places, which compresses about like the
+    room's albedo maps; the other formats get smooth gradients.
+*/
+static float Noise (UINT x, UINT y, UINT seed) {
+    UINT h = x * 374761393u + y * 668265263u + seed * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return ((h ^ (h >> 16)) & 1023) / 1023.0f;
+}
+static float SmoothNoise (float x, float y, UINT seed) {
+    UINT const xi = static_cast<UINT>(x);
+    UINT const yi = static_cast<UINT>(y);
+    float const fx = x - xi;
+    float const fy = y - yi;
+    float const top = Noise(xi, yi, seed) * (1 - fx) + Noise(xi + 1, yi, seed) * fx;
+    float const bottom = Noise(xi, yi + 1, seed) * (1 - fx) + Noise(xi + 1, yi + 1, seed) * fx;
+    return top * (1 - fy) + bottom * fy;
+}
+static void MakeTexels (
+    SampleAssets::TextureResource const & tex,
+    UINT seed,
+    TestRandom & random,
+    UINT8 * texels
+) {
+    for (UINT m = 0; m < tex.MipLevels; ++m) {
+        UINT8 * mip = texels + tex.Data[m].Offset;
+        UINT const rows = tex.Data[m].Size / tex.Data[m].Pitch;
+        if (DXGI_FORMAT_BC1_UNORM != tex.Format) {
+            for (UINT y = 0; y < rows; ++y)
+                for (UINT x = 0; x < tex.Data[m].Pitch; ++x)
+                    mip[y * tex.Data[m].Pitch + x] = static_cast<UINT8>(
+                        255.0f * SmoothNoise(x / 32.0f, y / 8.0f, seed)
+                    );
+            continue;
+        }
+        UINT const blocks = tex.Data[m].Pitch / 8;
+        UINT indices = 0;
+        for (UINT by = 0; by < rows; ++by) {
+            for (UINT bx = 0; bx < blocks; ++bx) {
+                float const value = SmoothNoise(bx / 16.0f, by / 16.0f, seed);
+                UINT16 const c0 = static_cast<UINT16>(value * 31.0f) << 11 | static_cast<UINT16>(value * 63.0f) << 5;
+                UINT16 const c1 = static_cast<UINT16>(value * 0.5f * 31.0f) << 11;
+                if (random.Below(2))
+                    indices = static_cast<UINT>(random.Next());
+                UINT8 * block = mip + by * tex.Data[m].Pitch + bx * 8;
+                memcpy(block, &c0, 2);
+                memcpy(block + 2, &c1, 2);
+                memcpy(block + 4, &indices, 4);
+            }
+        }
+    }
+}
+// -- the room's texture table in upload layout, in a pack with one draw
+static void WritePacks (std::vector<UINT8> * raw_pack, std::vector<UINT8> * lz4_pack) {
+    UINT const count = static_cast<UINT>(ArrayCount(SampleAssets::Textures));
+    UINT64 texel_size = 0;
+    for (UINT i = 0; i < count; ++i) {
+        SampleAssets::TextureResource const & tex = SampleAssets::Textures[i];
+        for (UINT m = 0; m < tex.MipLevels; ++m)
+            texel_size = std::max<UINT64>(texel_size, UINT64(tex.Data[m].Offset) + tex.Data[m].Size);
+    }
+    std::vector<UINT8> texels(static_cast<size_t>(texel_size), 0);
+    TestRandom random(40);
+    for (UINT i = 0; i < count; ++i)
+        MakeTexels(SampleAssets::Textures[i], i, random, texels.data());
+    std::vector<SampleAssets::TextureResource> textures(
+        SampleAssets::Textures, SampleAssets::Textures + count
+    );
+    std::vector<UINT8> texture_data;
+    if (FAILED(LayoutTexturesForUpload(texels.data(), textures.data(), count, &texture_data)))
+        return;
+    // -- chunks never straddle a texture
+    std::vector<UINT64> cuts;
+    for (SampleAssets::TextureResource const & tex : textures) {
+        UINT const last = tex.MipLevels - 1;
+        cuts.push_back(tex.Data[0].Offset);
+        cuts.push_back(UINT64(tex.Data[last].Offset) + tex.Data[last].Size);
+    }
+    std::sort(cuts.begin(), cuts.end());
+
+    CompressedVertex const vertex = {};
+    UINT const indices[3] = {0, 0, 0};
+    PackDraw draw = {};
+    draw.normal_texture_index = -1;
+    draw.specular_texture_index = -1;
+    draw.index_count = 3;
+    draw.index_format = DXGI_FORMAT_R32_UINT;
+    PackSource const source = {};
+    for (int compress = 0; compress < 2; ++compress) {
+        PackWriter writer;
+        writer.AddSection(PackSectionVertices, PackVertexCompressed, CompressedVertexStride, &vertex, sizeof(vertex));
+        writer.AddSection(PackSectionIndices, DXGI_FORMAT_R32_UINT, sizeof(UINT), indices, sizeof(indices));
+        writer.AddSection(
+            PackSectionTextures, 0, sizeof(SampleAssets::TextureResource),
+            textures.data(), textures.size() * sizeof(textures[0])
+        );
+        if (compress)
+            writer.AddCompressedSection(PackSectionTextureData, 0, 1, texture_data.data(), texture_data.size(), cuts);
+        else
+            writer.AddSection(PackSectionTextureData, 0, 1, texture_data.data(), texture_data.size());
+        writer.AddSection(PackSectionDraws, 0, sizeof(PackDraw), &draw, sizeof(draw));
+        writer.Write(CookerVersion, source, compress ? lz4_pack : raw_pack);
+    }
+}
+
+#if defined(__linux__)
+static bool WriteFile (char const * name, std::vector<UINT8> const & bytes) {
+    int const fd = open(name, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0)
+        return false;
+    bool const written = write(fd, bytes.data(), bytes.size()) == ssize_t(bytes.size());
+    // -- dirty pages would not be dropped from the page cache
+    fsync(fd);
+    close(fd);
+    return written;
+}
+// -- map, parse and fill upload, false on any failure
+static bool LoadPack (char const * name, bool cold, TaskPool & pool, std::vector<UINT8> & upload) {
+    int const fd = open(name, O_RDONLY);
+    if (fd < 0)
+        return false;
+    if (cold)
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    struct stat st;
+    fstat(fd, &st);
+    void * const mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == mapped)
+        return false;
+    PackView view;
+    bool loaded = SUCCEEDED(ParsePack(static_cast<UINT8 const *>(mapped), st.st_size, false, &view));
+    if (loaded && nullptr != view.texture_data) {
+        pool.ParallelFor(view.texture_count, [&] (UINT i) {
+            SampleAssets::TextureResource const & tex = view.textures[i];
+            UINT const last = tex.MipLevels - 1;
+            StreamCopy(
+                upload.data() + tex.Data[0].Offset,
+                view.texture_data + tex.Data[0].Offset,
+                tex.Data[last].Offset + tex.Data[last].Size - tex.Data[0].Offset
+            );
+        });
+    } else if (loaded) {
+        std::atomic<bool> decoded(true);
+        pool.ParallelFor(view.texture_chunk_count, [&] (UINT k) {
+            PackChunk const & chunk = view.texture_chunks[k];
+            static thread_local std::vector<UINT8> scratch;
+            scratch.resize(PackChunkSize);
+            if (!DecodePackChunk(chunk, view.texture_payload, scratch.data())) {
+                decoded = false;
+                return;
+            }
+            StreamCopy(upload.data() + chunk.raw_offset, scratch.data(), chunk.raw_size);
+        });
+        loaded = decoded;
+    }
+    munmap(mapped, st.st_size);
+    return loaded;
+}
+#endif
+
+BENCH(pack_load) {
+#if defined(__linux__)
+    std::vector<UINT8> packs[2];
+    WritePacks(&packs[0], &packs[1]);
+    char const * const names[2] = {"bench_raw.odxp", "bench_lz4.odxp"};
+    for (int p = 0; p < 2; ++p) {
+        if (packs[p].empty() || !WriteFile(names[p], packs[p])) {
+            printf("could not write %s\n", names[p]);
+            return;
+        }
+    }
+    PackView view;
+    if (FAILED(ParsePack(packs[0].data(), packs[0].size(), true, &view)))
+        return;
+    std::vector<UINT8> upload(static_cast<size_t>(view.texture_data_size), 0);
+    std::vector<UINT8> const expected(view.texture_data, view.texture_data + view.texture_data_size);
+    printf(
+        "texture data %.1f MiB, raw pack %.1f MiB, lz4 pack %.1f MiB (%.2f)\n",
+        view.texture_data_size / (1024.0 * 1024.0),
+        packs[0].size() / (1024.0 * 1024.0), packs[1].size() / (1024.0 * 1024.0),
+        double(packs[1].size()) / packs[0].size()
+    );
+
+    printf("threads    cold raw ms   cold lz4 ms    warm raw ms   warm lz4 ms\n");
+    for (UINT threads : {1u, 2u, 4u, 8u}) {
+        TaskPool pool;
+        pool.Init(threads);
+        double ms[2][2];
+        bool loaded = true;
+        for (int cold = 1; cold >= 0; --cold) {
+            for (int p = 0; p < 2; ++p) {
+                ms[cold][p] = BenchBest(5, [&] {
+                    loaded = LoadPack(names[p], 1 == cold, pool, upload) && loaded;
+                });
+                loaded = loaded && expected == upload;
+                std::fill(upload.begin(), upload.end(), UINT8(0));
+            }
+        }
+        pool.Release();
+        if (!loaded) {
+            printf("a load failed or filled upload memory wrong\n");
+            break;
+        }
+        printf("%7u %13.2f %13.2f %14.2f %13.2f\n", threads, ms[1][0], ms[1][1], ms[0][0], ms[0][1]);
+    }
+    for (char const * name : names)
+        unlink(name);
+    BenchSink = BenchSink + upload[upload.size() / 2];
+#else
+    printf("needs mmap and posix_fadvise (linux)\n");
+#endif
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// NOTE(omid): Minimal registry for the cpu benchmarks
+/*
+    BENCH(name) defines and registers a benchmark, odx_bench runs all of
+    them or only the ones named on its command line. Each one prints its
+    own table, timings are the best of a few runs (BenchBest) to keep
+    scheduling noise out. Not run by ctest, numbers depend on the machine.
+*/
+
+#include <chrono>
+#include <cstdio>
+
+struct BenchCase {
+    char const * name;
+    void (*run) ();
+    BenchCase * next;
+};
+
+struct BenchRegistrar {
+    BenchRegistrar (BenchCase * bench);
+};
+
+#define BENCH(name) \
+    static void name##_bench (); \
+    static BenchCase name##_case = { #name, name##_bench, nullptr }; \
+    static BenchRegistrar name##_registrar (&name##_case); \
+    static void name##_bench ()
+
+// -- best wall time of run() over runs calls, in milliseconds
+template <typename Function>
+double BenchBest (unsigned runs, Function const & run) {
+    double best = 1e30;
+    for (unsigned i = 0; i < runs; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        run();
+        auto const end = std::chrono::steady_clock::now();
+        double const ms = std::chrono::duration<double, std::milli>(end - start).count();
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+// -- keep the optimizer from dropping work whose result is unused
+extern volatile unsigned long long BenchSink;
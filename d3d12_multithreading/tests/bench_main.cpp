@@ -0,0 +1,36 @@
+#include "stdafx.h"
+#include "bench.h"
+
+static BenchCase * bench_list = nullptr;
+static BenchCase ** bench_list_end = &bench_list;
+
+volatile unsigned long long BenchSink = 0;
+LONGLONG TestPerformanceCounter = 0;
+
+BenchRegistrar::BenchRegistrar (BenchCase * bench) {
+    *bench_list_end = bench;
+    bench_list_end = &bench->next;
+}
+
+int main (int argc, char ** argv) {
+    int run = 0;
+    for (BenchCase * bench = bench_list; bench; bench = bench->next) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i)
+            selected = selected || 0 == strcmp(argv[i], bench->name);
+        if (!selected)
+            continue;
+        printf("-- %s\n", bench->name);
+        bench->run();
+        fflush(stdout);
+        ++run;
+    }
+    if (0 == run) {
+        printf("benchmarks:");
+        for (BenchCase * bench = bench_list; bench; bench = bench->next)
+            printf(" %s", bench->name);
+        printf("\n");
+        return 1;
+    }
+    return 0;
+}
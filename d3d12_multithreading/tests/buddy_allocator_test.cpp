@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "test.h"
+#include "buddy_allocator.h"
+
+#include <map>
+
+TEST(buddy_allocator, total_size_rounds_down) {
+    BuddyAllocator buddy;
+    buddy.Init(1000, 64);
+    CHECK(512 == buddy.TotalSize());
+    buddy.Init(1024, 64);
+    CHECK(1024 == buddy.TotalSize());
+    buddy.Init(64, 64);
+    CHECK(64 == buddy.TotalSize());
+    buddy.Init((3ull << 30) + 5, 64 * 1024);
+    CHECK((2ull << 30) == buddy.TotalSize());
+    // -- the rounded off tail is never handed out
+    buddy.Init(1000, 64);
+    UINT64 offset = 0;
+    UINT count = 0;
+    while (buddy.Allocate(64, 64, &offset)) {
+        CHECK(offset + 64 <= 512);
+        ++count;
+    }
+    CHECK(8 == count);
+}
+
+TEST(buddy_allocator, split_and_merge) {
+    BuddyAllocator buddy;
+    buddy.Init(1024, 64);
+    CHECK(buddy.Empty() && 1024 == buddy.LargestFreeBlock());
+
+    // -- one min block splits the range all the way down
+    UINT64 small = 1;
+    REQUIRE(buddy.Allocate(64, 1, &small));
+    CHECK(0 == small && 64 == buddy.UsedSize());
+    CHECK(512 == buddy.LargestFreeBlock());
+    // -- the next ones reuse the split halves, smallest first
+    UINT64 next = 0;
+    REQUIRE(buddy.Allocate(64, 1, &next));
+    CHECK(64 == next);
+    UINT64 medium = 0;
+    REQUIRE(buddy.Allocate(128, 1, &medium));
+    CHECK(128 == medium);
+    // -- freeing merges back with free buddies only
+    buddy.Free(small);
+    CHECK(512 == buddy.LargestFreeBlock());
+    buddy.Free(next);
+    CHECK(512 == buddy.LargestFreeBlock());
+    buddy.Free(medium);
+    CHECK(buddy.Empty() && 0 == buddy.UsedSize());
+    CHECK(1024 == buddy.LargestFreeBlock());
+    CHECK(0.0f == buddy.Fragmentation());
+
+    // -- fill with quarters, then exhaustion
+    UINT64 quarters[4];
+    for (UINT i = 0; i < 4; ++i) {
+        REQUIRE(buddy.Allocate(256, 1, &quarters[i]));
+        CHECK(256 * i == quarters[i]);
+    }
+    UINT64 offset = 0;
+    CHECK(!buddy.Allocate(64, 1, &offset));
+    CHECK(0 == buddy.LargestFreeBlock() && 0.0f == buddy.Fragmentation());
+    // -- two free quarters that are not buddies do not merge
+    buddy.Free(quarters[0]);
+    buddy.Free(quarters[2]);
+    CHECK(256 == buddy.LargestFreeBlock());
+    CHECK(0.5f == buddy.Fragmentation());
+    CHECK(!buddy.Allocate(512, 1, &offset));
+    // -- freeing the buddy merges into a half
+    buddy.Free(quarters[1]);
+    CHECK(512 == buddy.LargestFreeBlock());
+    CHECK(fabsf(buddy.Fragmentation() - 1.0f / 3.0f) < 1e-6f);   // -- 512 of 768 free
+    REQUIRE(buddy.Allocate(512, 1, &offset));
+    CHECK(0 == offset);
+}
+
+TEST(buddy_allocator, sizes_and_alignment) {
+    BuddyAllocator buddy;
+    buddy.Init(1 << 20, 256);
+    UINT64 offset = 0;
+    // -- sizes round up to a power of two block, at least min_block_size
+    REQUIRE(buddy.Allocate(1, 1, &offset));
+    CHECK(256 == buddy.UsedSize());
+    REQUIRE(buddy.Allocate(300, 1, &offset));
+    CHECK(0 == offset % 512 && 256 + 512 == buddy.UsedSize());
+    // -- alignment larger than the size takes an aligned (larger) block
+    UINT64 const used = buddy.UsedSize();
+    REQUIRE(buddy.Allocate(256, 64 * 1024, &offset));
+    CHECK(0 == offset % (64 * 1024));
+    CHECK(used + 64 * 1024 == buddy.UsedSize());
+    // -- d3d12 msaa placement alignment
+    REQUIRE(buddy.Allocate(4096, 4 * 1024 * 1024 / 8, &offset));
+    CHECK(0 == offset % (512 * 1024));
+    // -- nothing, too much, or an alignment past the range
+    CHECK(!buddy.Allocate(0, 1, &offset));
+    CHECK(!buddy.Allocate((1 << 20) + 1, 1, &offset));
+    CHECK(!buddy.Allocate(256, 2 << 20, &offset));
+    // -- an uninitialized allocator hands out nothing
+    BuddyAllocator none;
+    CHECK(!none.Allocate(256, 1, &offset));
+}
+
+TEST(buddy_allocator, random_stress) {
+    TestRandom random(33);
+    UINT64 const min_block = 64;
+    BuddyAllocator buddy;
+    buddy.Init(1 << 16, min_block);
+    std::map<UINT64, UINT64> live;  // -- offset -> block size
+    UINT64 used = 0;
+    for (UINT step = 0; step < 200000; ++step) {
+        bool const allocate = live.empty() || random.Below(100) < 55;
+        if (allocate) {
+            UINT64 const size = 1 + random.Below(random.Below(8) ? 512 : 8192);
+            UINT64 const alignment = 1ull << random.Below(11);
+            UINT64 offset = 0;
+            if (!buddy.Allocate(size, alignment, &offset)) {
+                // -- only fails when no free block is big enough
+                UINT64 block = min_block;
+                while (block < std::max(size, alignment))
+                    block <<= 1;
+                CHECK(buddy.LargestFreeBlock() < block);
+                continue;
+            }
+            UINT64 block = min_block;
+            while (block < std::max(size, alignment))
+                block <<= 1;
+            CHECK(0 == offset % block && 0 == offset % alignment);
+            CHECK(offset + block <= buddy.TotalSize());
+            // -- no overlap with the neighbours
+            auto const after = live.lower_bound(offset);
+            if (after != live.end())
+                CHECK(offset + block <= after->first);
+            if (after != live.begin())
+                CHECK(std::prev(after)->first + std::prev(after)->second <= offset);
+            live[offset] = block;
+            used += block;
+        } else {
+            auto it = live.begin();
+            std::advance(it, random.Below(static_cast<UINT>(live.size())));
+            buddy.Free(it->first);
+            used -= it->second;
+            live.erase(it);
+        }
+        CHECK(used == buddy.UsedSize());
+        float const fragmentation = buddy.Fragmentation();
+        CHECK(fragmentation >= 0.0f && fragmentation < 1.0f);
+    }
+    // -- everything merges back into one block
+    for (auto const & block : live)
+        buddy.Free(block.first);
+    CHECK(buddy.Empty() && 0 == buddy.UsedSize());
+    CHECK(buddy.TotalSize() == buddy.LargestFreeBlock());
+    CHECK(0.0f == buddy.Fragmentation());
+}
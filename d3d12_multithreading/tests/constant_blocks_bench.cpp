@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "bench.h"
+#include "constant_blocks.h"
+#include "squid_room.h"
+
+// NOTE(omid): Constant bytes written per frame
+/*
+    The frame resources' ConstantBlockCopy as OnUpdate drives it: blocks
+    marked dirty get a new version, and the current frame resource copies
+    whatever it has not seen. Each draw also writes its DrawCBuffer every
+    frame. Before the split, every frame wrote two whole SceneCBuffers
+    (scene and shadow pass), listed for comparison. The destination is
+    cached memory here.
+*/
+// -- the pre-split SceneCBuffer: model, view, projection, ambient, flags
+// -- and per light position, direction, color, falloff, view, projection
+static constexpr UINT SceneCBufferSize = 3 * 64 + 16 + 16 + NumLights * (4 * 16 + 2 * 64);
+
+BENCH(constant_bytes) {
+    UINT const draw_count = static_cast<UINT>(ArrayCount(SampleAssets::Draws));
+    UINT const frame_count = 3000;
+    struct Case {
+        char const * name;
+        UINT dirty;         // -- blocks OnUpdate marks every frame
+    } const cases [] = {
+        {"still", 0},
+        {"camera moving", 1u << ConstantsScenePass},
+        {"lights animated", 1u << ConstantsFrame | 1u << ConstantsShadowPass},
+        {"both", 1u << ConstantsFrame | 1u << ConstantsShadowPass | 1u << ConstantsScenePass},
+    };
+    printf(
+        "%u draws, %u frame resources, before the split: %u B/frame (one shared model)\n",
+        draw_count, DefaultFramesInFlight, 2 * SceneCBufferSize
+    );
+    printf("%-16s %12s %12s %12s %10s\n", "", "blocks B/f", "draws B/f", "total B/f", "us/frame");
+    for (Case const & c : cases) {
+        ConstantBlocks blocks = {};
+        for (UINT i = 0; i < ConstantBlockCount; ++i)
+            blocks.versions[i] = 1;
+        std::vector<ConstantBlockCopy> copies(DefaultFramesInFlight);
+        std::vector<std::vector<UINT8>> cbuffers(DefaultFramesInFlight);
+        for (std::vector<UINT8> & cbuffer : cbuffers)
+            cbuffer.resize(copies[0].Size());
+        // -- every resource starts up to date, the first frames are not counted
+        for (UINT r = 0; r < DefaultFramesInFlight; ++r)
+            copies[r].Write(blocks, cbuffers[r].data());
+
+        UINT64 written = 0;
+        double const ms = BenchBest(1, [&] {
+            for (UINT f = 0; f < frame_count; ++f) {
+                for (UINT i = 0; i < ConstantBlockCount; ++i) {
+                    if (c.dirty & 1u << i) {
+                        blocks.frame.lights[0].position.x = float(f);
+                        ++blocks.versions[i];
+                    }
+                }
+                UINT const r = f % DefaultFramesInFlight;
+                written += copies[r].Write(blocks, cbuffers[r].data());
+            }
+        });
+        double const block_bytes = double(written) / frame_count;
+        double const draw_bytes = double(draw_count) * sizeof(DrawCBuffer);
+        printf(
+            "%-16s %12.0f %12.0f %12.0f %10.3f\n",
+            c.name, block_bytes, draw_bytes, block_bytes + draw_bytes, ms * 1000.0 / frame_count
+        );
+        BenchSink = BenchSink + cbuffers[0][0];
+    }
+}
@@ -0,0 +1,72 @@
+#include "stdafx.h"
+#include "test.h"
+#include "constant_blocks.h"
+
+static UINT const Slot = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+static void FillBlocks (TestRandom & random, ConstantBlocks * blocks) {
+    UINT8 * bytes = reinterpret_cast<UINT8 *>(blocks);
+    for (size_t i = 0; i < offsetof(ConstantBlocks, versions); ++i)
+        bytes[i] = static_cast<UINT8>(random.Next());
+}
+
+TEST(constant_blocks, slot_layout) {
+    ConstantBlockCopy const copy;
+    // -- every element in its own aligned slot, in block order
+    UINT end = 0;
+    for (UINT block = 0; block < ConstantBlockCount; ++block) {
+        UINT const elements = ConstantsShadowPass == block ? NumLights : 1;
+        for (UINT e = 0; e < elements; ++e) {
+            UINT const offset = copy.Offset(block, e);
+            CHECK(0 == offset % Slot);
+            CHECK(offset >= end);
+            end = offset + Slot;
+        }
+    }
+    CHECK(sizeof(StaticCBuffer) <= copy.Offset(ConstantsFrame));
+    CHECK(copy.Offset(ConstantsShadowPass, 1) - copy.Offset(ConstantsShadowPass) == Slot);
+    CHECK(copy.Offset(ConstantsScenePass) + sizeof(PassCBuffer) <= copy.Size());
+    CHECK(0 == copy.Size() % Slot);
+}
+
+TEST(constant_blocks, writes_stale_blocks_only) {
+    TestRandom random(42);
+    ConstantBlocks blocks;
+    FillBlocks(random, &blocks);
+    for (UINT i = 0; i < ConstantBlockCount; ++i)
+        blocks.versions[i] = 1;
+    ConstantBlockCopy copy;
+    std::vector<UINT8> cbuffer(copy.Size(), 0xCD);
+
+    // -- a fresh copy has seen nothing: all of it, packed sizes counted
+    UINT64 const all =
+        sizeof(StaticCBuffer) + sizeof(FrameCBuffer) + (NumLights + 1) * sizeof(PassCBuffer);
+    CHECK(all == copy.Write(blocks, cbuffer.data()));
+    CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsStatic)], &blocks.static_constants, sizeof(StaticCBuffer)));
+    CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsFrame)], &blocks.frame, sizeof(FrameCBuffer)));
+    for (UINT i = 0; i < NumLights; ++i)
+        CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsShadowPass, i)], &blocks.shadow_passes[i], sizeof(PassCBuffer)));
+    CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsScenePass)], &blocks.scene_pass, sizeof(PassCBuffer)));
+    // -- the slots' padding is not written
+    CHECK(0xCD == cbuffer[copy.Offset(ConstantsScenePass) + sizeof(PassCBuffer)]);
+    CHECK(0xCD == cbuffer[copy.Offset(ConstantsShadowPass) + sizeof(PassCBuffer)]);
+
+    // -- nothing moved, nothing written
+    std::vector<UINT8> const before(cbuffer);
+    CHECK(0 == copy.Write(blocks, cbuffer.data()));
+    CHECK(before == cbuffer);
+
+    // -- one block moved: only that block
+    FillBlocks(random, &blocks);
+    ++blocks.versions[ConstantsShadowPass];
+    CHECK(NumLights * sizeof(PassCBuffer) == copy.Write(blocks, cbuffer.data()));
+    CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsShadowPass, NumLights - 1)], &blocks.shadow_passes[NumLights - 1], sizeof(PassCBuffer)));
+    CHECK(0 == memcmp(&cbuffer[0], &before[0], copy.Offset(ConstantsShadowPass)));
+    CHECK(0 == memcmp(&cbuffer[copy.Offset(ConstantsScenePass)], &before[copy.Offset(ConstantsScenePass)], sizeof(PassCBuffer)));
+
+    // -- copies are independent: another frame resource still lags
+    ConstantBlockCopy other;
+    std::vector<UINT8> other_cbuffer(other.Size(), 0);
+    CHECK(all == other.Write(blocks, other_cbuffer.data()));
+    CHECK(0 == other.Write(blocks, other_cbuffer.data()));
+}
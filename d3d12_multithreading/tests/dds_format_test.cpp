@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "test.h"
+#include "dds_format.h"
+
+// NOTE(omid): Header parsing over the corpus in data/dds
+/*
+    The valid files hold their texels (each byte i is i * 7), so the
+    parsed layout has to account for the file size exactly. The malformed
+    ones each break one rule of the parser.
+*/
+static std::vector<UINT8> ReadCorpus (char const * name) {
+    std::string const path = std::string(ODX_TEST_DATA_DIR "/dds/") + name;
+    std::vector<UINT8> bytes;
+    FILE * file = fopen(path.c_str(), "rb");
+    if (nullptr == file)
+        return bytes;
+    UINT8 buffer[4096];
+    size_t read = 0;
+    while (0 != (read = fread(buffer, 1, sizeof(buffer), file)))
+        bytes.insert(bytes.end(), buffer, buffer + read);
+    fclose(file);
+    return bytes;
+}
+
+TEST(dds_format, valid_corpus) {
+    struct Expected {
+        char const * name;
+        D3D12_RESOURCE_DIMENSION dimension;
+        DXGI_FORMAT format;
+        UINT width, height, depth, mip_count, array_size;
+        bool cube;
+    } const corpus [] = {
+        {"rgba8_4x2.dds", D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 2, 1, 1, 1, false},
+        {"bc1_16x8_mips.dds", D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC1_UNORM, 16, 8, 1, 5, 1, false},
+        {"bc7_8x8_array3.dds", D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC7_UNORM, 8, 8, 1, 2, 3, false},
+        {"bc3_cube_4x4.dds", D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_BC3_UNORM, 4, 4, 1, 1, 6, true},
+        {"r8_cube_legacy_2x2.dds", D3D12_RESOURCE_DIMENSION_TEXTURE2D, DXGI_FORMAT_R8_UNORM, 2, 2, 1, 1, 6, true},
+        {"rgba16f_volume_4x4x2.dds", D3D12_RESOURCE_DIMENSION_TEXTURE3D, DXGI_FORMAT_R16G16B16A16_FLOAT, 4, 4, 2, 1, 1, false},
+    };
+    for (Expected const & expected : corpus) {
+        std::vector<UINT8> const file = ReadCorpus(expected.name);
+        if (!CHECK(!file.empty()))
+            continue;
+        DdsInfo info;
+        if (!CHECK(S_OK == ParseDdsHeader(file.data(), static_cast<UINT>(file.size()), &info)))
+            continue;
+        CHECK(expected.dimension == info.dimension);
+        CHECK(expected.format == info.format);
+        CHECK(expected.width == info.width);
+        CHECK(expected.height == info.height);
+        CHECK(expected.depth == info.depth);
+        CHECK(expected.mip_count == info.mip_count);
+        CHECK(expected.array_size == info.array_size);
+        CHECK(expected.cube == info.cube);
+        // -- the texels end the file
+        CHECK(info.data_offset + info.data_size == file.size());
+        // -- subresources follow each other, items in mip order
+        UINT64 offset = info.data_offset;
+        for (UINT item = 0; item < info.array_size; ++item) {
+            for (UINT mip = 0; mip < info.mip_count; ++mip) {
+                DdsMip layout;
+                GetDdsMip(info, item, mip, &layout);
+                CHECK(offset == layout.offset);
+                offset += layout.size;
+            }
+        }
+        CHECK(info.item_size == GetDdsMipRangeSize(info, 0, info.mip_count));
+    }
+    // -- block rows: a bc1 4x2 mip is one row of one block
+    std::vector<UINT8> const bc1 = ReadCorpus("bc1_16x8_mips.dds");
+    DdsInfo info;
+    REQUIRE(S_OK == ParseDdsHeader(bc1.data(), static_cast<UINT>(bc1.size()), &info));
+    DdsMip layout;
+    GetDdsMip(info, 0, 2, &layout);
+    CHECK(4 == layout.width && 2 == layout.height);
+    CHECK(8 == layout.row_pitch && 1 == layout.row_count && 8 == layout.size);
+    CHECK(24 == GetDdsMipRangeSize(info, 2, 3));
+}
+
+TEST(dds_format, malformed_corpus) {
+    HRESULT const invalid = HRESULT_FROM_WIN32(ERROR_INVALID_DATA);
+    HRESULT const unsupported = HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    struct Expected {
+        char const * name;
+        HRESULT hr;
+    } const corpus [] = {
+        {"bad_magic.dds", invalid},
+        {"truncated_header.dds", invalid},
+        {"bad_header_size.dds", invalid},
+        {"bad_pixel_format_size.dds", invalid},
+        {"truncated_dx10.dds", invalid},
+        {"zero_array_size.dds", invalid},
+        // -- 0x2AAAAAAB cubes: 6 times that wraps to 2 in 32 bits
+        {"cube_array_overflow.dds", invalid},
+        {"array_too_large.dds", invalid},
+        {"too_many_mips.dds", invalid},
+        {"zero_width.dds", invalid},
+        {"too_wide.dds", invalid},
+        {"volume_array.dds", invalid},
+        {"bad_dimension.dds", invalid},
+        {"partial_cube.dds", unsupported},
+        {"unknown_fourcc.dds", unsupported},
+    };
+    for (Expected const & expected : corpus) {
+        std::vector<UINT8> const file = ReadCorpus(expected.name);
+        if (!CHECK(!file.empty()))
+            continue;
+        DdsInfo info;
+        HRESULT const hr = ParseDdsHeader(file.data(), static_cast<UINT>(file.size()), &info);
+        if (!CHECK(expected.hr == hr))
+            fprintf(stderr, "  %s: 0x%08x\n", expected.name, static_cast<unsigned>(hr));
+    }
+    DdsInfo info;
+    CHECK(E_INVALIDARG == ParseDdsHeader(nullptr, 0, &info));
+}
+
+TEST(dds_format, mutated_headers) {
+    // -- whatever a corrupt header says, an accepted one stays in bounds
+    char const * const seeds [] = {
+        "bc1_16x8_mips.dds", "bc7_8x8_array3.dds", "bc3_cube_4x4.dds",
+        "rgba16f_volume_4x4x2.dds",
+    };
+    TestRandom random(38);
+    for (char const * seed : seeds) {
+        std::vector<UINT8> const original = ReadCorpus(seed);
+        REQUIRE(original.size() >= DdsMaxHeaderSize);
+        for (UINT i = 0; i < 20000; ++i) {
+            std::vector<UINT8> file(original.begin(), original.begin() + DdsMaxHeaderSize);
+            // -- a few random bytes, or a random dword, of the headers
+            if (random.Below(2)) {
+                for (UINT n = 1 + random.Below(4); n > 0; --n)
+                    file[random.Below(DdsMaxHeaderSize)] = static_cast<UINT8>(random.Next());
+            } else {
+                UINT const value = static_cast<UINT>(random.Next() >> random.Below(64));
+                memcpy(&file[4 * random.Below(DdsMaxHeaderSize / 4)], &value, sizeof(value));
+            }
+            DdsInfo info;
+            if (S_OK != ParseDdsHeader(file.data(), static_cast<UINT>(file.size()), &info))
+                continue;
+            CHECK(info.width >= 1 && info.width <= DdsMaxDimension);
+            CHECK(info.height >= 1 && info.height <= DdsMaxDimension);
+            CHECK(info.depth >= 1 && info.depth <= DdsMaxDimension);
+            CHECK(info.array_size >= 1 && info.array_size <= 2048);
+            CHECK(!info.cube || 0 == info.array_size % 6);
+            CHECK(info.mip_count >= 1 && info.mip_count <= D3D12_REQ_MIP_LEVELS);
+            CHECK(0 != BitsPerPixel(info.format));
+            CHECK(info.data_size == info.item_size * info.array_size);
+        }
+    }
+}
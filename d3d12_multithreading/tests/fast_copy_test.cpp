@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "test.h"
+#include "fast_copy.h"
+
+// -- what d3dx12's MemcpySubresource does for one slice
+static void RowMemcpy (
+    void * dst, size_t dst_pitch,
+    void const * src, size_t src_pitch,
+    size_t row_size, UINT row_count
+) {
+    for (UINT y = 0; y < row_count; ++y)
+        memcpy(
+            static_cast<UINT8 *>(dst) + dst_pitch * y,
+            static_cast<UINT8 const *>(src) + src_pitch * y,
+            row_size
+        );
+}
+
+TEST(fast_copy, stream_copy_sizes) {
+    TestRandom random(37);
+    // -- around the threshold, the 16 and 64 byte loops and their tails
+    size_t const sizes [] = {
+        0, 1, 15, 16, 17, 63, 64, 65,
+        StreamCopyThreshold - 1, StreamCopyThreshold, StreamCopyThreshold + 1,
+        StreamCopyThreshold + 63, 65536 + 15, 1 << 20,
+    };
+    for (size_t size : sizes) {
+        for (size_t misalign = 0; misalign < 16; misalign += 5) {
+            std::vector<UINT8> src(size + 32);
+            for (UINT8 & byte : src)
+                byte = static_cast<UINT8>(random.Next());
+            // -- guard bytes on both sides
+            std::vector<UINT8> dst(size + 64, 0xCD);
+            StreamCopy(dst.data() + 16 + misalign, src.data() + misalign, size);
+            CHECK(0 == memcmp(dst.data() + 16 + misalign, src.data() + misalign, size));
+            bool guards = true;
+            for (size_t i = 0; i < 16 + misalign; ++i)
+                guards = guards && 0xCD == dst[i];
+            for (size_t i = 16 + misalign + size; i < dst.size(); ++i)
+                guards = guards && 0xCD == dst[i];
+            CHECK(guards);
+        }
+    }
+}
+
+TEST(fast_copy, copy_rows_matches_helper) {
+    TestRandom random(2037);
+    for (UINT t = 0; t < 2000; ++t) {
+        size_t const row_size = 1 + random.Below(5000);
+        size_t src_pitch = row_size + random.Below(64);
+        size_t dst_pitch = (row_size + 255) / 256 * 256 + random.Below(2) * 256;
+        UINT const row_count = random.Below(41);
+        // -- equal pitches take the bulk path
+        if (0 == random.Below(4)) {
+            src_pitch = row_size;
+            dst_pitch = row_size;
+        }
+        size_t const misalign = random.Below(16);
+        std::vector<UINT8> src(src_pitch * row_count + 16);
+        for (UINT8 & byte : src)
+            byte = static_cast<UINT8>(random.Next());
+        // -- padding between rows must be left alone too
+        std::vector<UINT8> expected(dst_pitch * row_count + 64, 0xCD);
+        std::vector<UINT8> actual(expected);
+        RowMemcpy(expected.data() + misalign, dst_pitch, src.data(), src_pitch, row_size, row_count);
+        CopyRows(actual.data() + misalign, dst_pitch, src.data(), src_pitch, row_size, row_count);
+        CHECK(expected == actual);
+    }
+}
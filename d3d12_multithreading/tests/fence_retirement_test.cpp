@@ -0,0 +1,159 @@
+#include "stdafx.h"
+#include "test.h"
+#include "fence_retirement.h"
+
+// -- a fence the gpu advances: signaled values complete in order
+struct FakeFence {
+    UINT64 signaled;
+    UINT64 completed;
+    UINT64 Signal () { return ++signaled; }
+    void Advance (UINT64 count) { completed = std::min(completed + count, signaled); }
+};
+
+TEST(fence_retirement, retire_in_order) {
+    FenceRetirement retirement;
+    retirement.Init(1, 3);
+    FakeFence fence = {};
+    // -- three frames in flight
+    for (UINT item = 0; item < 3; ++item)
+        retirement.Track(item, 0, fence.Signal());
+    CHECK(!retirement.Retired(0) && 1 == retirement.ItemValue(0));
+    CHECK(0 == retirement.Retire(0, fence.completed));
+    fence.Advance(2);
+    CHECK(2 == retirement.Retire(0, fence.completed));
+    CHECK(retirement.Retired(0) && retirement.Retired(1) && !retirement.Retired(2));
+    CHECK(2 == retirement.Completed(0) && 2 == retirement.RetiredCount());
+    // -- a retired item is tracked again when it is reused
+    retirement.Track(0, 0, fence.Signal());
+    CHECK(!retirement.Retired(0) && 4 == retirement.ItemValue(0));
+    fence.Advance(2);
+    CHECK(2 == retirement.Retire(0, fence.completed));
+    CHECK(retirement.Retired(0) && retirement.Retired(2) && 4 == retirement.RetiredCount());
+}
+
+TEST(fence_retirement, track_passed_value) {
+    FenceRetirement retirement;
+    retirement.Init(1, 2);
+    CHECK(0 == retirement.Retire(0, 5));
+    // -- at or below the completed value: retired on the spot, counted
+    retirement.Track(0, 0, 4);
+    CHECK(retirement.Retired(0) && 1 == retirement.RetiredCount());
+    retirement.Track(1, 0, 5);
+    CHECK(retirement.Retired(1) && 2 == retirement.RetiredCount());
+    // -- and a later Retire does not count them again
+    CHECK(0 == retirement.Retire(0, 9));
+    CHECK(2 == retirement.RetiredCount());
+    // -- one past it waits
+    retirement.Track(0, 0, 10);
+    CHECK(!retirement.Retired(0));
+    CHECK(1 == retirement.Retire(0, 10));
+}
+
+TEST(fence_retirement, stale_completed_values) {
+    FenceRetirement retirement;
+    retirement.Init(1, 2);
+    retirement.Track(0, 0, 3);
+    retirement.Track(1, 0, 8);
+    CHECK(1 == retirement.Retire(0, 5));
+    // -- an older read (another thread's, say) moves nothing back
+    CHECK(0 == retirement.Retire(0, 4));
+    CHECK(0 == retirement.Retire(0, 5));
+    CHECK(5 == retirement.Completed(0));
+    CHECK(!retirement.Retired(1) && 8 == retirement.ItemValue(1));
+    // -- and a value tracked in between is judged against the newest
+    retirement.Track(0, 0, 5);
+    CHECK(retirement.Retired(0));
+    CHECK(1 == retirement.Retire(0, 8));
+    CHECK(3 == retirement.RetiredCount());
+}
+
+TEST(fence_retirement, fences_are_separate) {
+    FenceRetirement retirement;
+    retirement.Init(2, 4);
+    // -- same values on both fences
+    retirement.Track(0, 0, 1);
+    retirement.Track(1, 1, 1);
+    retirement.Track(2, 0, 2);
+    retirement.Track(3, 1, 2);
+    CHECK(1 == retirement.ItemFence(1) && 0 == retirement.ItemFence(2));
+    CHECK(2 == retirement.Retire(1, 2));
+    CHECK(!retirement.Retired(0) && retirement.Retired(1));
+    CHECK(!retirement.Retired(2) && retirement.Retired(3));
+    CHECK(0 == retirement.Completed(0) && 2 == retirement.Completed(1));
+    CHECK(1 == retirement.Retire(0, 1));
+    CHECK(retirement.Retired(0) && !retirement.Retired(2));
+    // -- an item moved to the other fence only waits on that one
+    retirement.Track(2, 1, 3);
+    CHECK(0 == retirement.Retire(0, 5));
+    CHECK(!retirement.Retired(2));
+    CHECK(1 == retirement.Retire(1, 3));
+    CHECK(2 == retirement.FenceCount());
+}
+
+TEST(fence_retirement, random_against_fake_fences) {
+    // -- frames and uploads on a graphics and a copy fence, retired by
+    // -- whoever reads a fence, in any order and with stale reads
+    UINT const fence_count = 2;
+    UINT const item_count = 6;
+    TestRandom random(44);
+    FenceRetirement retirement;
+    retirement.Init(fence_count, item_count);
+    FakeFence fences[fence_count] = {};
+    UINT64 reads[fence_count] = {};         // -- possibly stale copies
+    std::vector<UINT> waiting_fence(item_count, 0);
+    std::vector<UINT64> waiting_value(item_count, 0);
+    UINT64 tracked = 0;
+    bool consistent = true;
+    for (UINT step = 0; step < 20000; ++step) {
+        UINT const fence = random.Below(fence_count);
+        switch (random.Below(4)) {
+        case 0: {
+            // -- reuse a retired item (as the sample reuses frame resources)
+            UINT const item = random.Below(item_count);
+            if (!retirement.Retired(item))
+                break;
+            UINT64 const value = fences[fence].Signal();
+            retirement.Track(item, fence, value);
+            waiting_fence[item] = fence;
+            waiting_value[item] = value;
+            ++tracked;
+            break;
+        }
+        case 1:
+            fences[fence].Advance(random.Below(3));
+            break;
+        case 2:
+            reads[fence] = fences[fence].completed;
+            break;
+        default: {
+            // -- feed a fresh or a stale read
+            UINT64 const completed = random.Below(2) ? fences[fence].completed : reads[fence];
+            UINT expected = 0;
+            for (UINT item = 0; item < item_count; ++item) {
+                if (
+                    !retirement.Retired(item) && waiting_fence[item] == fence &&
+                    waiting_value[item] <= completed
+                ) {
+                    ++expected;
+                }
+            }
+            consistent = consistent && expected == retirement.Retire(fence, completed);
+            break;
+        }
+        }
+        // -- nothing is retired before its fence got there
+        for (UINT item = 0; item < item_count; ++item) {
+            consistent = consistent && (
+                retirement.Retired(item) ||
+                waiting_value[item] > retirement.Completed(waiting_fence[item])
+            );
+        }
+    }
+    CHECK(consistent);
+    // -- all of it retires once the fences catch up
+    for (UINT fence = 0; fence < fence_count; ++fence)
+        retirement.Retire(fence, fences[fence].signaled);
+    for (UINT item = 0; item < item_count; ++item)
+        CHECK(retirement.Retired(item));
+    CHECK(tracked == retirement.RetiredCount());
+}
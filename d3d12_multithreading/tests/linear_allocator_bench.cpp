@@ -0,0 +1,78 @@
+#include "stdafx.h"
+#include "bench.h"
+#include "linear_allocator.h"
+
+#include <mutex>
+#include <thread>
+
+// NOTE(omid): Per-draw constant allocation under contention
+/*
+    Every thread allocates a 96 byte draw cbuffer at the 256 byte
+    constant buffer alignment, a million times: with its own cursor
+    (LinearAllocator), with a fetch_add on one shared head per
+    allocation, and under a mutex. Only the allocation is timed, nothing
+    is written. ns are per allocation, wall time over all threads;
+    refills is how often the cursors went to the shared head in one run.
+*/
+static constexpr UINT AllocationsPerThread = 1u << 20;
+
+// -- best of 5, each run starting from reset()
+template <typename Reset, typename Body>
+static double RunThreads (UINT thread_count, Reset const & reset, Body const & body) {
+    return BenchBest(5, [&] {
+        reset();
+        std::vector<std::thread> threads;
+        for (UINT t = 0; t < thread_count; ++t)
+            threads.emplace_back(body);
+        for (std::thread & thread : threads)
+            thread.join();
+    });
+}
+
+BENCH(linear_contention) {
+    UINT const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    printf("%u cores, %u allocations per thread\n", cores, AllocationsPerThread);
+    printf("threads  cursor ns  atomic ns   mutex ns   refills\n");
+    for (UINT thread_count : {1u, 2u, 4u, 8u}) {
+        UINT64 const total = UINT64(AllocationsPerThread) * thread_count;
+        LinearAllocator allocator;
+        allocator.Init(total * 256 + thread_count * 65536, 64 * 1024);
+        double const cursor = RunThreads(thread_count, [&] { allocator.Reset(); }, [&] {
+            LinearAllocator::Cursor mine = {};
+            UINT64 sum = 0;
+            for (UINT i = 0; i < AllocationsPerThread; ++i) {
+                UINT64 offset = 0;
+                allocator.Allocate(&mine, 96, 256, &offset);
+                sum += offset;
+            }
+            BenchSink = BenchSink + sum;
+        });
+        UINT const refills = allocator.Refills();
+
+        std::atomic<UINT64> head(0);
+        double const atomic = RunThreads(thread_count, [&] { head = 0; }, [&] {
+            UINT64 sum = 0;
+            for (UINT i = 0; i < AllocationsPerThread; ++i)
+                sum += head.fetch_add(256, std::memory_order_relaxed);
+            BenchSink = BenchSink + sum;
+        });
+
+        std::mutex mutex;
+        UINT64 locked_head = 0;
+        double const locked = RunThreads(thread_count, [&] { locked_head = 0; }, [&] {
+            UINT64 sum = 0;
+            for (UINT i = 0; i < AllocationsPerThread; ++i) {
+                std::lock_guard<std::mutex> lock(mutex);
+                sum += locked_head;
+                locked_head += 256;
+            }
+            BenchSink = BenchSink + sum;
+        });
+
+        double const ns = 1e6 / double(total);
+        printf(
+            "%7u %10.2f %10.2f %10.2f %9u\n",
+            thread_count, cursor * ns, atomic * ns, locked * ns, refills
+        );
+    }
+}
@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "test.h"
+#include "linear_allocator.h"
+
+#include <thread>
+
+TEST(linear_allocator, chunks_and_exhaustion) {
+    LinearAllocator allocator;
+    allocator.Init(1000, 64);
+    // -- the chunk size rounds up to the chunk alignment
+    CHECK(256 == allocator.ChunkSize());
+    LinearAllocator::Cursor cursor = {};
+    UINT64 offset = 1;
+    CHECK(!allocator.Allocate(&cursor, 0, 1, &offset));
+    // -- small ones share a chunk, one refill
+    REQUIRE(allocator.Allocate(&cursor, 100, 1, &offset));
+    CHECK(0 == offset);
+    REQUIRE(allocator.Allocate(&cursor, 50, 64, &offset));
+    CHECK(128 == offset && 1 == allocator.Refills());
+    // -- the chunk's tail is skipped for what does not fit in it
+    REQUIRE(allocator.Allocate(&cursor, 200, 1, &offset));
+    CHECK(256 == offset && 2 == allocator.Refills() && 512 == allocator.UsedSize());
+    REQUIRE(allocator.Allocate(&cursor, 200, 1, &offset));
+    CHECK(512 == offset && 3 == allocator.Refills());
+    // -- 232 bytes left in the range, less than a chunk: exhausted
+    CHECK(!allocator.Allocate(&cursor, 100, 1, &offset));
+    CHECK(1000 == allocator.UsedSize() && 3 == allocator.Refills());
+    // -- and it stays that way, even for another cursor
+    LinearAllocator::Cursor other = {};
+    CHECK(!allocator.Allocate(&other, 1, 1, &offset));
+
+    // -- Reset takes it all back, cursors start over
+    allocator.Reset();
+    cursor = {};
+    CHECK(0 == allocator.UsedSize() && 0 == allocator.Refills());
+    REQUIRE(allocator.Allocate(&cursor, 768, 1, &offset));
+    CHECK(0 == offset);
+    // -- a chunk is never cut short by the end of the range
+    CHECK(!allocator.Allocate(&cursor, 1, 1, &offset));
+}
+
+TEST(linear_allocator, oversized_allocations) {
+    LinearAllocator allocator;
+    allocator.Init(4096, 256);
+    LinearAllocator::Cursor cursor = {};
+    UINT64 offset = 1;
+    // -- larger than a chunk: a chunk of its own (rounded) size
+    REQUIRE(allocator.Allocate(&cursor, 600, 16, &offset));
+    CHECK(0 == offset && 768 == allocator.UsedSize());
+    // -- whose tail the cursor keeps using
+    REQUIRE(allocator.Allocate(&cursor, 100, 8, &offset));
+    CHECK(600 == offset && 1 == allocator.Refills());
+    // -- past what is left of the range
+    CHECK(!allocator.Allocate(&cursor, 4000, 1, &offset));
+    // -- a failed refill does not give the range back
+    LinearAllocator::Cursor other = {};
+    CHECK(!allocator.Allocate(&other, 256, 1, &offset));
+}
+
+TEST(linear_allocator, concurrent_disjoint) {
+    struct Range {
+        UINT64 offset;
+        UINT64 size;
+        UINT64 alignment;
+    };
+    for (UINT round = 0; round < 40; ++round) {
+        UINT const thread_count = 1 + round % 8;
+        UINT64 const size = UINT64(1 + round % 7) << 20;
+        UINT64 const chunk_size = 64 * 1024;
+        LinearAllocator allocator;
+        allocator.Init(size, chunk_size);
+        std::vector<std::vector<Range>> ranges(thread_count);
+        std::vector<std::thread> threads;
+        for (UINT t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&, t] {
+                TestRandom random(round * 64 + t + 1);
+                LinearAllocator::Cursor cursor = {};
+                // -- until a chunk sized request fails, the range is spent
+                for (;;) {
+                    Range range;
+                    range.size = 0 == random.Below(5) ? 1 + random.Below(200000) : 1 + random.Below(300);
+                    range.alignment = UINT64(1) << random.Below(9);
+                    if (allocator.Allocate(&cursor, range.size, range.alignment, &range.offset))
+                        ranges[t].push_back(range);
+                    else if (range.size <= chunk_size)
+                        break;
+                }
+            });
+        }
+        for (std::thread & thread : threads)
+            thread.join();
+
+        std::vector<Range> all;
+        for (std::vector<Range> const & mine : ranges)
+            all.insert(all.end(), mine.begin(), mine.end());
+        std::sort(all.begin(), all.end(), [] (Range const & a, Range const & b) {
+            return a.offset < b.offset;
+        });
+        bool placed = true;
+        UINT64 allocated = 0;
+        for (size_t i = 0; i < all.size(); ++i) {
+            placed = placed && 0 == all[i].offset % all[i].alignment;
+            placed = placed && all[i].offset + all[i].size <= size;
+            placed = placed && (0 == i || all[i - 1].offset + all[i - 1].size <= all[i].offset);
+            allocated += all[i].size;
+        }
+        CHECK(placed);
+        CHECK(allocator.UsedSize() <= size);
+        // -- what is left unused is chunk tails, at most a chunk per
+        // -- thread at the end, and the large ones' rounding
+        CHECK(allocated > size / 2);
+    }
+}
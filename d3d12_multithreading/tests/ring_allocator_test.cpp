@@ -0,0 +1,159 @@
+#include "stdafx.h"
+#include "test.h"
+#include "ring_allocator.h"
+
+TEST(ring_allocator, full_and_empty) {
+    RingAllocator ring;
+    ring.Init(1024);
+    UINT64 offset = 1;
+    CHECK(0 == ring.UsedSize() && 0 == ring.OldestFence());
+    // -- the whole ring in one go, then nothing fits
+    REQUIRE(ring.Allocate(1024, 1, &offset));
+    CHECK(0 == offset && 1024 == ring.UsedSize() && 1024 == ring.PendingSize());
+    CHECK(!ring.Allocate(1, 1, &offset));
+    ring.Commit(1);
+    CHECK(0 == ring.PendingSize() && 1 == ring.OldestFence());
+    CHECK(!ring.Allocate(1, 1, &offset));
+    // -- retired: empty again, and a full ring is not mistaken for it
+    ring.Retire(1);
+    CHECK(0 == ring.UsedSize() && 0 == ring.OldestFence());
+    REQUIRE(ring.Allocate(1024, 1, &offset));
+    CHECK(0 == offset);
+    ring.Commit(2);
+    ring.Retire(2);
+    // -- too big or nothing at all
+    CHECK(!ring.Allocate(1025, 1, &offset));
+    CHECK(!ring.Allocate(0, 1, &offset));
+    CHECK(0 == ring.UsedSize());
+}
+
+TEST(ring_allocator, wrap_with_padding) {
+    RingAllocator ring;
+    ring.Init(1000);
+    UINT64 offset = 0;
+    REQUIRE(ring.Allocate(600, 1, &offset));
+    CHECK(0 == offset);
+    ring.Commit(1);
+    // -- alignment padding counts as used
+    REQUIRE(ring.Allocate(100, 256, &offset));
+    CHECK(768 == offset && 868 == ring.UsedSize());
+    ring.Commit(2);
+    // -- 200 does not fit before the end, and the front is still in use
+    CHECK(!ring.Allocate(200, 1, &offset));
+    CHECK(868 == ring.UsedSize());
+    ring.Retire(1);
+    CHECK(268 == ring.UsedSize());
+    // -- wraps to 0, the 132 bytes left at the end are wasted
+    REQUIRE(ring.Allocate(200, 1, &offset));
+    CHECK(0 == offset && 268 + 132 + 200 == ring.UsedSize());
+    ring.Commit(3);
+    // -- the skipped bytes retire with the allocation that wrapped
+    ring.Retire(2);
+    CHECK(132 + 200 == ring.UsedSize());
+    ring.Retire(3);
+    CHECK(0 == ring.UsedSize());
+    // -- aligned allocations that exactly reach the end do not wrap
+    REQUIRE(ring.Allocate(504, 8, &offset));
+    CHECK(0 == offset);
+    REQUIRE(ring.Allocate(496, 8, &offset));
+    CHECK(504 == offset && 1000 == ring.UsedSize());
+    CHECK(!ring.Allocate(1, 1, &offset));
+    ring.Commit(4);
+    ring.Retire(4);
+    CHECK(0 == ring.UsedSize());
+    // -- an empty ring restarts at 0 rather than wrapping later
+    REQUIRE(ring.Allocate(1000, 1, &offset));
+    CHECK(0 == offset);
+}
+
+TEST(ring_allocator, commit_and_retire_order) {
+    RingAllocator ring;
+    ring.Init(4096);
+    UINT64 offset = 0;
+    // -- uncommitted bytes are never retired
+    REQUIRE(ring.Allocate(100, 1, &offset));
+    ring.Retire(100);
+    CHECK(100 == ring.UsedSize() && 100 == ring.PendingSize());
+    ring.Commit(5);
+    // -- commits without new bytes add no marker
+    ring.Commit(5);
+    ring.Commit(6);
+    CHECK(5 == ring.OldestFence());
+    // -- several commits under one fence value retire together
+    REQUIRE(ring.Allocate(100, 1, &offset));
+    ring.Commit(7);
+    REQUIRE(ring.Allocate(100, 1, &offset));
+    ring.Commit(7);
+    REQUIRE(ring.Allocate(100, 1, &offset));
+    ring.Commit(9);
+    // -- stale completed values retire nothing
+    ring.Retire(4);
+    CHECK(400 == ring.UsedSize() && 5 == ring.OldestFence());
+    ring.Retire(6);
+    CHECK(300 == ring.UsedSize() && 7 == ring.OldestFence());
+    ring.Retire(5);
+    CHECK(300 == ring.UsedSize());
+    // -- a completed value that skips ahead retires everything up to it
+    ring.Retire(8);
+    CHECK(100 == ring.UsedSize() && 9 == ring.OldestFence());
+    ring.Retire(1000);
+    CHECK(0 == ring.UsedSize() && 0 == ring.OldestFence());
+    ring.Retire(999);
+    CHECK(0 == ring.UsedSize());
+}
+
+TEST(ring_allocator, random_stress) {
+    struct Region {
+        UINT64 offset;
+        UINT64 size;
+        UINT64 fence_value;     // -- 0 until committed
+    };
+    TestRandom random(34);
+    RingAllocator ring;
+    UINT64 const size = 64 * 1024 + 17;     // -- not a power of two
+    ring.Init(size);
+    std::vector<Region> live;
+    UINT64 fence_value = 0;
+    UINT64 completed = 0;
+    for (UINT frame = 0; frame < 20000; ++frame) {
+        UINT const count = random.Below(12);
+        for (UINT i = 0; i < count; ++i) {
+            UINT64 const bytes = 1 + random.Below(random.Below(10) ? 2048 : 24 * 1024);
+            UINT64 const alignment = 1ull << random.Below(10);
+            UINT64 offset = 0;
+            if (!ring.Allocate(bytes, alignment, &offset)) {
+                // -- only a ring with something in it refuses
+                CHECK(!live.empty() && ring.UsedSize() > 0);
+                continue;
+            }
+            CHECK(0 == offset % alignment && offset + bytes <= size);
+            for (Region const & region : live)
+                CHECK(offset + bytes <= region.offset || region.offset + region.size <= offset);
+            live.push_back({offset, bytes, 0});
+        }
+        // -- some frames commit nothing, fence values never go back
+        fence_value += random.Below(3);
+        ring.Commit(fence_value);
+        for (Region & region : live)
+            if (0 == region.fence_value)
+                region.fence_value = fence_value;
+        // -- the gpu lags a few fences behind, completed values may be stale
+        if (random.Below(4) > 0 && fence_value > completed)
+            completed += random.Below(static_cast<UINT>(fence_value - completed) + 1);
+        UINT64 const reported = completed - std::min<UINT64>(completed, random.Below(3));
+        ring.Retire(reported);
+        live.erase(
+            std::remove_if(live.begin(), live.end(), [&] (Region const & region) {
+                return 0 != region.fence_value && region.fence_value <= reported;
+            }),
+            live.end()
+        );
+        UINT64 live_bytes = 0;
+        for (Region const & region : live)
+            live_bytes += region.size;
+        CHECK(ring.UsedSize() >= live_bytes && ring.UsedSize() <= size);
+        CHECK(live.empty() == (0 == ring.UsedSize()));
+    }
+    ring.Retire(fence_value);
+    CHECK(0 == ring.UsedSize());
+}
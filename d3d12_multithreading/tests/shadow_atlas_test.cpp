@@ -0,0 +1,59 @@
+#include "stdafx.h"
+#include "test.h"
+#include "shadow_atlas.h"
+
+// -- tiles inside the atlas and none overlapping
+static bool TilesPartition (ShadowAtlas const & atlas) {
+    bool ok = true;
+    for (UINT i = 0; i < atlas.TileCount(); ++i) {
+        ShadowTile const a = atlas.Tile(i);
+        ok = ok && a.width == atlas.TileWidth() && a.height == atlas.TileHeight();
+        ok = ok && a.x + a.width <= atlas.Width() && a.y + a.height <= atlas.Height();
+        for (UINT j = 0; j < i; ++j) {
+            ShadowTile const b = atlas.Tile(j);
+            bool const apart =
+                a.x + a.width <= b.x || b.x + b.width <= a.x ||
+                a.y + a.height <= b.y || b.y + b.height <= a.y;
+            ok = ok && apart;
+        }
+    }
+    return ok;
+}
+
+TEST(shadow_atlas, grid_shape) {
+    ShadowAtlas atlas;
+    // -- 3 tiles: a row or a column waste none, the column comes first
+    REQUIRE(atlas.Init(1024, 1024, 3, 16384));
+    CHECK(1024 == atlas.Width() && 3072 == atlas.Height());
+    CHECK(TilesPartition(atlas));
+    // -- 4 tiles: 2x2 wastes none and is squarer than 1x4
+    REQUIRE(atlas.Init(1024, 1024, 4, 16384));
+    CHECK(2048 == atlas.Width() && 2048 == atlas.Height());
+    CHECK(TilesPartition(atlas));
+    // -- a column of 3 does not fit: 2x2, one tile unused
+    REQUIRE(atlas.Init(4096, 4096, 3, 8192));
+    CHECK(8192 == atlas.Width() && 8192 == atlas.Height());
+    CHECK(TilesPartition(atlas));
+    // -- 5 tiles of the largest preset in 16384: 2x3 or 3x2 (6), not 1x5
+    REQUIRE(atlas.Init(4096, 4096, 5, 16384));
+    CHECK(6 * 4096 * 4096 == UINT64(atlas.Width()) * atlas.Height());
+    CHECK(TilesPartition(atlas));
+    // -- not even one tile fits
+    CHECK(!atlas.Init(8192, 8192, 3, 4096));
+}
+
+TEST(shadow_atlas, tile_transform) {
+    ShadowAtlas atlas;
+    REQUIRE(atlas.Init(512, 256, 5, 1024));
+    CHECK(TilesPartition(atlas));
+    for (UINT i = 0; i < atlas.TileCount(); ++i) {
+        ShadowTile const tile = atlas.Tile(i);
+        float transform[4];
+        atlas.TileTransform(i, transform);
+        // -- the tile's uv corners land on its texel corners
+        CHECK(transform[2] * atlas.Width() == float(tile.x));
+        CHECK(transform[3] * atlas.Height() == float(tile.y));
+        CHECK((transform[0] + transform[2]) * atlas.Width() == float(tile.x + tile.width));
+        CHECK((transform[1] + transform[3]) * atlas.Height() == float(tile.y + tile.height));
+    }
+}
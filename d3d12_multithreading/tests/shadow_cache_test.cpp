@@ -0,0 +1,84 @@
+#include "stdafx.h"
+#include "test.h"
+#include "shadow_cache.h"
+
+static UINT const AllLights = (1u << NumLights) - 1;
+
+TEST(shadow_cache, disabled_draws_every_light) {
+    ShadowCache cache;
+    cache.Init(false, 1);
+    CHECK(!cache.Enabled());
+    for (UINT frame = 0; frame < 4; ++frame)
+        CHECK(AllLights == cache.Schedule());
+    CHECK(double(NumLights) == cache.TakeDrawnAverage());
+    // -- the average starts over
+    CHECK(0.0 == cache.TakeDrawnAverage());
+}
+
+TEST(shadow_cache, still_lights_are_drawn_once) {
+    ShadowCache cache;
+    cache.Init(true, 0);
+    // -- every tile starts stale
+    CHECK(AllLights == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+    // -- only what moved, however often it moved
+    cache.Moved(1);
+    cache.Moved(1);
+    CHECK(1u << 1 == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+    CHECK(double(NumLights + 1) / 5 == cache.TakeDrawnAverage());
+    // -- Init makes every tile stale again
+    cache.Init(true, 0);
+    CHECK(AllLights == cache.Schedule());
+}
+
+TEST(shadow_cache, first_frame_ignores_budget) {
+    ShadowCache cache;
+    cache.Init(true, 1);
+    // -- nothing drawn yet: every tile at once, the scene samples them all
+    CHECK(AllLights == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+    // -- the budget holds from then on
+    for (UINT light = 0; light < NumLights; ++light)
+        cache.Moved(light);
+    CHECK(1u << 0 == cache.Schedule());
+    CHECK(1u << 1 == cache.Schedule());
+    // -- Init starts over with nothing drawn
+    cache.Init(true, 1);
+    CHECK(AllLights == cache.Schedule());
+    // -- frames with nothing stale do not use it up
+    cache.Init(true, 2);
+    CHECK(AllLights == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+    cache.Moved(0);
+    cache.Moved(1);
+    cache.Moved(2);
+    CHECK((1u << 0 | 1u << 1) == cache.Schedule());
+}
+
+TEST(shadow_cache, budget_round_robin) {
+    ShadowCache cache;
+    cache.Init(true, 1);
+    CHECK(AllLights == cache.Schedule());
+    // -- one light a frame, in order
+    for (UINT light = 0; light < NumLights; ++light)
+        cache.Moved(light);
+    UINT seen = 0;
+    for (UINT frame = 0; frame < NumLights; ++frame) {
+        UINT const scheduled = cache.Schedule();
+        CHECK(1u << frame == scheduled);
+        seen |= scheduled;
+    }
+    CHECK(AllLights == seen);
+    CHECK(0 == cache.Schedule());
+    // -- a light moving every frame does not starve the others
+    cache.Moved(0);
+    cache.Moved(2);
+    CHECK(1u << 0 == cache.Schedule());
+    cache.Moved(0);
+    CHECK(1u << 2 == cache.Schedule());
+    cache.Moved(0);
+    CHECK(1u << 0 == cache.Schedule());
+    CHECK(0 == cache.Schedule());
+}
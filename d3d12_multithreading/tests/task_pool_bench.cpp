@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "bench.h"
+#include "test.h"
+#include "asset_cooker.h"
+#include "fast_copy.h"
+#include "task_pool.h"
+
+// NOTE(omid): Texture staging at startup against the load thread count
+/*
+    The copy half of LoadTextures over the room's texture table, one job
+    per texture as in the sample: a pack in upload layout streams each
+    texture whole, otherwise rows go from the tight source pitch to the
+    256 byte upload pitch. Upload memory is plain cached memory here, not
+    a write-combined upload heap, so absolute numbers are optimistic.
+*/
+BENCH(load_threads) {
+    UINT const count = static_cast<UINT>(ArrayCount(SampleAssets::Textures));
+    UINT64 texel_size = 0;
+    for (UINT i = 0; i < count; ++i) {
+        SampleAssets::TextureResource const & tex = SampleAssets::Textures[i];
+        for (UINT m = 0; m < tex.MipLevels; ++m)
+            texel_size = std::max<UINT64>(texel_size, UINT64(tex.Data[m].Offset) + tex.Data[m].Size);
+    }
+    std::vector<UINT8> texels(static_cast<size_t>(texel_size));
+    TestRandom random(36);
+    for (UINT8 & texel : texels)
+        texel = static_cast<UINT8>(random.Next());
+    std::vector<SampleAssets::TextureResource> layout(
+        SampleAssets::Textures, SampleAssets::Textures + count
+    );
+    std::vector<UINT8> layout_data;
+    if (FAILED(LayoutTexturesForUpload(texels.data(), layout.data(), count, &layout_data)))
+        return;
+    std::vector<UINT8> upload(layout_data.size(), 0);
+    double const mib = texel_size / (1024.0 * 1024.0);
+
+    // -- past the core count too, the sample defaults to one per core
+    std::vector<UINT> thread_counts = {1, 2, 4, 8};
+    UINT const cores = std::max(std::thread::hardware_concurrency(), 1u);
+    if (std::find(thread_counts.begin(), thread_counts.end(), cores) == thread_counts.end())
+        thread_counts.push_back(cores);
+    std::sort(thread_counts.begin(), thread_counts.end());
+
+    printf("%u textures, %.1f MiB, %u cores\n", count, mib, cores);
+    printf("threads   whole ms  GiB/s speedup    rows ms  GiB/s speedup\n");
+    double whole_base = 0.0;
+    double rows_base = 0.0;
+    for (UINT threads : thread_counts) {
+        TaskPool pool;
+        pool.Init(threads);
+        double const whole = BenchBest(9, [&] {
+            pool.ParallelFor(count, [&] (UINT i) {
+                SampleAssets::TextureResource const & tex = layout[i];
+                UINT const last = tex.MipLevels - 1;
+                StreamCopy(
+                    upload.data() + tex.Data[0].Offset,
+                    layout_data.data() + tex.Data[0].Offset,
+                    tex.Data[last].Offset + tex.Data[last].Size - tex.Data[0].Offset
+                );
+            });
+        });
+        double const rows = BenchBest(9, [&] {
+            pool.ParallelFor(count, [&] (UINT i) {
+                SampleAssets::TextureResource const & src = SampleAssets::Textures[i];
+                SampleAssets::TextureResource const & dst = layout[i];
+                for (UINT m = 0; m < src.MipLevels; ++m)
+                    CopyRows(
+                        upload.data() + dst.Data[m].Offset, dst.Data[m].Pitch,
+                        texels.data() + src.Data[m].Offset, src.Data[m].Pitch,
+                        src.Data[m].Pitch, src.Data[m].Size / src.Data[m].Pitch
+                    );
+            });
+        });
+        if (1 == threads) {
+            whole_base = whole;
+            rows_base = rows;
+        }
+        printf(
+            "%7u %10.3f %6.2f %6.2fx %10.3f %6.2f %6.2fx\n",
+            threads,
+            whole, mib / 1024.0 / (whole / 1000.0), whole_base / whole,
+            rows, mib / 1024.0 / (rows / 1000.0), rows_base / rows
+        );
+        pool.Release();
+    }
+    BenchSink = BenchSink + upload[upload.size() / 2];
+}
@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "test.h"
+#include "task_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+TEST(task_pool, every_job_runs_once) {
+    for (UINT threads = 1; threads <= 8; ++threads) {
+        TaskPool pool;
+        pool.Init(threads);
+        CHECK(threads == pool.ThreadCount());
+        std::vector<std::atomic<UINT>> runs(257);
+        for (UINT round = 0; round < 500; ++round) {
+            UINT const count = 1 + (round * 37) % 257;
+            for (UINT i = 0; i < count; ++i)
+                runs[i] = 0;
+            pool.ParallelFor(count, [&] (UINT job) {
+                runs[job].fetch_add(1);
+            });
+            // -- every job finished by the time ParallelFor returns
+            bool once = true;
+            for (UINT i = 0; i < count; ++i)
+                once = once && 1 == runs[i];
+            CHECK(once);
+        }
+        pool.Release();
+    }
+}
+
+TEST(task_pool, jobs_spread_over_threads) {
+    TaskPool pool;
+    pool.Init(4);
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    std::atomic<UINT> inside(0);
+    std::atomic<UINT> most_inside(0);
+    pool.ParallelFor(64, [&] (UINT) {
+        UINT const now = inside.fetch_add(1) + 1;
+        UINT seen = most_inside;
+        while (now > seen && !most_inside.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        inside.fetch_sub(1);
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+    });
+    // -- the caller pitches in, and never more than the pool's threads run
+    CHECK(ids.size() > 1 && ids.size() <= 4);
+    CHECK(most_inside <= 4);
+    CHECK(ids.count(std::this_thread::get_id()) == 1);
+}
+
+TEST(task_pool, edge_cases) {
+    TaskPool pool;
+    // -- no workers yet: the caller runs everything
+    UINT runs = 0;
+    pool.ParallelFor(10, [&] (UINT) { ++runs; });
+    CHECK(10 == runs && 1 == pool.ThreadCount());
+    // -- nothing to do returns at once
+    pool.Init(3);
+    pool.ParallelFor(0, [&] (UINT) { ++runs; });
+    CHECK(10 == runs);
+    // -- 0 threads means one per core
+    pool.Init(0);
+    CHECK(std::max(std::thread::hardware_concurrency(), 1u) == pool.ThreadCount());
+    // -- released and initialized again
+    pool.Release();
+    pool.Init(2);
+    std::atomic<UINT> sum(0);
+    pool.ParallelFor(100, [&] (UINT job) { sum += job; });
+    CHECK(4950 == sum);
+}
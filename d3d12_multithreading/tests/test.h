@@ -0,0 +1,61 @@
+#pragma once
+
+// NOTE(omid): Minimal registry for the cpu module tests
+/*
+    TEST(suite, name) defines and registers a test, CHECK records a
+    failure and carries on, REQUIRE gives up on the test. odx_tests runs
+    every test, or only the suites named on its command line (ctest runs
+    one suite per entry, see CMakeLists.txt).
+*/
+
+#include <cstdio>
+
+struct TestCase {
+    char const * suite;
+    char const * name;
+    void (*run) ();
+    TestCase * next;
+};
+
+struct TestRegistrar {
+    TestRegistrar (TestCase * test);
+};
+
+// -- failures of the running test
+extern int TestFailures;
+bool TestFailed (char const * file, int line, char const * expression);
+
+#define TEST(suite, name) \
+    static void suite##_##name (); \
+    static TestCase suite##_##name##_case = { #suite, #name, suite##_##name, nullptr }; \
+    static TestRegistrar suite##_##name##_registrar (&suite##_##name##_case); \
+    static void suite##_##name ()
+
+#define CHECK(expression) \
+    ((expression) ? true : TestFailed(__FILE__, __LINE__, #expression))
+
+#define REQUIRE(expression) \
+    do { if (!CHECK(expression)) return; } while (false)
+
+//
+// -- deterministic pseudo random numbers (xorshift64*)
+struct TestRandom {
+private:
+    unsigned long long state_;
+public:
+    explicit TestRandom (unsigned long long seed) : state_(seed ? seed : 1) {}
+    unsigned long long Next () {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 0x2545F4914F6CDD1Dull;
+    }
+    // -- in [0, range)
+    unsigned Below (unsigned range) {
+        return static_cast<unsigned>(Next() % range);
+    }
+    // -- in [0, 1)
+    float Unit () {
+        return (Next() >> 40) / float(1ull << 24);
+    }
+};
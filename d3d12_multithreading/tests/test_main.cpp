@@ -0,0 +1,49 @@
+#include "stdafx.h"
+#include "test.h"
+
+static TestCase * test_list = nullptr;
+static TestCase ** test_list_end = &test_list;
+
+int TestFailures = 0;
+LONGLONG TestPerformanceCounter = 0;
+
+TestRegistrar::TestRegistrar (TestCase * test) {
+    // -- keep the order the tests are defined in
+    *test_list_end = test;
+    test_list_end = &test->next;
+}
+bool TestFailed (char const * file, int line, char const * expression) {
+    fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+    ++TestFailures;
+    return false;
+}
+
+static bool Selected (TestCase const * test, int argc, char ** argv) {
+    if (argc < 2)
+        return true;
+    for (int i = 1; i < argc; ++i)
+        if (0 == strcmp(argv[i], test->suite))
+            return true;
+    return false;
+}
+
+int main (int argc, char ** argv) {
+    int run = 0;
+    int failed = 0;
+    for (TestCase * test = test_list; test; test = test->next) {
+        if (!Selected(test, argc, argv))
+            continue;
+        TestFailures = 0;
+        test->run();
+        ++run;
+        if (TestFailures > 0) {
+            ++failed;
+            printf("FAILED  %s.%s (%d)\n", test->suite, test->name, TestFailures);
+        } else {
+            printf("ok      %s.%s\n", test->suite, test->name);
+        }
+    }
+    printf("%d tests, %d failed\n", run, failed);
+    // -- a suite that matched nothing is a typo, not a pass
+    return (0 == run || failed > 0) ? 1 : 0;
+}
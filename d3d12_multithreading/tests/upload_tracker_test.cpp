@@ -0,0 +1,150 @@
+#include "stdafx.h"
+#include "test.h"
+#include "upload_tracker.h"
+
+// NOTE(omid): Mock of the two queues UploadTracker sits between
+/*
+    The copy queue signals its fence with increasing tickets, completing
+    them some time later. The graphics queue executes in submission
+    order, so a Wait holds back everything submitted after it: work is
+    safe when every resource it reads has a ticket at or under the
+    largest value waited on so far, or under what had completed when it
+    was submitted.
+*/
+struct MockCopyQueue {
+    UINT64 signaled = 0;
+    UINT64 completed = 0;
+
+    UINT64 Upload () { return ++signaled; }
+    void Complete (UINT64 value) { completed = std::max(completed, std::min(value, signaled)); }
+};
+struct MockGraphicsQueue {
+    MockCopyQueue const * copy = nullptr;
+    UINT64 waited = 0;
+    UINT waits = 0;
+
+    void Wait (UINT64 value) {
+        // -- waits land in ticket order
+        CHECK(value > waited);
+        waited = value;
+        ++waits;
+    }
+    // -- tickets of the resources read by the submitted work
+    bool Safe (std::vector<UINT64> const & tickets) const {
+        for (UINT64 ticket : tickets)
+            if (ticket > waited && ticket > copy->completed)
+                return false;
+        return true;
+    }
+};
+
+static UINT64 RequireAndWait (
+    UploadTracker & tracker,
+    MockGraphicsQueue & graphics,
+    std::vector<UINT> const & resources
+) {
+    UINT64 const wait = tracker.Require(resources.data(), static_cast<UINT>(resources.size()));
+    if (0 != wait)
+        graphics.Wait(wait);
+    return wait;
+}
+
+TEST(upload_tracker, ready) {
+    MockCopyQueue copy;
+    UploadTracker tracker;
+    tracker.Init(3);
+    // -- untracked resources need no upload
+    CHECK(tracker.Ready(0) && tracker.AllReady());
+    tracker.Track(0, copy.Upload());
+    tracker.Track(1, copy.Upload());
+    CHECK(!tracker.Ready(0) && !tracker.Ready(1) && tracker.Ready(2));
+    CHECK(!tracker.AllReady());
+    tracker.Update(1);
+    CHECK(tracker.Ready(0) && !tracker.Ready(1) && !tracker.AllReady());
+    // -- stale completed values never go back
+    tracker.Update(0);
+    CHECK(tracker.Ready(0));
+    tracker.Update(2);
+    CHECK(tracker.AllReady());
+    // -- a new upload of the same resource makes it pending again
+    tracker.Track(1, copy.Upload());
+    CHECK(!tracker.Ready(1));
+}
+
+TEST(upload_tracker, require_short_circuits) {
+    MockCopyQueue copy;
+    MockGraphicsQueue graphics;
+    graphics.copy = &copy;
+    UploadTracker tracker;
+    tracker.Init(4);
+    UINT64 const tickets [] = {copy.Upload(), copy.Upload(), copy.Upload(), copy.Upload()};
+    for (UINT i = 0; i < 4; ++i)
+        tracker.Track(i, tickets[i]);
+
+    // -- the largest ticket of the set
+    CHECK(tickets[2] == RequireAndWait(tracker, graphics, {0, 2}));
+    // -- already covered by the wait on tickets[2]
+    CHECK(0 == RequireAndWait(tracker, graphics, {0}));
+    CHECK(0 == RequireAndWait(tracker, graphics, {1, 2}));
+    // -- a larger ticket needs a new wait
+    CHECK(tickets[3] == RequireAndWait(tracker, graphics, {1, 3}));
+    CHECK(2 == graphics.waits);
+    // -- nothing at all: no wait
+    CHECK(0 == tracker.Require(nullptr, 0));
+
+    // -- completed on the cpu: no wait, even for never waited tickets
+    tracker.Init(2);
+    graphics.waited = 0;
+    tracker.Track(0, copy.Upload());
+    tracker.Track(1, copy.Upload());
+    copy.Complete(copy.signaled);
+    tracker.Update(copy.completed);
+    CHECK(0 == RequireAndWait(tracker, graphics, {0, 1}));
+    CHECK(0 == graphics.waited);
+}
+
+TEST(upload_tracker, mock_queues) {
+    TestRandom random(35);
+    MockCopyQueue copy;
+    MockGraphicsQueue graphics;
+    graphics.copy = &copy;
+    UINT const resource_count = 64;
+    UploadTracker tracker;
+    tracker.Init(resource_count);
+    std::vector<UINT64> tickets(resource_count, 0);
+    UINT submissions = 0;
+    UINT skipped = 0;
+    for (UINT frame = 0; frame < 20000; ++frame) {
+        // -- a few uploads (re-uploads included) per frame
+        UINT const uploads = random.Below(4);
+        for (UINT i = 0; i < uploads; ++i) {
+            UINT const resource = random.Below(resource_count);
+            tickets[resource] = copy.Upload();
+            tracker.Track(resource, tickets[resource]);
+        }
+        // -- the copy queue completes some of them, read once per frame
+        if (random.Below(3) == 0)
+            copy.Complete(copy.completed + random.Below(6));
+        tracker.Update(copy.completed);
+        // -- a couple of submissions, each reading a few resources
+        UINT const count = 1 + random.Below(3);
+        for (UINT s = 0; s < count; ++s) {
+            std::vector<UINT> resources(1 + random.Below(5));
+            std::vector<UINT64> reads;
+            for (UINT & resource : resources) {
+                resource = random.Below(resource_count);
+                reads.push_back(tickets[resource]);
+            }
+            if (0 == RequireAndWait(tracker, graphics, resources))
+                ++skipped;
+            CHECK(graphics.Safe(reads));
+            ++submissions;
+        }
+        // -- Ready agrees with the copy queue
+        UINT const resource = random.Below(resource_count);
+        CHECK(tracker.Ready(resource) == (tickets[resource] <= copy.completed));
+    }
+    // -- the short-circuits actually happen
+    CHECK(skipped > submissions / 2);
+    CHECK(graphics.waits + skipped == submissions);
+}
@@ -0,0 +1,234 @@
+#include "stdafx.h"
+#include "test.h"
+#include "vertex_compression.h"
+
+#include <limits>
+
+// NOTE(omid): Error bounds of the compressed vertex layout
+/*
+    position    half a 16-bit unorm step of the draw's extent, per axis
+    normal      octahedral snorm16: under 1e-4 radians
+    uv          half float: a relative 2^-11 (plus half the smallest
+                subnormal near zero)
+*/
+static constexpr double PositionSteps = 65535.0;
+static constexpr double MaxOctAngle = 1e-4;
+static constexpr double HalfRelativeError = 1.0 / 2048.0;
+static constexpr double HalfAbsoluteError = 1.0 / (1 << 25);
+
+static void RandomDirection (TestRandom & random, float out[3]) {
+    float length = 0.0f;
+    do {
+        for (int c = 0; c < 3; ++c)
+            out[c] = 2.0f * random.Unit() - 1.0f;
+        length = sqrtf(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+    } while (length < 0.01f || length > 1.0f);
+    for (int c = 0; c < 3; ++c)
+        out[c] /= length;
+}
+// -- angle between two directions, in double (1 - cos is lost in float)
+static double Angle (float const a[3], float const b[3]) {
+    double const cross[3] = {
+        double(a[1]) * b[2] - double(a[2]) * b[1],
+        double(a[2]) * b[0] - double(a[0]) * b[2],
+        double(a[0]) * b[1] - double(a[1]) * b[0],
+    };
+    double const dot = double(a[0]) * b[0] + double(a[1]) * b[1] + double(a[2]) * b[2];
+    return atan2(sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+}
+static bool UvWithinBound (float original, UINT16 half) {
+    double const error = fabs(double(HalfToFloat(half)) - original);
+    return error <= fabs(original) * HalfRelativeError + HalfAbsoluteError;
+}
+
+TEST(vertex_compression, mesh_error_bounds) {
+    TestRandom random(27);
+    UINT const vertex_count = 900;
+    std::vector<StandardVertex> vertices(vertex_count);
+    for (UINT v = 0; v < vertex_count; ++v) {
+        StandardVertex & vertex = vertices[v];
+        // -- each third of the buffer at its own place and size
+        float const size = v < 300 ? 0.25f : v < 600 ? 40.0f : 3000.0f;
+        float const center = v < 300 ? -5.0f : v < 600 ? 100.0f : 0.0f;
+        for (int c = 0; c < 3; ++c)
+            vertex.position[c] = center + size * (2.0f * random.Unit() - 1.0f);
+        RandomDirection(random, vertex.normal);
+        RandomDirection(random, vertex.tangent);
+        // -- tiled uvs well past [0, 1], and some negative
+        vertex.uv[0] = 16.0f * random.Unit() - 4.0f;
+        vertex.uv[1] = random.Unit() * random.Unit();
+    }
+    // -- the last third is flat along y (a degenerate extent)
+    for (UINT v = 600; v < vertex_count; ++v)
+        vertices[v].position[1] = 2.5f;
+
+    // -- draws 0 and 1 overlap and share bounds, 2 and 3 stand alone,
+    // -- 4 is empty
+    std::vector<UINT> indices;
+    std::vector<PackDraw> draws(5, PackDraw {});
+    UINT const ranges [][2] = {{0, 200}, {150, 300}, {300, 600}, {600, 900}, {0, 0}};
+    for (UINT d = 0; d < draws.size(); ++d) {
+        draws[d].index_start = static_cast<UINT>(indices.size());
+        draws[d].index_format = DXGI_FORMAT_R32_UINT;
+        for (UINT v = ranges[d][0]; v < ranges[d][1]; ++v)
+            indices.push_back(v);
+        draws[d].index_count = static_cast<UINT>(indices.size()) - draws[d].index_start;
+    }
+
+    std::vector<CompressedVertex> compressed;
+    CompressVertices(
+        vertices.data(), vertex_count, indices.data(),
+        draws.data(), static_cast<UINT>(draws.size()), &compressed
+    );
+    REQUIRE(compressed.size() == vertex_count);
+    // -- overlapping draws decode with the same offset and scale
+    CHECK(0 == memcmp(draws[0].position_offset, draws[1].position_offset, sizeof(float) * 3));
+    CHECK(0 == memcmp(draws[0].position_scale, draws[1].position_scale, sizeof(float) * 3));
+
+    double max_angle = 0.0;
+    for (UINT d = 0; d < 4; ++d) {
+        PackDraw const & draw = draws[d];
+        for (UINT v = ranges[d][0]; v < ranges[d][1]; ++v) {
+            StandardVertex const & src = vertices[v];
+            CompressedVertex const & dst = compressed[v];
+            CHECK(0 == dst.position[3]);
+            for (int c = 0; c < 3; ++c) {
+                double const decoded =
+                    draw.position_offset[c] + dst.position[c] / PositionSteps * draw.position_scale[c];
+                // -- half a step, plus the float rounding of offset + unorm * scale
+                double const bound =
+                    0.5 * draw.position_scale[c] / PositionSteps +
+                    1e-6 * (fabs(draw.position_offset[c]) + draw.position_scale[c]);
+                CHECK(fabs(decoded - src.position[c]) <= bound);
+            }
+            float normal[3];
+            OctDecode(dst.normal, normal);
+            float tangent[3];
+            OctDecode(dst.tangent, tangent);
+            max_angle = std::max(max_angle, Angle(src.normal, normal));
+            max_angle = std::max(max_angle, Angle(src.tangent, tangent));
+            CHECK(UvWithinBound(src.uv[0], dst.uv[0]));
+            CHECK(UvWithinBound(src.uv[1], dst.uv[1]));
+        }
+    }
+    CHECK(max_angle <= MaxOctAngle);
+    // -- the flat axis decodes exactly
+    for (UINT v = 600; v < vertex_count; ++v)
+        CHECK(draws[3].position_offset[1] + compressed[v].position[1] / 65535.0f * draws[3].position_scale[1] == 2.5f);
+
+    // -- and the cooker's own measure agrees with the bounds
+    CompressionError const error = MeasureCompressionError(
+        vertices.data(), compressed.data(), vertex_count,
+        indices.data(), draws.data(), static_cast<UINT>(draws.size())
+    );
+    CHECK(error.position <= 0.5 * 6000.0 / PositionSteps * 1.01);
+    CHECK(error.normal <= 1.0 - cos(MaxOctAngle) + 1e-6);
+    CHECK(error.tangent <= 1.0 - cos(MaxOctAngle) + 1e-6);
+    CHECK(error.uv <= 12.0 * HalfRelativeError);
+}
+
+TEST(vertex_compression, octahedral_edges) {
+    // -- axes, diagonals and the folded (z < 0) octants
+    float const directions [][3] = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+        {0.577350f, 0.577350f, 0.577350f}, {-0.577350f, 0.577350f, -0.577350f},
+        {0.707107f, 0, -0.707107f}, {0, -0.707107f, -0.707107f},
+        {1e-4f, -1e-4f, -1.0f},
+    };
+    for (auto const & direction : directions) {
+        INT16 encoded[2];
+        OctEncode(direction, encoded);
+        float decoded[3];
+        OctDecode(encoded, decoded);
+        CHECK(Angle(direction, decoded) <= MaxOctAngle);
+        // -- decoded directions are unit length
+        float const length = sqrtf(decoded[0] * decoded[0] + decoded[1] * decoded[1] + decoded[2] * decoded[2]);
+        CHECK(fabsf(length - 1.0f) <= 1e-6f);
+    }
+    // -- a zero vector does not produce nans
+    float const zero[3] = {0, 0, 0};
+    INT16 encoded[2];
+    OctEncode(zero, encoded);
+    float decoded[3];
+    OctDecode(encoded, decoded);
+    CHECK(decoded[0] == decoded[0] && decoded[1] == decoded[1] && decoded[2] == decoded[2]);
+}
+
+TEST(vertex_compression, half_float) {
+    // -- every finite half survives a round trip through float
+    for (UINT h = 0; h <= 0xFFFF; ++h) {
+        if (0x7C00 == (h & 0x7C00))
+            continue;
+        UINT16 const half = static_cast<UINT16>(h);
+        CHECK(FloatToHalf(HalfToFloat(half)) == half);
+    }
+    // -- rounding is to nearest, ties to even
+    CHECK(0x3C00 == FloatToHalf(1.0f + 1.0f / 2048.0f));        // -- tie, down to even
+    CHECK(0x3C02 == FloatToHalf(1.0f + 3.0f / 2048.0f));        // -- tie, up to even
+    CHECK(0x3C01 == FloatToHalf(1.0f + 1.0f / 2048.0f + 1e-6f));
+    // -- a mantissa carry bumps the exponent
+    CHECK(0x4000 == FloatToHalf(1.9999f));
+    // -- out of range clamps to infinity, keeps the sign
+    CHECK(0x7C00 == FloatToHalf(70000.0f));
+    CHECK(0xFC00 == FloatToHalf(-70000.0f));
+    CHECK(0x7BFF == FloatToHalf(65504.0f));
+    // -- subnormals, and underflow to a signed zero
+    CHECK(0x0001 == FloatToHalf(ldexpf(1.0f, -24)));
+    CHECK(0x0000 == FloatToHalf(ldexpf(1.0f, -26)));
+    CHECK(0x8000 == FloatToHalf(-ldexpf(1.0f, -26)));
+    // -- nan stays nan
+    UINT16 const nan = FloatToHalf(std::numeric_limits<float>::quiet_NaN());
+    CHECK(0x7C00 == (nan & 0x7C00) && 0 != (nan & 0x3FF));
+    // -- the relative bound holds across the normal range
+    TestRandom random(2027);
+    for (UINT i = 0; i < 100000; ++i) {
+        float const value = ldexpf(2.0f * random.Unit() - 1.0f, static_cast<int>(random.Below(30)) - 14);
+        CHECK(UvWithinBound(value, FloatToHalf(value)));
+    }
+}
+
+TEST(vertex_compression, deinterleave_positions) {
+    TestRandom random(28);
+    // -- the stream holds the leading element of each vertex, tightly
+    // -- packed: R32G32B32_FLOAT or R16G16B16A16_UNORM
+    CHECK(12 == PositionStride(PackVertexStandard));
+    CHECK(8 == PositionStride(PackVertexCompressed));
+
+    UINT const vertex_count = 1001;
+    std::vector<StandardVertex> standard(vertex_count);
+    std::vector<CompressedVertex> compressed(vertex_count);
+    for (UINT v = 0; v < vertex_count; ++v) {
+        for (int c = 0; c < 3; ++c)
+            standard[v].position[c] = random.Unit();
+        standard[v].normal[0] = -1.0f;  // -- must not leak into the stream
+        for (int c = 0; c < 4; ++c)
+            compressed[v].position[c] = static_cast<UINT16>(random.Next());
+        compressed[v].normal[0] = -1;
+    }
+
+    UINT const standard_stride = PositionStride(PackVertexStandard);
+    // -- one extra element to catch a write past the stream
+    std::vector<UINT8> stream((vertex_count + 1) * standard_stride, 0xCD);
+    DeinterleavePositions(
+        reinterpret_cast<UINT8 const *>(standard.data()), vertex_count,
+        sizeof(StandardVertex), standard_stride, stream.data()
+    );
+    for (UINT v = 0; v < vertex_count; ++v)
+        CHECK(0 == memcmp(stream.data() + v * standard_stride, standard[v].position, standard_stride));
+    CHECK(0xCD == stream[vertex_count * standard_stride]);
+
+    UINT const compressed_stride = PositionStride(PackVertexCompressed);
+    stream.assign((vertex_count + 1) * compressed_stride, 0xCD);
+    DeinterleavePositions(
+        reinterpret_cast<UINT8 const *>(compressed.data()), vertex_count,
+        CompressedVertexStride, compressed_stride, stream.data()
+    );
+    for (UINT v = 0; v < vertex_count; ++v)
+        CHECK(0 == memcmp(stream.data() + v * compressed_stride, compressed[v].position, compressed_stride));
+    CHECK(0xCD == stream[vertex_count * compressed_stride]);
+
+    // -- an empty buffer writes nothing
+    stream.assign(4, 0xCD);
+    DeinterleavePositions(nullptr, 0, CompressedVertexStride, compressed_stride, stream.data());
+    CHECK(0xCD == stream[0]);
+}
@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "upload_ring.h"
+
+UploadRing::UploadRing () :
+    cpu_(nullptr)
+{
+}
+HRESULT UploadRing::Init (ID3D12Device * device, UINT64 size) {
+    Release();
+    HRESULT hr = device->CreateCommittedResource(
+        &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+        D3D12_HEAP_FLAG_NONE,
+        &CD3DX12_RESOURCE_DESC::Buffer(size),
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(&buffer_)
+    );
+    if (FAILED(hr))
+        return hr;
+    buffer_->SetName(L"upload_ring");
+
+    // -- stays mapped for the lifetime of the buffer
+    CD3DX12_RANGE read_range(0, 0);
+    hr = buffer_->Map(0, &read_range, reinterpret_cast<void **>(&cpu_));
+    if (FAILED(hr)) {
+        buffer_.Reset();
+        return hr;
+    }
+    ring_.Init(size);
+    return S_OK;
+}
+void UploadRing::Release () {
+    if (nullptr != buffer_)
+        buffer_->Unmap(0, nullptr);
+    buffer_.Reset();
+    cpu_ = nullptr;
+    ring_.Init(0);
+}
+bool UploadRing::Allocate (
+    UINT64 size,
+    UINT64 alignment,
+    UploadAllocation * allocation
+) {
+    UINT64 offset = 0;
+    if (!ring_.Allocate(size, alignment, &offset))
+        return false;
+    allocation->buffer = buffer_.Get();
+    allocation->offset = offset;
+    allocation->cpu = cpu_ + offset;
+    allocation->gpu = buffer_->GetGPUVirtualAddress() + offset;
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ring_allocator.h"
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): One persistently mapped upload buffer for all staging data
+/*
+    Startup copies and streamed data (the UploadService's copy batches)
+    are carved from the same ring. Per-frame dynamic data is not: the
+    constants live in each frame resource's FrameConstants buffer. Whoever
+    signals the queue commits the ring with that fence value, and the
+    space comes back once the fence has completed. Not thread safe,
+    allocate from the main thread only.
+*/
+
+static constexpr UINT64 UploadRingSize = 64ull * 1024 * 1024;
+
+struct UploadAllocation {
+    ID3D12Resource * buffer;
+    UINT64 offset;              // -- into buffer
+    UINT8 * cpu;                // -- write-combined, do not read back
+    D3D12_GPU_VIRTUAL_ADDRESS gpu;
+};
+
+struct UploadRing {
+private:
+    ComPtr<ID3D12Resource> buffer_;
+    UINT8 * cpu_;
+    RingAllocator ring_;
+public:
+    UploadRing ();
+
+    HRESULT Init (ID3D12Device * device, UINT64 size = UploadRingSize);
+    void Release ();
+
+    bool Allocate (UINT64 size, UINT64 alignment, UploadAllocation * allocation);
+    void Commit (UINT64 fence_value) { ring_.Commit(fence_value); }
+    void Retire (UINT64 completed_fence) { ring_.Retire(completed_fence); }
+
+    UINT64 Size () const { return ring_.Size(); }
+    UINT64 UsedSize () const { return ring_.UsedSize(); }
+    UINT64 PendingSize () const { return ring_.PendingSize(); }
+    UINT64 OldestFence () const { return ring_.OldestFence(); }
+};
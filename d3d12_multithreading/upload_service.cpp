@@ -0,0 +1,154 @@
+#include "stdafx.h"
+#include "upload_service.h"
+
+UploadService::UploadService () :
+    device_(nullptr),
+    fence_event_(nullptr),
+    next_fence_value_(1),
+    recording_(false)
+{
+}
+UploadService::~UploadService () {
+    Release();
+}
+HRESULT UploadService::Init (ID3D12Device * device, UINT64 ring_size) {
+    Release();
+    device_ = device;
+
+    D3D12_COMMAND_QUEUE_DESC queue_desc = {};
+    queue_desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+    queue_desc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    HRESULT hr = device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&queue_));
+    if (FAILED(hr))
+        return hr;
+    queue_->SetName(L"upload_queue");
+
+    next_fence_value_ = 1;
+    hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+    if (FAILED(hr))
+        return hr;
+    fence_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (nullptr == fence_event_)
+        return HRESULT_FROM_WIN32(GetLastError());
+
+    return ring_.Init(device, ring_size);
+}
+void UploadService::Release () {
+    if (nullptr != queue_ && nullptr != fence_) {
+        // -- nothing recorded should be lost, and nothing in flight freed
+        UINT64 ticket = 0;
+        Submit(&ticket);
+        WaitForTicket(next_fence_value_ - 1);
+    }
+    if (nullptr != fence_event_)
+        CloseHandle(fence_event_);
+    fence_event_ = nullptr;
+    ring_.Release();
+    cmdlist_.Reset();
+    allocators_.clear();
+    fence_.Reset();
+    queue_.Reset();
+    recording_ = false;
+}
+HRESULT UploadService::Open () {
+    if (recording_)
+        return S_OK;
+    // -- reuse the oldest allocator if its batch is done, else make one
+    ComPtr<ID3D12CommandAllocator> allocator;
+    if (
+        !allocators_.empty() &&
+        allocators_.front().fence_value <= fence_->GetCompletedValue()
+    ) {
+        allocator = allocators_.front().allocator;
+        allocators_.pop_front();
+        HRESULT const hr = allocator->Reset();
+        if (FAILED(hr))
+            return hr;
+    } else {
+        HRESULT const hr = device_->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator)
+        );
+        if (FAILED(hr))
+            return hr;
+    }
+    HRESULT hr = S_OK;
+    if (nullptr == cmdlist_) {
+        hr = device_->CreateCommandList(
+            0 /* node mask */,
+            D3D12_COMMAND_LIST_TYPE_COPY,
+            allocator.Get(),
+            nullptr,
+            IID_PPV_ARGS(&cmdlist_)
+        );
+        if (SUCCEEDED(hr))
+            cmdlist_->SetName(L"upload_cmdlist");
+    } else {
+        hr = cmdlist_->Reset(allocator.Get(), nullptr);
+    }
+    if (FAILED(hr))
+        return hr;
+    allocators_.push_back({allocator, next_fence_value_});
+    recording_ = true;
+    return S_OK;
+}
+HRESULT UploadService::Allocate (
+    UINT64 size,
+    UINT64 alignment,
+    UploadAllocation * allocation
+) {
+    while (!ring_.Allocate(size, alignment, allocation)) {
+        HRESULT hr = S_OK;
+        if (0 != ring_.OldestFence()) {
+            hr = WaitForTicket(ring_.OldestFence());
+            Update();
+        } else if (ring_.PendingSize() > 0) {
+            // -- the open batch alone fills the ring
+            UINT64 ticket = 0;
+            hr = Submit(&ticket);
+        } else {
+            hr = E_OUTOFMEMORY;     // -- larger than the whole ring
+        }
+        if (FAILED(hr))
+            return hr;
+    }
+    return S_OK;
+}
+HRESULT UploadService::Record (ID3D12GraphicsCommandList ** cmdlist) {
+    HRESULT const hr = Open();
+    if (FAILED(hr))
+        return hr;
+    *cmdlist = cmdlist_.Get();
+    return S_OK;
+}
+HRESULT UploadService::Submit (UINT64 * ticket) {
+    *ticket = 0;
+    if (!recording_)
+        return S_OK;
+    recording_ = false;
+    HRESULT hr = cmdlist_->Close();
+    if (FAILED(hr))
+        return hr;
+    ID3D12CommandList * cmdlists [] = {cmdlist_.Get()};
+    queue_->ExecuteCommandLists(ArrayCount(cmdlists), cmdlists);
+    hr = queue_->Signal(fence_.Get(), next_fence_value_);
+    if (FAILED(hr))
+        return hr;
+    ring_.Commit(next_fence_value_);
+    *ticket = next_fence_value_;
+    ++next_fence_value_;
+    return S_OK;
+}
+UINT64 UploadService::Update () {
+    UINT64 const completed = fence_->GetCompletedValue();
+    ring_.Retire(completed);
+    return completed;
+}
+HRESULT UploadService::WaitForTicket (UINT64 ticket) {
+    if (fence_->GetCompletedValue() >= ticket)
+        return S_OK;
+    HRESULT const hr = fence_->SetEventOnCompletion(ticket, fence_event_);
+    if (FAILED(hr))
+        return hr;
+    WaitForSingleObject(fence_event_, INFINITE);
+    return S_OK;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <deque>
+
+#include "upload_ring.h"
+
+using Microsoft::WRL::ComPtr;
+
+// NOTE(omid): Uploads on a dedicated copy queue
+/*
+    Copies are recorded into batches on a copy cmdlist, staged through the
+    service's own upload ring, and submitted with their own fence. Each
+    submission returns a ticket (the copy fence value it completes under),
+    the graphics queue waits on a ticket only when it actually uses what
+    was copied (see UploadTracker).
+
+    Destination resources should be created in the COMMON state: the copy
+    queue promotes them to COPY_DEST and they decay back to COMMON when the
+    batch completes, so the graphics queue can promote them again to any
+    read state without barriers.
+
+    Not thread safe, record and submit from the main thread only.
+*/
+
+// -- submit the open batch once this much has been staged into it
+static constexpr UINT64 UploadBatchSize = 16ull * 1024 * 1024;
+
+struct UploadService {
+private:
+    struct Allocator {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        UINT64 fence_value;     // -- last batch recorded with it
+    };
+    ID3D12Device * device_;
+    ComPtr<ID3D12CommandQueue> queue_;
+    ComPtr<ID3D12Fence> fence_;
+    HANDLE fence_event_;
+    UINT64 next_fence_value_;
+    std::deque<Allocator> allocators_;  // -- oldest submission first
+    ComPtr<ID3D12GraphicsCommandList> cmdlist_;
+    bool recording_;
+    UploadRing ring_;
+
+    HRESULT Open ();
+public:
+    UploadService ();
+    ~UploadService ();
+
+    HRESULT Init (ID3D12Device * device, UINT64 ring_size = UploadRingSize);
+    // -- waits for the queue to drain first
+    void Release ();
+
+    //
+    // -- staging memory, full ring submits the open batch and/or waits for
+    // -- older batches to retire (record the copy after allocating)
+    HRESULT Allocate (UINT64 size, UINT64 alignment, UploadAllocation * allocation);
+    // -- cmdlist of the open batch (opens one if needed)
+    HRESULT Record (ID3D12GraphicsCommandList ** cmdlist);
+    // -- ticket of the open batch, what was just recorded completes under it
+    UINT64 BatchTicket () const { return next_fence_value_; }
+    UINT64 BatchSize () const { return ring_.PendingSize(); }
+    //
+    // -- submit the open batch, returns its ticket (0 if nothing was recorded)
+    HRESULT Submit (UINT64 * ticket);
+    // -- retire finished batches, returns the completed copy fence value
+    UINT64 Update ();
+    // -- same, with a completed value read elsewhere (see FenceWaiter)
+    void Retire (UINT64 completed_fence) { ring_.Retire(completed_fence); }
+    HRESULT WaitForTicket (UINT64 ticket);
+
+    ID3D12Fence * Fence () const { return fence_.Get(); }
+};
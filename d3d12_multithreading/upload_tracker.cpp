@@ -0,0 +1,39 @@
+#include "stdafx.h"
+#include "upload_tracker.h"
+
+UploadTracker::UploadTracker () :
+    completed_(0), waited_(0)
+{
+}
+void UploadTracker::Init (UINT resource_count) {
+    tickets_.assign(resource_count, 0);
+    completed_ = 0;
+    waited_ = 0;
+}
+void UploadTracker::Track (UINT resource, UINT64 ticket) {
+    assert(resource < tickets_.size());
+    tickets_[resource] = ticket;
+}
+void UploadTracker::Update (UINT64 completed_fence) {
+    if (completed_fence > completed_)
+        completed_ = completed_fence;
+}
+bool UploadTracker::AllReady () const {
+    for (UINT64 ticket : tickets_)
+        if (ticket > completed_)
+            return false;
+    return true;
+}
+UINT64 UploadTracker::Require (UINT const * resources, UINT count) {
+    UINT64 needed = 0;
+    for (UINT i = 0; i < count; ++i) {
+        UINT64 const ticket = tickets_[resources[i]];
+        if (ticket > needed)
+            needed = ticket;
+    }
+    // -- queue waits are ordered, one on a larger value already covers this
+    if (needed <= completed_ || needed <= waited_)
+        return 0;
+    waited_ = needed;
+    return needed;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+// NOTE(omid): Which copy-queue uploads a graphics submission depends on
+/*
+    Every tracked resource remembers the copy fence value (ticket) its data
+    lands under. Before using resources, the graphics queue only needs to
+    wait for the largest ticket among them, and not even that if it already
+    waits on a larger value or the copy fence has passed it on the cpu.
+    Resources are small integer ids picked by the caller.
+*/
+
+struct UploadTracker {
+private:
+    std::vector<UINT64> tickets_;   // -- 0 means no upload pending
+    UINT64 completed_;              // -- copy fence value last seen complete
+    UINT64 waited_;                 // -- largest value graphics already waits on
+public:
+    UploadTracker ();
+
+    void Init (UINT resource_count);
+    void Track (UINT resource, UINT64 ticket);
+    // -- latest completed copy fence value, read once per frame
+    void Update (UINT64 completed_fence);
+
+    // -- data is resident, no wait needed at all
+    bool Ready (UINT resource) const { return tickets_[resource] <= completed_; }
+    bool AllReady () const;
+    //
+    // -- copy fence value to make the graphics queue wait on before it uses
+    // -- the given resources, 0 when no new wait is needed
+    // NOTE(omid): a nonzero result must be waited on (by the one graphics
+    // queue) before the next Require: results only grow, and later calls
+    // skip whatever that wait already covers.
+    UINT64 Require (UINT const * resources, UINT count);
+};
@@ -0,0 +1,225 @@
+#include "stdafx.h"
+#include "vertex_compression.h"
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+UINT16 FloatToHalf (float value) {
+    UINT bits;
+    memcpy(&bits, &value, sizeof(bits));
+    UINT const sign = (bits >> 16) & 0x8000;
+    UINT const float_exponent = (bits >> 23) & 0xFF;
+    UINT mantissa = bits & 0x7FFFFF;
+
+    if (0xFF == float_exponent)  // -- inf and nan
+        return static_cast<UINT16>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+    INT const exponent = static_cast<INT>(float_exponent) - 127 + 15;
+    if (exponent >= 31)         // -- too big, clamp to inf
+        return static_cast<UINT16>(sign | 0x7C00);
+    if (exponent <= 0) {        // -- subnormal half (or zero)
+        if (exponent < -10)
+            return static_cast<UINT16>(sign);
+        mantissa |= 0x800000;
+        UINT const shift = 14 - exponent;
+        UINT half = mantissa >> shift;
+        UINT const remainder = mantissa & ((1u << shift) - 1);
+        UINT const halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            ++half;
+        return static_cast<UINT16>(sign | half);
+    }
+    UINT half = sign | (exponent << 10) | (mantissa >> 13);
+    // -- round to nearest even, a carry correctly bumps the exponent
+    UINT const remainder = mantissa & 0x1FFF;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+    return static_cast<UINT16>(half);
+}
+float HalfToFloat (UINT16 value) {
+    UINT const sign = (value & 0x8000u) << 16;
+    UINT const exponent = (value >> 10) & 0x1F;
+    UINT const mantissa = value & 0x3FF;
+    UINT bits;
+    if (0 == exponent) {
+        float const magnitude = ldexpf(static_cast<float>(mantissa), -24);
+        return sign ? -magnitude : magnitude;
+    } else if (31 == exponent) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+static INT16 ToSnorm16 (float value) {
+    value = std::max(-1.0f, std::min(1.0f, value));
+    return static_cast<INT16>(lroundf(value * 32767.0f));
+}
+static float FromSnorm16 (INT16 value) {
+    // -- same rule the input assembler uses for SNORM
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+//
+// -- project onto the octahedron and unfold the lower half
+void OctEncode (float const n[3], INT16 out[2]) {
+    float const l1 = fabsf(n[0]) + fabsf(n[1]) + fabsf(n[2]);
+    float x = 0.0f;
+    float y = 0.0f;
+    if (l1 > 0.0f) {
+        x = n[0] / l1;
+        y = n[1] / l1;
+        if (n[2] < 0.0f) {
+            float const folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float const folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = folded_x;
+            y = folded_y;
+        }
+    }
+    out[0] = ToSnorm16(x);
+    out[1] = ToSnorm16(y);
+}
+// NOTE(omid): keep in sync with OctDecode in shaders.hlsl
+void OctDecode (INT16 const e[2], float out[3]) {
+    float x = FromSnorm16(e[0]);
+    float y = FromSnorm16(e[1]);
+    float const z = 1.0f - fabsf(x) - fabsf(y);
+    float const t = std::max(-z, 0.0f);
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float const length = sqrtf(x * x + y * y + z * z);
+    out[0] = x / length;
+    out[1] = y / length;
+    out[2] = z / length;
+}
+void CompressVertices (
+    StandardVertex const * vertices,
+    UINT vertex_count,
+    UINT const * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    std::vector<CompressedVertex> * out
+) {
+    out->assign(vertex_count, CompressedVertex {});
+    if (0 == vertex_count)
+        return;
+
+    // -- identity decode for empty draws
+    for (UINT i = 0; i < draw_count; ++i)
+        for (int c = 0; c < 3; ++c) {
+            draws[i].position_offset[c] = 0.0f;
+            draws[i].position_scale[c] = 1.0f;
+        }
+
+    // -- every group of overlapping draws shares one set of bounds
+    std::vector<VertexGroup> groups;
+    BuildVertexGroups(draws, draw_count, indices, vertex_count, &groups);
+    for (VertexGroup const & group : groups) {
+        UINT const group_first = group.first_vertex;
+        UINT const group_last = group.last_vertex;
+
+        float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+        float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+        for (UINT v = group_first; v <= group_last; ++v)
+            for (int c = 0; c < 3; ++c) {
+                lo[c] = std::min(lo[c], vertices[v].position[c]);
+                hi[c] = std::max(hi[c], vertices[v].position[c]);
+            }
+        float extent[3];
+        for (int c = 0; c < 3; ++c)
+            extent[c] = hi[c] > lo[c] ? hi[c] - lo[c] : 1.0f;
+
+        for (UINT d : group.draws) {
+            PackDraw & draw = draws[d];
+            for (int c = 0; c < 3; ++c) {
+                draw.position_offset[c] = lo[c];
+                draw.position_scale[c] = extent[c];
+            }
+        }
+        for (UINT v = group_first; v <= group_last; ++v) {
+            StandardVertex const & src = vertices[v];
+            CompressedVertex & dst = (*out)[v];
+            for (int c = 0; c < 3; ++c) {
+                float const unorm = std::max(0.0f, std::min(1.0f,
+                    (src.position[c] - lo[c]) / extent[c]
+                ));
+                dst.position[c] = static_cast<UINT16>(lroundf(unorm * 65535.0f));
+            }
+            dst.position[3] = 0;
+            OctEncode(src.normal, dst.normal);
+            OctEncode(src.tangent, dst.tangent);
+            dst.uv[0] = FloatToHalf(src.uv[0]);
+            dst.uv[1] = FloatToHalf(src.uv[1]);
+        }
+    }
+}
+UINT PositionStride (PackVertexFormat format) {
+    return PackVertexCompressed == format ?
+        sizeof(CompressedVertex::position) :
+        sizeof(StandardVertex::position);
+}
+void DeinterleavePositions (
+    UINT8 const * vertices,
+    UINT vertex_count,
+    UINT vertex_stride,
+    UINT position_stride,
+    UINT8 * dst
+) {
+    assert(position_stride <= vertex_stride);
+    for (UINT v = 0; v < vertex_count; ++v) {
+        memcpy(dst, vertices, position_stride);
+        vertices += vertex_stride;
+        dst += position_stride;
+    }
+}
+static float NormalError (float const original[3], float const decoded[3]) {
+    float const length = sqrtf(
+        original[0] * original[0] +
+        original[1] * original[1] +
+        original[2] * original[2]
+    );
+    if (0.0f == length)
+        return 0.0f;    // -- degenerate input, nothing to preserve
+    float const cos_angle = (
+        original[0] * decoded[0] +
+        original[1] * decoded[1] +
+        original[2] * decoded[2]
+    ) / length;
+    return 1.0f - cos_angle;
+}
+CompressionError MeasureCompressionError (
+    StandardVertex const * vertices,
+    CompressedVertex const * compressed,
+    UINT vertex_count,
+    UINT const * indices,
+    PackDraw const * draws,
+    UINT draw_count
+) {
+    CompressionError error = {};
+    for (UINT i = 0; i < draw_count; ++i) {
+        UINT first, last;
+        if (!DrawVertexRange(draws[i], indices, vertex_count, &first, &last))
+            continue;
+        for (UINT v = first; v <= last; ++v) {
+            StandardVertex const & src = vertices[v];
+            CompressedVertex const & dst = compressed[v];
+            for (int c = 0; c < 3; ++c) {
+                float const decoded =
+                    draws[i].position_offset[c] +
+                    (dst.position[c] / 65535.0f) * draws[i].position_scale[c];
+                error.position = std::max(error.position, fabsf(decoded - src.position[c]));
+            }
+            float decoded_normal[3];
+            OctDecode(dst.normal, decoded_normal);
+            error.normal = std::max(error.normal, NormalError(src.normal, decoded_normal));
+            float decoded_tangent[3];
+            OctDecode(dst.tangent, decoded_tangent);
+            error.tangent = std::max(error.tangent, NormalError(src.tangent, decoded_tangent));
+            for (int c = 0; c < 2; ++c)
+                error.uv = std::max(error.uv, fabsf(HalfToFloat(dst.uv[c]) - src.uv[c]));
+        }
+    }
+    return error;
+}
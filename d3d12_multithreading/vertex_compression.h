@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+
+#include "asset_pack.h"
+
+// NOTE(omid): Compressed vertex layout (20 bytes instead of 44)
+/*
+    POSITION    R16G16B16A16_UNORM  quantized inside the draw's bounds
+    NORMAL      R16G16_SNORM        octahedral encoded
+    TEXCOORD    R16G16_FLOAT        half float
+    TANGENT     R16G16_SNORM        octahedral encoded
+
+    Positions are decoded in VSMain as offset + unorm * scale, where
+    offset/scale are per-draw root constants taken from PackDraw.
+*/
+
+struct StandardVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float tangent[3];
+};
+static_assert(sizeof(StandardVertex) == 44, "must match StandardVertexStride");
+
+struct CompressedVertex {
+    UINT16 position[4];     // -- w is padding
+    INT16 normal[2];
+    UINT16 uv[2];
+    INT16 tangent[2];
+};
+static_assert(sizeof(CompressedVertex) == 20, "must match the input layout");
+
+static constexpr UINT CompressedVertexStride = sizeof(CompressedVertex);
+
+D3D12_INPUT_ELEMENT_DESC const CompressedVertexDescription [] = {
+    {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+    {"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+    {"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+    {"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+};
+
+// -- position-only layouts for depth-only passes (one tightly packed stream)
+D3D12_INPUT_ELEMENT_DESC const StandardPositionDescription [] = {
+    {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+};
+D3D12_INPUT_ELEMENT_DESC const CompressedPositionDescription [] = {
+    {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+};
+
+// -- worst case decode error over a whole vertex buffer
+struct CompressionError {
+    float position;     // -- in model space units
+    float normal;       // -- 1 - cos(angle) between original and decoded
+    float tangent;
+    float uv;
+};
+
+UINT16 FloatToHalf (float value);
+float HalfToFloat (UINT16 value);
+
+void OctEncode (float const n[3], INT16 out[2]);
+void OctDecode (INT16 const e[2], float out[3]);
+
+//
+// -- quantize standard vertices into the compressed layout
+// NOTE(omid): draws whose vertex ranges overlap share the same bounds,
+// so every vertex is encoded exactly once. Per-draw offset/scale end up
+// in the draws' position_offset/position_scale.
+void CompressVertices (
+    StandardVertex const * vertices,
+    UINT vertex_count,
+    UINT const * indices,
+    PackDraw * draws,
+    UINT draw_count,
+    std::vector<CompressedVertex> * out
+);
+
+// -- size of the position element (which leads every vertex)
+UINT PositionStride (PackVertexFormat format);
+
+//
+// -- gather the leading position element of each interleaved vertex
+// -- into a tightly packed stream (dst holds count * position_stride bytes)
+void DeinterleavePositions (
+    UINT8 const * vertices,
+    UINT vertex_count,
+    UINT vertex_stride,
+    UINT position_stride,
+    UINT8 * dst
+);
+
+CompressionError MeasureCompressionError (
+    StandardVertex const * vertices,
+    CompressedVertex const * compressed,
+    UINT vertex_count,
+    UINT const * indices,
+    PackDraw const * draws,
+    UINT draw_count
+);